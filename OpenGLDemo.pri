@@ -0,0 +1,140 @@
+# Everything but main.cpp, shared by the application and the tests
+
+CONFIG += c++14
+
+INCLUDEPATH += $$PWD
+
+QT += core gui opengl widgets network concurrent
+
+# qmake CONFIG+=native: AVX/FMA Math3D kernels for the build machine
+native: QMAKE_CXXFLAGS += -march=native
+
+SOURCES += $$PWD/mainwindow.cpp \
+    $$PWD/gl_widget.cpp \
+    $$PWD/gl_lang_compiler.cpp \
+    $$PWD/gl_lang_runner.cpp \
+    $$PWD/camera.cpp \
+    $$PWD/project.cpp \
+    $$PWD/codeeditor.cpp \
+    $$PWD/highlight.cpp \
+    $$PWD/newdialog.cpp \
+    $$PWD/imagestore.cpp \
+    $$PWD/modelstore.cpp \
+    $$PWD/fpscontrol.cpp \
+    $$PWD/scope.cpp \
+    $$PWD/textfilestore.cpp \
+    $$PWD/depthzoom.cpp \
+    $$PWD/gl_lang_completer.cpp \
+    $$PWD/gl_lang_parser_interface.cpp \
+    $$PWD/triangleoptimizer.cpp \
+    $$PWD/patcher.cpp \
+    $$PWD/bezierpatcher.cpp \
+    $$PWD/statement.cpp \
+    $$PWD/value.cpp \
+    $$PWD/type.cpp \
+    $$PWD/projectfolder.cpp \
+    $$PWD/texturestore.cpp \
+    $$PWD/downloader.cpp \
+    $$PWD/videoencoder.cpp \
+    $$PWD/datasource.cpp \
+    $$PWD/gl_backend.cpp \
+    $$PWD/benchmark.cpp \
+    $$PWD/commandbuffer.cpp \
+    $$PWD/batchmath.cpp \
+    $$PWD/objreader.cpp \
+    $$PWD/meshoptimizer.cpp \
+    $$PWD/bufferheap.cpp
+
+HEADERS  += $$PWD/mainwindow.h \
+    $$PWD/math3d.h \
+    $$PWD/gl_functions.h \
+    $$PWD/constant.h \
+    $$PWD/function.h \
+    $$PWD/symbol.h \
+    $$PWD/variable.h \
+    $$PWD/gl_widget.h \
+    $$PWD/gl_lang_compiler.h \
+    $$PWD/gl_lang_runner.h \
+    $$PWD/blob.h \
+    $$PWD/camera.h \
+    $$PWD/project.h \
+    $$PWD/codeeditor.h \
+    $$PWD/highlight.h \
+    $$PWD/newdialog.h \
+    $$PWD/texblob.h \
+    $$PWD/imagestore.h \
+    $$PWD/modelstore.h \
+    $$PWD/fpscontrol.h \
+    $$PWD/scope.h \
+    $$PWD/textfilestore.h \
+    $$PWD/depthzoom.h \
+    $$PWD/gl_lang_completer.h \
+    $$PWD/gl_lang_parser_interface.h \
+    $$PWD/triangleoptimizer.h \
+    $$PWD/patcher.h \
+    $$PWD/bezierpatcher.h \
+    $$PWD/statement.h \
+    $$PWD/operation.h \
+    $$PWD/type.h \
+    $$PWD/typedef.h \
+    $$PWD/value.h \
+    $$PWD/projectfolder.h \
+    $$PWD/texturestore.h \
+    $$PWD/downloader.h \
+    $$PWD/videoencoder.h \
+    $$PWD/logging.h \
+    $$PWD/datasource.h \
+    $$PWD/gl_backend.h \
+    $$PWD/benchmark.h \
+    $$PWD/commandbuffer.h \
+    $$PWD/random.h \
+    $$PWD/batchmath.h \
+    $$PWD/objreader.h \
+    $$PWD/indextable.h \
+    $$PWD/meshoptimizer.h \
+    $$PWD/bufferheap.h
+
+FORMS    += $$PWD/mainwindow.ui \
+    $$PWD/newdialog.ui \
+    $$PWD/fpscontrol.ui \
+    $$PWD/depthzoom.ui
+
+
+DEFINES += YYERROR_VERBOSE QT_STATICPLUGIN
+
+
+MY_BISON_SOURCES = $$PWD/wavefront_parser.y $$PWD/gl_lang_parser.y
+
+my_bison_src.commands = bison ${QMAKE_FILE_IN} -o ${QMAKE_FILE_BASE}.cpp
+my_bison_src.input = MY_BISON_SOURCES
+my_bison_src.output = ${QMAKE_FILE_BASE}.cpp
+my_bison_src.variable_out = SOURCES
+my_bison_src.CONFIG += target_predeps
+
+my_bison_hdr.commands = bison --defines=${QMAKE_FILE_BASE}.h ${QMAKE_FILE_IN} && rm ${QMAKE_FILE_BASE}.tab.c
+my_bison_hdr.input = MY_BISON_SOURCES
+my_bison_hdr.output = ${QMAKE_FILE_BASE}.h
+my_bison_hdr.variable_out = HEADERS
+my_bison_hdr.CONFIG += target_predeps
+
+QMAKE_EXTRA_COMPILERS += my_bison_src
+QMAKE_EXTRA_COMPILERS += my_bison_hdr
+
+MY_FLEX_SOURCES = $$PWD/wavefront_scanner.l $$PWD/gl_lang_scanner.l
+
+my_flex_src.commands = flex -o ${QMAKE_FILE_BASE}.cpp ${QMAKE_FILE_IN}
+my_flex_src.input = MY_FLEX_SOURCES
+my_flex_src.output = ${QMAKE_FILE_BASE}.cpp
+my_flex_src.variable_out = SOURCES
+my_flex_src.CONFIG += target_predeps
+
+my_flex_hdr.commands = flex --header-file=${QMAKE_FILE_BASE}.h -t ${QMAKE_FILE_IN} > /dev/null
+my_flex_hdr.input = MY_FLEX_SOURCES
+my_flex_hdr.output = ${QMAKE_FILE_BASE}.h
+my_flex_hdr.variable_out = HEADERS
+my_flex_hdr.CONFIG += target_predeps
+
+QMAKE_EXTRA_COMPILERS += my_flex_src
+QMAKE_EXTRA_COMPILERS += my_flex_hdr
+
+LIBS += -lavcodec -lavutil -lswscale
@@ -0,0 +1,222 @@
+#include "batchmath.h"
+
+#include <QtConcurrent>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+
+using namespace Math3D;
+
+static_assert(sizeof(Vector4) == 4 * sizeof(Real), "Vector4 arrays must be contiguous floats");
+
+namespace {
+
+using Range = QPair<int, int>;
+
+// smaller arrays are not worth the thread hand-off
+const int ChunkSize = 16384;
+
+QVector<Range> chunks(int n, bool parallel) {
+    QVector<Range> ranges;
+    if (!parallel || n < 2 * ChunkSize) {
+        ranges.append(Range(0, n));
+        return ranges;
+    }
+    int count = std::min(QThread::idealThreadCount(), n / ChunkSize);
+    int step = (n + count - 1) / count;
+    for (int begin = 0; begin < n; begin += step) {
+        ranges.append(Range(begin, std::min(n, begin + step)));
+    }
+    return ranges;
+}
+
+template <typename F> void partition(int n, bool parallel, F f) {
+    QVector<Range> ranges = chunks(n, parallel);
+    if (ranges.size() == 1) {
+        f(0, n);
+        return;
+    }
+    QtConcurrent::blockingMap(ranges, [&f] (Range& r) {f(r.first, r.second);});
+}
+
+const Real* data(const Vector4* v) {return reinterpret_cast<const Real*>(v);}
+Real* data(Vector4* v) {return reinterpret_cast<Real*>(v);}
+
+// w is the homogeneous coordinate of the inputs and outputs
+void transform(const Matrix4& m, const Real* in, Real* out, int begin, int end, Real w) {
+#ifdef MATH3D_SSE
+    const Real* e = m.readArray();
+    __m128 c0 = _mm_loadu_ps(e);
+    __m128 c1 = _mm_loadu_ps(e + 4);
+    __m128 c2 = _mm_loadu_ps(e + 8);
+    __m128 c3 = _mm_mul_ps(_mm_loadu_ps(e + 12), _mm_set1_ps(w));
+    // blend mask for the w lane
+    const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 ww = _mm_setr_ps(0, 0, 0, w);
+    for (int i = begin; i < end; i++) {
+        __m128 v = _mm_loadu_ps(in + 4 * i);
+        __m128 r = Kernel::madd(c0, _mm_shuffle_ps(v, v, 0x00), c3);
+        r = Kernel::madd(c1, _mm_shuffle_ps(v, v, 0x55), r);
+        r = Kernel::madd(c2, _mm_shuffle_ps(v, v, 0xaa), r);
+        _mm_storeu_ps(out + 4 * i, _mm_or_ps(_mm_and_ps(xyz, r), ww));
+    }
+#else
+    for (int i = begin; i < end; i++) {
+        Real v[4] = {in[4 * i], in[4 * i + 1], in[4 * i + 2], w};
+        Kernel::transform(m.readArray(), v, out + 4 * i);
+        out[4 * i + 3] = w;
+    }
+#endif
+}
+
+void normalizeRange(Real* v, int begin, int end) {
+    int i = begin;
+#ifdef MATH3D_SSE
+    // four vectors at a time, transposed to x, y, z, w lanes
+    for (; i + 4 <= end; i += 4) {
+        Real* p = v + 4 * i;
+        __m128 x = _mm_loadu_ps(p);
+        __m128 y = _mm_loadu_ps(p + 4);
+        __m128 z = _mm_loadu_ps(p + 8);
+        __m128 w = _mm_loadu_ps(p + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 len = _mm_sqrt_ps(Kernel::madd(z, z, Kernel::madd(y, y, _mm_mul_ps(x, x))));
+        x = _mm_div_ps(x, len);
+        y = _mm_div_ps(y, len);
+        z = _mm_div_ps(z, len);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(p, x);
+        _mm_storeu_ps(p + 4, y);
+        _mm_storeu_ps(p + 8, z);
+        _mm_storeu_ps(p + 12, w);
+    }
+#endif
+    for (; i < end; i++) {
+        Real* p = v + 4 * i;
+        Real len = std::sqrt(p[X] * p[X] + p[Y] * p[Y] + p[Z] * p[Z]);
+        p[X] /= len;
+        p[Y] /= len;
+        p[Z] /= len;
+    }
+}
+
+void crossRange(const Real* a, const Real* b, Real* out, int begin, int end) {
+    int i = begin;
+#ifdef MATH3D_SSE
+    const __m128 one = _mm_set1_ps(1);
+    for (; i + 4 <= end; i += 4) {
+        __m128 ax = _mm_loadu_ps(a + 4 * i);
+        __m128 ay = _mm_loadu_ps(a + 4 * i + 4);
+        __m128 az = _mm_loadu_ps(a + 4 * i + 8);
+        __m128 aw = _mm_loadu_ps(a + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        __m128 bx = _mm_loadu_ps(b + 4 * i);
+        __m128 by = _mm_loadu_ps(b + 4 * i + 4);
+        __m128 bz = _mm_loadu_ps(b + 4 * i + 8);
+        __m128 bw = _mm_loadu_ps(b + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+        __m128 x = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        __m128 w = one;
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(out + 4 * i, x);
+        _mm_storeu_ps(out + 4 * i + 4, y);
+        _mm_storeu_ps(out + 4 * i + 8, z);
+        _mm_storeu_ps(out + 4 * i + 12, w);
+    }
+#endif
+    for (; i < end; i++) {
+        const Real* p = a + 4 * i;
+        const Real* q = b + 4 * i;
+        Real x = p[Y] * q[Z] - p[Z] * q[Y];
+        Real y = p[Z] * q[X] - p[X] * q[Z];
+        Real z = p[X] * q[Y] - p[Y] * q[X];
+        Real* r = out + 4 * i;
+        r[X] = x;
+        r[Y] = y;
+        r[Z] = z;
+        r[W] = 1;
+    }
+}
+
+void boundsRange(const Real* p, int begin, int end, Real* lo, Real* hi) {
+#ifdef MATH3D_SSE
+    __m128 l = _mm_loadu_ps(p + 4 * begin);
+    __m128 h = l;
+    for (int i = begin + 1; i < end; i++) {
+        __m128 v = _mm_loadu_ps(p + 4 * i);
+        l = _mm_min_ps(l, v);
+        h = _mm_max_ps(h, v);
+    }
+    _mm_storeu_ps(lo, l);
+    _mm_storeu_ps(hi, h);
+#else
+    for (int k = 0; k < 4; k++) lo[k] = hi[k] = p[4 * begin + k];
+    for (int i = begin + 1; i < end; i++) {
+        for (int k = 0; k < 4; k++) {
+            lo[k] = std::min(lo[k], p[4 * i + k]);
+            hi[k] = std::max(hi[k], p[4 * i + k]);
+        }
+    }
+#endif
+}
+
+}
+
+void Batch::transformPoints(const Matrix4& m, const Vector4* in, Vector4* out, int n, bool parallel) {
+    partition(n, parallel, [&] (int begin, int end) {
+        transform(m, data(in), data(out), begin, end, 1);
+    });
+}
+
+void Batch::transformDirections(const Matrix4& m, const Vector4* in, Vector4* out, int n, bool parallel) {
+    partition(n, parallel, [&] (int begin, int end) {
+        transform(m, data(in), data(out), begin, end, 0);
+    });
+}
+
+void Batch::normalize(Vector4* v, int n, bool parallel) {
+    partition(n, parallel, [&] (int begin, int end) {
+        normalizeRange(data(v), begin, end);
+    });
+}
+
+void Batch::cross(const Vector4* a, const Vector4* b, Vector4* out, int n, bool parallel) {
+    partition(n, parallel, [&] (int begin, int end) {
+        crossRange(data(a), data(b), data(out), begin, end);
+    });
+}
+
+void Batch::bounds(const Vector4* p, int n, Vector4& lo, Vector4& hi, bool parallel) {
+    lo = Vector4(0, 0, 0);
+    hi = Vector4(0, 0, 0);
+    if (n <= 0) return;
+
+    QVector<Range> ranges = chunks(n, parallel);
+    // per chunk lo, hi
+    QVector<Vector4> partial(2 * ranges.size());
+    Vector4* parts = partial.data();
+    const Range* rs = ranges.constData();
+    if (ranges.size() == 1) {
+        boundsRange(data(p), 0, n, data(parts), data(parts + 1));
+    } else {
+        QVector<int> indices;
+        for (int k = 0; k < ranges.size(); k++) indices.append(k);
+        QtConcurrent::blockingMap(indices, [&] (int& k) {
+            boundsRange(data(p), rs[k].first, rs[k].second, data(parts + 2 * k), data(parts + 2 * k + 1));
+        });
+    }
+
+    const Real* r = data(partial.constData());
+    Real l[3] = {r[X], r[Y], r[Z]};
+    Real h[3] = {r[4 + X], r[4 + Y], r[4 + Z]};
+    for (int k = 1; k < ranges.size(); k++) {
+        for (int c = 0; c < 3; c++) {
+            l[c] = std::min(l[c], r[8 * k + c]);
+            h[c] = std::max(h[c], r[8 * k + 4 + c]);
+        }
+    }
+    lo = Vector4(l[X], l[Y], l[Z]);
+    hi = Vector4(h[X], h[Y], h[Z]);
+}
@@ -0,0 +1,26 @@
+#ifndef BATCHMATH_H
+#define BATCHMATH_H
+
+#include "math3d.h"
+
+namespace Math3D {
+namespace Batch {
+
+// Kernels over contiguous Vector4 arrays. Output may be the same array
+// as the input. With parallel set, large arrays are split among the
+// threads of the global thread pool.
+
+// out[i] = m * (x, y, z, 1), w = 1
+void transformPoints(const Matrix4& m, const Vector4* in, Vector4* out, int n, bool parallel = false);
+// out[i] = m * (x, y, z, 0), w = 0
+void transformDirections(const Matrix4& m, const Vector4* in, Vector4* out, int n, bool parallel = false);
+// unit length (x, y, z), w unchanged
+void normalize(Vector4* v, int n, bool parallel = false);
+// out[i] = a[i] x b[i], w = 1 as in Math3D::cross
+void cross(const Vector4* a, const Vector4* b, Vector4* out, int n, bool parallel = false);
+// axis aligned bounding box, lo = hi = 0 for an empty array
+void bounds(const Vector4* p, int n, Vector4& lo, Vector4& hi, bool parallel = false);
+
+}} // namespace Math3D::Batch
+
+#endif // BATCHMATH_H
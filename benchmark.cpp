@@ -0,0 +1,400 @@
+#include "benchmark.h"
+#include "gl_widget.h"
+#include "gl_backend.h"
+#include "project.h"
+#include "scope.h"
+#include "modelstore.h"
+#include "objreader.h"
+#include "indextable.h"
+#include "triangleoptimizer.h"
+#include "meshoptimizer.h"
+
+#include <QDir>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+
+using namespace Demo;
+
+static QStringList sampleProjects() {
+    QStringList projects;
+    for (auto dir: {"ogl", "sb7"}) {
+        QDir d(dir);
+        for (auto& name: d.entryList({"*.ini"}, QDir::Files, QDir::Name)) {
+            projects.append(d.filePath(name));
+        }
+    }
+    return projects;
+}
+
+int Demo::runBenchmark(int frames, const QStringList& args) {
+    QTextStream out(stdout);
+    if (frames <= 0) {
+        out << "Usage: OpenGLDemo --benchmark frames [--interpret] [--trace file] [project.ini ...]\n";
+        return 1;
+    }
+    QStringList projects = args;
+    // no command buffer replay
+    bool interpret = projects.removeAll("--interpret") > 0;
+    // GL call log
+    QFile trace;
+    int traceArg = projects.indexOf("--trace");
+    if (traceArg >= 0) {
+        trace.setFileName(projects.value(traceArg + 1));
+        projects.erase(projects.begin() + traceArg, projects.begin() + qMin(traceArg + 2, projects.size()));
+        if (!trace.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+            out << "Cannot write " << trace.fileName() << "\n";
+            return 1;
+        }
+    }
+
+    GLWidget target;
+    GL::Backend* backend = new GL::NullBackend;
+    if (trace.isOpen()) backend = new GL::RecordingBackend(backend, &trace);
+    target.setBackend(backend);
+    Scope globals(&target);
+    // viewport and projection
+    target.setProjection(.1, 500);
+
+    int failed = 0;
+    for (auto& path: projects.isEmpty() ? sampleProjects() : projects) {
+        try {
+            // compiles and runs init
+            Project project(path, &target, &globals, false);
+            project.setProfiling(true, false);
+            project.setReplay(!interpret);
+            for (int i = 0; i < frames; i++) target.drawFrame();
+
+            QStringList broken = project.brokenScripts();
+            if (!broken.isEmpty()) failed++;
+            out << path << ": " << frames << " frames\n";
+            auto nsecs = project.scriptNsecs();
+            for (auto it = nsecs.constBegin(); it != nsecs.constEnd(); ++it) {
+                out << "  " << it.key().leftJustified(32)
+                    << it.value() / frames << " ns/frame"
+                    << (broken.contains(it.key()) ? " (error)" : "") << "\n";
+            }
+        } catch (BadProject& e) {
+            out << path << ": " << e.msg() << "\n";
+            failed++;
+        }
+        out.flush();
+    }
+    return failed;
+}
+
+namespace {
+
+using Math3D::Real;
+
+// out = f(a[i], b[i]) over the sample set, timed
+template <typename Op> qint64 timeOp(const QVector<Real>& data, int iterations, Real& sink, Op op) {
+    Real out[16];
+    int count = data.size() / 16 - 1;
+    QElapsedTimer timer;
+    timer.start();
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < count; i++) {
+            op(data.constData() + 16 * i, data.constData() + 16 * (i + 1), out);
+            sink += out[n & 3];
+        }
+    }
+    return timer.nsecsElapsed() / (qint64(iterations) * count);
+}
+
+}
+
+int Demo::runMathBenchmark(int iterations) {
+    QTextStream out(stdout);
+    if (iterations <= 0) {
+        out << "Usage: OpenGLDemo --benchmark-math iterations\n";
+        return 1;
+    }
+
+    // well conditioned sample matrices
+    QVector<Real> data;
+    for (int i = 0; i < 256; i++) {
+        Math3D::Matrix4 r, t;
+        r.setRotation(0.1 * i, Math3D::Vector4(1, i % 7, i % 3));
+        t.setTranslation(Math3D::Vector4(i, -i, 2 * i));
+        Math3D::Matrix4 m = t * r;
+        m(3)[3] = 1 + 0.01 * i;
+        for (int k = 0; k < 16; k++) data.append(m.readArray()[k]);
+    }
+
+    Real sink = 0;
+    auto row = [&out] (const char* name, qint64 scalar, qint64 kernel) {
+        out << "  " << QString(name).leftJustified(12)
+            << QString::number(scalar).rightJustified(6) << " ns/op scalar"
+            << QString::number(kernel).rightJustified(6) << " ns/op kernel\n";
+    };
+
+    out << "Math3D, " << iterations << " iterations\n";
+    row("mul",
+        timeOp(data, iterations, sink, Math3D::Scalar::mul),
+        timeOp(data, iterations, sink, Math3D::Kernel::mul));
+    row("transform",
+        timeOp(data, iterations, sink, Math3D::Scalar::transform),
+        timeOp(data, iterations, sink, Math3D::Kernel::transform));
+    row("transpose",
+        timeOp(data, iterations, sink, [] (const Real* a, const Real*, Real* o) {Math3D::Scalar::transpose(a, o);}),
+        timeOp(data, iterations, sink, [] (const Real* a, const Real*, Real* o) {Math3D::Kernel::transpose(a, o);}));
+    row("inverse",
+        timeOp(data, iterations, sink, [] (const Real* a, const Real*, Real* o) {Math3D::Scalar::inverse(a, o);}),
+        timeOp(data, iterations, sink, [] (const Real* a, const Real*, Real* o) {Math3D::Kernel::inverse(a, o);}));
+    // keeps the optimizer from dropping the loops
+    out << "  checksum " << sink << "\n";
+    return 0;
+}
+
+namespace {
+
+unsigned int wrapIndex(int x, unsigned int l) {
+    if (l == 0) return 0;
+    if (x < 1) return (x + l) % l;
+    return (x - 1) % l;
+}
+
+// the faces as triangle fans over the deduplicated vertices
+class Triangulation {
+public:
+    Mesh::IndexVector triangles;
+    Mesh::Vector4Vector positions;
+};
+
+// face corners and edges of the faces, deduplicated with the key of choice,
+// and optionally the triangulation
+template <typename Dedup> int dedup(const WF::ObjReader& r, Dedup& d, Triangulation* mesh = nullptr) {
+    int count = 0;
+    QVector<quint32> face;
+    for (const WF::ObjReader::Face& f: r.faces) {
+        if (f.size < 3 || f.vertices == 0) continue;
+        face.clear();
+        for (int i = 0; i < f.size; i++) {
+            const WF::TripletIndex& t = r.triplets[f.begin + i];
+            quint32 v = wrapIndex(t.v_index, f.vertices);
+            quint32 n = t.n_index ? wrapIndex(t.n_index, f.normals) : VertexKey::Absent;
+            quint32 x = t.t_index ? wrapIndex(t.t_index, f.texes) : VertexKey::Absent;
+            quint32 index = d.vertex(v, n, x);
+            if (mesh && index == quint32(mesh->positions.size())) mesh->positions.append(r.vertices[v]);
+            face.append(index);
+        }
+        for (int i = 1; i < face.size(); i++) {
+            count += d.edge(face[i - 1], face[i]);
+        }
+        if (!mesh) continue;
+        for (int i = 2; i < face.size(); i++) {
+            mesh->triangles << face[0] << face[i - 1] << face[i];
+        }
+    }
+    return count;
+}
+
+// the QString keys ModelStore used before
+class StringDedup {
+public:
+    quint32 vertex(quint32 v, quint32 n, quint32 t) {
+        QString key = QString("%1:%2:%3").arg(v)
+                .arg(n == VertexKey::Absent ? QString() : QString::number(n))
+                .arg(t == VertexKey::Absent ? QString() : QString::number(t));
+        auto it = vertices.constFind(key);
+        if (it != vertices.constEnd()) return it.value();
+        quint32 index = vertices.size();
+        vertices.insert(key, index);
+        return index;
+    }
+    int edge(quint32 v1, quint32 v2) {
+        QString key = v1 < v2 ? QString("%1:%2").arg(v1).arg(v2) : QString("%1:%2").arg(v2).arg(v1);
+        if (edges.contains(key)) return 0;
+        edges.insert(key, 0);
+        return 1;
+    }
+    QHash<QString, quint32> vertices;
+    QHash<QString, quint32> edges;
+};
+
+class TableDedup {
+public:
+    quint32 vertex(quint32 v, quint32 n, quint32 t) {
+        bool inserted;
+        return vertices.insert(VertexKey(v, n, t), vertices.size(), inserted);
+    }
+    int edge(quint32 v1, quint32 v2) {
+        bool inserted;
+        edges.insert(EdgeKey(v1, v2), 0, inserted);
+        return inserted;
+    }
+    IndexTable<VertexKey> vertices;
+    IndexTable<EdgeKey> edges;
+};
+
+}
+
+int Demo::runModelBenchmark(int iterations, const QStringList& args) {
+    QTextStream out(stdout);
+    if (iterations <= 0) {
+        out << "Usage: OpenGLDemo --benchmark-models iterations [model.obj ...]\n";
+        return 1;
+    }
+    QStringList files = args;
+    if (files.isEmpty()) {
+        QDir d("ogl");
+        for (auto& name: d.entryList({"*.obj"}, QDir::Files, QDir::Name)) {
+            files.append(d.filePath(name));
+        }
+    }
+
+    int failed = 0;
+    GL::ModelStore::Loader loader;
+    for (auto& path: files) {
+        QFile file(path);
+        if (!file.open(QFile::ReadOnly)) {
+            out << path << ": cannot open\n";
+            failed++;
+            continue;
+        }
+        QByteArray bytes = file.readAll();
+        WF::ObjReader reader;
+        if (!reader.read(bytes.constData(), bytes.size())) {
+            // surfaces and such: only the full load is timed
+            reader = WF::ObjReader();
+        }
+        Triangulation mesh;
+        TableDedup triangulation;
+        dedup(reader, triangulation, &mesh);
+        const Mesh::IndexVector& triangles = mesh.triangles;
+        int vertexCount = mesh.positions.size();
+        AC::TriangleOptimizer::StripVector strips;
+        int indices = 0;
+        Mesh::IndexVector optimized;
+        QVector<int> lodTriangles;
+        QVector<float> lodDistances;
+
+        QElapsedTimer timer;
+        qint64 strings = 0;
+        qint64 tables = 0;
+        qint64 load = 0;
+        qint64 stripify = 0;
+        qint64 optimize = 0;
+        qint64 simplify = 0;
+        int edges = 0;
+        for (int n = 0; n < iterations; n++) {
+            timer.start();
+            StringDedup sd;
+            edges += dedup(reader, sd);
+            strings += timer.nsecsElapsed();
+
+            timer.start();
+            TableDedup td;
+            edges -= dedup(reader, td);
+            tables += timer.nsecsElapsed();
+
+            timer.start();
+            try {
+                loader.parseModelData(path);
+            } catch (WF::ModelError& e) {
+                out << path << ": " << e.msg() << "\n";
+                failed++;
+                break;
+            }
+            load += timer.nsecsElapsed();
+
+            timer.start();
+            AC::TriangleOptimizer stripper(triangles);
+            stripify += timer.nsecsElapsed();
+            strips = stripper.strips();
+            indices = 0;
+            for (auto& strip: strips) indices += strip.size();
+
+            timer.start();
+            optimized = Mesh::optimizeVertexCache(triangles, vertexCount);
+            optimized = Mesh::optimizeOverdraw(optimized, mesh.positions);
+            Mesh::optimizeVertexFetch(optimized, vertexCount);
+            optimize += timer.nsecsElapsed();
+
+            // the level of detail chain of ModelStore
+            timer.start();
+            lodTriangles.clear();
+            lodDistances.clear();
+            Mesh::IndexVector current = triangles;
+            float distance = 0;
+            while (lodTriangles.size() < 8 && current.size() / 3 >= 512) {
+                float e;
+                Mesh::IndexVector next = Mesh::simplify(current, mesh.positions, current.size() / 6, e);
+                if (4 * next.size() > 3 * current.size()) break;
+                distance += e;
+                lodTriangles.append(next.size() / 3);
+                lodDistances.append(distance);
+                current = next;
+            }
+            simplify += timer.nsecsElapsed();
+        }
+        // both schemes find the same edges
+        if (edges != 0) failed++;
+
+        out << path << ": " << reader.faces.size() << " faces, " << iterations << " iterations\n"
+            << "  load        " << load / iterations / 1000 << " us\n"
+            << "  dedup       " << strings / iterations / 1000 << " us string keys, "
+            << tables / iterations / 1000 << " us integer keys\n"
+            << "  stripify    " << stripify / iterations / 1000 << " us, " << triangles.size() / 3
+            << " triangles in " << strips.size() << " strips of " << indices << " indices, "
+            << indices + std::max(0, strips.size() - 1) << " with restarts\n"
+            << "  optimize    " << optimize / iterations / 1000 << " us\n"
+            << "  simplify    " << simplify / iterations / 1000 << " us, " << lodTriangles.size() << " levels";
+        for (int k = 0; k < lodTriangles.size(); k++) {
+            out << (k ? ", " : ": ") << lodTriangles[k] << " triangles plane distance " << lodDistances[k];
+        }
+        out << "\n";
+
+        // index orders of the same mesh, positions as the fetched stream
+        Mesh::IndexVector stripTriangles;
+        for (auto& strip: strips) Mesh::appendStrip(stripTriangles, strip);
+        auto stats = [&] (const char* name, const Mesh::IndexVector& t) {
+            Mesh::Statistics s = Mesh::analyze(t, vertexCount, 3 * sizeof(float));
+            out << "  " << name << "ACMR " << s.acmr << ", ATVR " << s.atvr << ", overfetch " << s.overfetch << "\n";
+        };
+        stats("faces       ", triangles);
+        stats("strips      ", stripTriangles);
+        stats("triangles   ", optimized);
+        out.flush();
+    }
+
+    // all files as a project: one after another vs in parallel
+    QMap<QString, QString> items;
+    for (int k = 0; k < files.size(); k++) items[QString("model%1").arg(k)] = files[k];
+    qint64 sequential = 0;
+    qint64 parallel = 0;
+    QElapsedTimer timer;
+    for (int n = 0; n < iterations; n++) {
+        GL::ModelStore store;
+        timer.start();
+        for (auto it = items.constBegin(); it != items.constEnd(); ++it) {
+            store.setItem(it.key(), it.value());
+        }
+        sequential += timer.nsecsElapsed();
+
+        store.clean();
+        timer.start();
+        store.setItems(items);
+        parallel += timer.nsecsElapsed();
+    }
+    out << files.size() << " files\n"
+        << "  project     " << sequential / iterations / 1000 << " us sequential, "
+        << parallel / iterations / 1000 << " us parallel\n";
+
+    // upload sizes of the vertex formats
+    GL::ModelStore store;
+    store.setItems(items);
+    const GL::ModelStore::Format formats[] = {GL::ModelStore::Planar, GL::ModelStore::Interleaved, GL::ModelStore::Quantized};
+    const char* names[] = {"planar      ", "interleaved ", "quantized   "};
+    for (int f = 0; f < 3; f++) {
+        for (auto it = items.constBegin(); it != items.constEnd(); ++it) {
+            store.setFormat(it.key(), formats[f]);
+        }
+        out << "  " << names[f] << GL::ModelStore::vertexSize(formats[f]) << " bytes per vertex, "
+            << store.bytelen(GL_ARRAY_BUFFER) << " + " << store.bytelen(GL_ELEMENT_ARRAY_BUFFER)
+            << " bytes vertices + indices\n";
+    }
+    return failed;
+}
@@ -0,0 +1,31 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+
+namespace Demo {
+
+// Runs the projects (default: ogl/*.ini and sb7/*.ini) for the given
+// number of frames against the null GL backend and prints the script
+// CPU time per frame. "--interpret" among the arguments turns off
+// command buffer replay, "--trace file" writes the GL calls to file.
+// Returns the number of projects that failed.
+int runBenchmark(int frames, const QStringList& args);
+
+// Times the Math3D matrix kernels against the scalar reference code
+// and prints ns/op for both.
+int runMathBenchmark(int iterations);
+
+// Loads the OBJ files (default: ogl/*.obj) and prints the load time,
+// the vertex and edge deduplication time with the former string keys
+// and with the integer key tables, the stripification time and strip
+// counts, the simplification time, triangle counts and error bounds of
+// the levels of detail, and the vertex cache and fetch statistics of the
+// face order, the strips and the optimized triangle list. Then loads all
+// files as a project, sequentially and in parallel, and prints the model
+// buffer sizes of the vertex formats.
+int runModelBenchmark(int iterations, const QStringList& files);
+
+}
+
+#endif // BENCHMARK_H
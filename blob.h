@@ -3,6 +3,10 @@
 
 #include <QtPlugin>
 #include <QMap>
+#include <QHash>
+#include <QVector>
+
+#include "math3d.h"
 
 namespace Demo {
 namespace GL {
@@ -40,20 +44,86 @@ class Blob {
 
 public:
 
-    Blob() {}
+    Blob(): mRevision(0) {}
 
     QString name() const {return dynamic_cast<const QObject*>(this)->objectName();}
     unsigned int bytelen(unsigned int target) const {return mData[target].length;}
     const void* bytes(unsigned int target) const {return mData[target].data;}
-    const BlobSpec spec(const QString& key) const {return mSpecs[key];}
 
-    virtual void draw(unsigned int mode, const QString& attr) const = 0;
+    // integer handles for spec and draw names, valid while revision() stays the same
+    unsigned revision() const {return mRevision;}
+    int specKey(const QString& key) const {return mSpecKeys.value(key, -1);}
+    const BlobSpec& spec(int key) const {return mSpecs[key];}
+    const BlobSpec spec(const QString& key) const {
+        int k = specKey(key);
+        return k < 0 ? BlobSpec() : mSpecs[k];
+    }
+
+    virtual int drawKey(const QString& attr) const = 0;
+    virtual void draw(unsigned int mode, int key) const = 0;
+
+    // Buffer object that bufferextdata filled with the data of target.
+    // Blobs changing parts of their data update it in place.
+    void setUploaded(unsigned int target, unsigned int buffer) const {
+        mUploads[target] = buffer;
+    }
+    // the buffer object is gone
+    void forgetUpload(unsigned int buffer) const {
+        auto it = mUploads.begin();
+        while (it != mUploads.end()) {
+            if (it.value() == buffer) it = mUploads.erase(it); else ++it;
+        }
+    }
+    void forgetUploads() const {mUploads.clear();}
+
+    // maps the stored positions of a draw key to model coordinates
+    virtual Math3D::Matrix4 dequantization(int) const {
+        Math3D::Matrix4 m;
+        return m.setIdentity();
+    }
+
+    // Level of detail of a draw key whose error projects to at most
+    // pixels on a width x height viewport with the clip transform, 0 for
+    // the full detail
+    virtual int lod(int, const Math3D::Matrix4&, float, float, float) const {return 0;}
+    virtual void drawLod(unsigned int mode, int key, int) const {draw(mode, key);}
 
     virtual ~Blob() = default;
 
 protected:
 
-    using SpecMap = QMap<QString, BlobSpec>;
+    void setSpec(const QString& key, const BlobSpec& spec) {
+        if (mSpecKeys.contains(key)) {
+            mSpecs[mSpecKeys[key]] = spec;
+        } else {
+            mSpecKeys[key] = mSpecs.size();
+            mSpecs.append(spec);
+        }
+        mRevision++;
+    }
+
+    void renameSpec(const QString& from, const QString& to) {
+        if (!mSpecKeys.contains(from)) return;
+        mSpecKeys[to] = mSpecKeys.take(from);
+        mRevision++;
+    }
+
+    // the slot of the spec stays unused
+    void removeSpec(const QString& key) {
+        if (mSpecKeys.remove(key)) mRevision++;
+    }
+
+    void clearSpecs() {
+        mSpecKeys.clear();
+        mSpecs.clear();
+        mRevision++;
+    }
+
+    // call when draw keys change
+    void changed() {mRevision++;}
+
+    using SpecKeyMap = QHash<QString, int>;
+    using SpecVector = QVector<BlobSpec>;
 
     class Data {
     public:
@@ -73,10 +143,18 @@ protected:
 
     using DataMap = QMap<unsigned int, Data>;
 
+    using UploadMap = QMap<unsigned int, unsigned int>; // target -> buffer
+
 protected:
 
-    SpecMap mSpecs;
+    SpecKeyMap mSpecKeys;
+    SpecVector mSpecs;
     DataMap mData;
+    mutable UploadMap mUploads;
+
+private:
+
+    unsigned mRevision;
 
 };
 
@@ -0,0 +1,55 @@
+#include "bufferheap.h"
+
+#include <iterator>
+
+using namespace Demo::GL;
+
+const uint BufferHeap::Full;
+
+void BufferHeap::reset(uint capacity) {
+    mFree.clear();
+    mCapacity = capacity;
+    if (capacity > 0) mFree[0] = capacity;
+}
+
+uint BufferHeap::allocate(uint size, uint hint) {
+    if (size == 0) return 0;
+    auto it = mFree.end();
+    uint offset = hint;
+    if (hint != Full) {
+        // the free range containing hint
+        auto h = mFree.upperBound(hint);
+        if (h != mFree.begin()) {
+            --h;
+            if (h.key() + h.value() >= hint + size) it = h;
+        }
+    }
+    if (it == mFree.end()) {
+        for (it = mFree.begin(); it != mFree.end() && it.value() < size; ++it) {}
+        if (it == mFree.end()) return Full;
+        offset = it.key();
+    }
+    uint begin = it.key();
+    uint end = begin + it.value();
+    mFree.erase(it);
+    if (offset > begin) mFree[begin] = offset - begin;
+    if (offset + size < end) mFree[offset + size] = end - offset - size;
+    return offset;
+}
+
+void BufferHeap::release(uint offset, uint size) {
+    if (size == 0) return;
+    auto next = mFree.lowerBound(offset);
+    if (next != mFree.end() && next.key() == offset + size) {
+        size += next.value();
+        next = mFree.erase(next);
+    }
+    if (next != mFree.begin()) {
+        auto prev = std::prev(next);
+        if (prev.key() + prev.value() == offset) {
+            prev.value() += size;
+            return;
+        }
+    }
+    mFree[offset] = size;
+}
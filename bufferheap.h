@@ -0,0 +1,34 @@
+#ifndef BUFFERHEAP_H
+#define BUFFERHEAP_H
+
+#include <QMap>
+
+namespace Demo {
+namespace GL {
+
+// First fit allocator of byte ranges in a buffer. Adjacent free ranges
+// are merged.
+class BufferHeap {
+
+public:
+
+    static const uint Full = ~0u;
+    // all free
+    void reset(uint capacity);
+    // Offset of size free bytes, at hint if there is room there. Full
+    // if there is no room.
+    uint allocate(uint size, uint hint = Full);
+    void release(uint offset, uint size);
+    uint capacity() const {return mCapacity;}
+
+private:
+
+    using FreeMap = QMap<uint, uint>; // offset -> size
+
+    FreeMap mFree;
+    uint mCapacity = 0;
+};
+
+}} // namespace Demo::GL
+
+#endif // BUFFERHEAP_H
@@ -14,7 +14,8 @@
 
 using Math3D::Matrix4;
 using Math3D::Vector4;
-using Math3D::Real;
+using Math3D::Matrix4d;
+using Math3D::Vector4d;
 using Math3D::dot3;
 
 Camera::Camera(const Vector4& eye, const Vector4& center, const Vector4& up)
@@ -23,9 +24,12 @@ Camera::Camera(const Vector4& eye, const Vector4& center, const Vector4& up)
 }
 
 
-void Camera::reset(const Vector4& eye, const Vector4& center, const Vector4& up) {
-    Vector4 z = (eye - center).normalized3();
-    Vector4 y = (up - dot3(z, up) * z).normalized3();
+void Camera::reset(const Vector4& eye4, const Vector4& center4, const Vector4& up4) {
+    Vector4d eye(eye4);
+    Vector4d center(center4);
+    Vector4d up(up4);
+    Vector4d z = (eye - center).normalized3();
+    Vector4d y = (up - dot3(z, up) * z).normalized3();
     mRot.setBasis(y, z);
     mRot0 = mRot;
 
@@ -35,9 +39,7 @@ void Camera::reset(const Vector4& eye, const Vector4& center, const Vector4& up)
     mD = (eye - center).length3();
     mD0 = mD;
 
-    mTot.setTranslation(- mEye);
-    mTot = mRot * mTot;
-
+    update();
 }
 
 void Camera::reset() {
@@ -45,49 +47,56 @@ void Camera::reset() {
     mEye = mEye0;
     mD = mD0;
 
-    mTot.setTranslation(- mEye);
-    mTot = mRot * mTot;
+    update();
 }
 
 
 void Camera::rotate(float phi, float theta) {
 
-    Vector4 d0 = mD * mRot.row3(Math3D::Z); // eye - center
+    Vector4d d0 = mD * mRot.row3(Math3D::Z); // eye - center
 
-    Matrix4 r;
-    r.setRotation(theta, Vector4(sin(phi), cos(phi), 0));
+    Matrix4d r;
+    r.setRotation(theta, Vector4d(sin(phi), cos(phi), 0));
     mRot = r * mRot;
 
-    Vector4 d = mD * mRot.row3(Math3D::Z);
+    Vector4d d = mD * mRot.row3(Math3D::Z);
 
     mEye += d - d0;
 
-    mTot.setTranslation(- mEye);
-    mTot = mRot * mTot;
+    update();
 }
 
 void Camera::pan(float phi, float theta) {
-    Matrix4 r;
-    r.setRotation(theta, Vector4(sin(phi), cos(phi), 0));
+    Matrix4d r;
+    r.setRotation(theta, Vector4d(sin(phi), cos(phi), 0));
     mRot = r * mRot;
 
-    mTot.setTranslation(- mEye);
-    mTot = mRot * mTot;
+    update();
 }
 
 void Camera::zoom(float dz) {
     if (mD + dz < Math3D::EPSILON) return;
     mD += dz;
 
-    Vector4 d = dz * mRot.row3(Math3D::Z); // eye - center
+    Vector4d d = dz * mRot.row3(Math3D::Z); // eye - center
 
     mEye += d;
 
-    mTot.setTranslation(- mEye);
-    mTot = mRot * mTot;
+    update();
+}
+
+void Camera::update() {
+    Matrix4d t;
+    t.setTranslation(- mEye);
+    mTot = mRot * t;
+    mTrans = mTot.toFloat();
 }
 
 
 const Matrix4& Camera::trans() const {
-    return mTot;
+    return mTrans;
+}
+
+Matrix4 Camera::relative(const Matrix4& model) const {
+    return (mTot * Matrix4d(model)).toFloat();
 }
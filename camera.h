@@ -27,12 +27,18 @@ public:
     void reset();
     void reset(const Math3D::Vector4& eye, const Math3D::Vector4& center, const Math3D::Vector4& up);
     const Math3D::Matrix4& trans() const;
+    // camera * model in double precision: large translations cancel
+    // before the conversion to float
+    Math3D::Matrix4 relative(const Math3D::Matrix4& model) const;
 
 private:
 
-    Math3D::Matrix4 mRot, mRot0, mTot;
-    Math3D::Vector4 mEye, mEye0;
-    Math3D::Real mD, mD0;
+    void update();
+
+    Math3D::Matrix4d mRot, mRot0, mTot;
+    Math3D::Vector4d mEye, mEye0;
+    double mD, mD0;
+    Math3D::Matrix4 mTrans;
 };
 
 
@@ -15,6 +15,7 @@ using namespace Demo;
 CodeEditor::CodeEditor(const QString& name, Scope* globals, Project* owner, const QString& text):
     QPlainTextEdit(text),
     mCompileDelay(new QTimer(this)),
+    mProfileTimer(new QTimer(this)),
     mCompileErrorPos(-1),
     mRunErrorPos(-1),
     mCompiler(new GL::Compiler(name, globals, this)),
@@ -36,6 +37,9 @@ CodeEditor::CodeEditor(const QString& name, Scope* globals, Project* owner, cons
     highlightCurrentLine();
 
     mCompileDelay->setInterval(700);
+
+    mProfileTimer->setInterval(1000);
+    connect(mProfileTimer, SIGNAL(timeout()), this, SLOT(updateHeat()));
     toggleAutoCompile(owner->autoCompileEnabled());
 
     setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
@@ -74,6 +78,33 @@ GL::Compiler* CodeEditor::compiler() const {
     return mCompiler;
 }
 
+void CodeEditor::setProfiling(bool on, bool gpu) {
+    mCompiler->setProfiling(on, gpu);
+    if (on) {
+        mProfileTimer->start();
+    } else {
+        mProfileTimer->stop();
+    }
+    updateHeat();
+}
+
+int CodeEditor::lineNumber(int pos) const {
+    QTextCursor cursor(document());
+    setErrPos(cursor, pos);
+    return cursor.block().blockNumber() + 1;
+}
+
+void CodeEditor::updateHeat() {
+    mHeat.clear();
+    if (mProfileTimer->isActive()) {
+        const GL::Runner::Profile& profile = mCompiler->runner()->profile();
+        for (auto it = profile.constBegin(); it != profile.constEnd(); ++it) {
+            mHeat[lineNumber(it.key()) - 1] += it.value().nsecs;
+        }
+    }
+    mLineNumberArea->update();
+}
+
 void CodeEditor::compile() {
     mCompileDelay->stop();
     int prevPos = mCompileErrorPos;
@@ -92,12 +123,24 @@ void CodeEditor::compile() {
     }
 }
 
-void CodeEditor::run() {
+void CodeEditor::run(bool async) {
+    runScript(false, async);
+}
+
+void CodeEditor::resume() {
+    runScript(true, false);
+}
+
+void CodeEditor::runScript(bool resume, bool async) {
     if (!mCompiler->ready()) return;
     int prevPos = mRunErrorPos;
     QString prevMsg = mRunError;
     try {
-        mCompiler->run();
+        if (resume) {
+            mCompiler->resume();
+        } else {
+            mCompiler->run(async);
+        }
         mRunErrorPos = -1;
     } catch (RunError& e) {
         mRunError = e.msg();
@@ -108,6 +151,8 @@ void CodeEditor::run() {
         highlightCurrentLine();
         emit statusChanged();
     }
+
+    if (mCompiler->suspended()) emit suspended();
 }
 
 
@@ -302,6 +347,8 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
     QPainter painter(mLineNumberArea);
     painter.fillRect(event->rect(), Qt::lightGray);
 
+    qint64 maxHeat = 0;
+    for (qint64 h: qAsConst(mHeat)) maxHeat = qMax(maxHeat, h);
 
     QTextBlock block = firstVisibleBlock();
     int blockNumber = block.blockNumber();
@@ -310,6 +357,11 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
 
     while (block.isValid() && top <= event->rect().bottom()) {
         if (block.isVisible() && bottom >= event->rect().top()) {
+            if (maxHeat > 0 && mHeat.contains(blockNumber)) {
+                // profiler heatmap: the hottest line is opaque red
+                int alpha = 40 + 215 * mHeat[blockNumber] / maxHeat;
+                painter.fillRect(0, top, 3, bottom - top, QColor(255, 0, 0, alpha));
+            }
             QString number = QString::number(blockNumber + 1);
             painter.setPen(Qt::black);
             painter.drawText(0, top, mLineNumberArea->width(), fontMetrics().height(), Qt::AlignRight, number);
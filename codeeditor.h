@@ -3,6 +3,7 @@
 
 #include <QPlainTextEdit>
 #include <QObject>
+#include <QMap>
 
 
 class QPaintEvent;
@@ -55,10 +56,15 @@ public:
 
     GL::Compiler* compiler() const;
 
+    void setProfiling(bool on, bool gpu);
+    // line number (from 1) of a source position
+    int lineNumber(int pos) const;
+
 public slots:
 
     void compile();
-    void run();
+    void run(bool async = false);
+    void resume();
 
 protected:
 
@@ -71,20 +77,25 @@ private slots:
     void highlightCurrentLine();
     void updateLineNumberArea(const QRect &, int);
     void insertCompletion(const QString& item);
+    void updateHeat();
 
 signals:
 
     void compiled();
     void statusChanged();
+    void suspended();
 
 private:
 
     void setErrPos(QTextCursor& cursor, int errpos) const;
+    void runScript(bool resume, bool async);
 
 private:
 
     QWidget* mLineNumberArea;
     QTimer* mCompileDelay;
+    QTimer* mProfileTimer;
+    QMap<int, qint64> mHeat; // block number -> nsecs
     QString mRunError;
     QString mCompileError;
     int mCompileErrorPos;
@@ -0,0 +1,100 @@
+#include "commandbuffer.h"
+
+using Math3D::Vector4;
+using Math3D::Matrix4;
+using Math3D::Quaternion;
+
+using namespace Demo::GL;
+
+CommandBuffer::CommandBuffer()
+    : mValid(false)
+    , mStepDeps(0)
+{}
+
+void CommandBuffer::clear() {
+    mValid = false;
+    mSteps.clear();
+    mCalls.clear();
+    mStores.clear();
+    mInputs.clear();
+    mInputBits.clear();
+    mDeps.clear();
+    mStepWrites.clear();
+}
+
+void CommandBuffer::begin() {
+    clear();
+}
+
+void CommandBuffer::beginStep() {
+    mStepDeps = 0;
+    mStepWrites.clear();
+}
+
+void CommandBuffer::endStep(int index, int jump) {
+    for (Variable* v: qAsConst(mStepWrites)) {
+        mDeps[v] = mStepDeps;
+        mStores.append({v, v->value()});
+    }
+    mSteps.append({index, jump, mStepDeps, mCalls.size(), mStores.size()});
+}
+
+void CommandBuffer::read(const Variable* var) {
+    auto it = mDeps.constFind(var);
+    if (it != mDeps.constEnd()) {
+        mStepDeps |= it.value();
+        return;
+    }
+    it = mInputBits.constFind(var);
+    if (it != mInputBits.constEnd()) {
+        mStepDeps |= it.value();
+        return;
+    }
+    // first read of a value set before this run
+    Mask bit = Volatile;
+    if (mInputs.size() < 63) {
+        bit = Mask(1) << mInputs.size();
+        mInputs.append({var, var->value()});
+    }
+    mInputBits[var] = bit;
+    mStepDeps |= bit;
+}
+
+void CommandBuffer::write(Variable* var) {
+    mStepWrites.append(var);
+}
+
+void CommandBuffer::call(Function* fun, const QVector<QVariant>& vals, int start) {
+    if (!fun->replayable()) {
+        mStepDeps |= Volatile;
+        return;
+    }
+    // the results of the other functions end up in stores and GL call arguments
+    if (fun->glFree()) return;
+    mCalls.append({fun, vals.mid(start, fun->argTypes().size())});
+}
+
+CommandBuffer::Mask CommandBuffer::changes() const {
+    Mask changed = Volatile;
+    for (int i = 0; i < mInputs.size(); i++) {
+        if (!SameValue(mInputs[i].var->value(), mInputs[i].value)) changed |= Mask(1) << i;
+    }
+    return changed;
+}
+
+bool CommandBuffer::SameValue(const QVariant& a, const QVariant& b) {
+    if (a.userType() != b.userType()) return false;
+    if (a.userType() == qMetaTypeId<Vector4>()) return a.value<Vector4>() == b.value<Vector4>();
+    if (a.userType() == qMetaTypeId<Matrix4>()) return a.value<Matrix4>() == b.value<Matrix4>();
+    if (a.userType() == qMetaTypeId<Quaternion>()) return a.value<Quaternion>() == b.value<Quaternion>();
+    if (a.userType() == QMetaType::QVariantList) {
+        const QVariantList& la = a.toList();
+        const QVariantList& lb = b.toList();
+        if (la.size() != lb.size()) return false;
+        for (int i = 0; i < la.size(); i++) {
+            if (!SameValue(la[i], lb[i])) return false;
+        }
+        return true;
+    }
+    return a == b;
+}
@@ -0,0 +1,102 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include "statement.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace Demo {
+namespace GL {
+
+// Record and replay: the GL calls and variable assignments of each
+// statement executed by one run of a script. Statements are tagged with
+// the inputs, i.e. variables read before assigned, they depend on. On
+// replay only the statements depending on changed inputs need to be
+// interpreted.
+class CommandBuffer: public Statement::Recorder {
+
+public:
+
+    using Mask = quint64;
+    // inputs that must be assumed to change, e.g. random numbers
+    static const Mask Volatile = Mask(1) << 63;
+
+    class Call {
+    public:
+        Function* fun;
+        QVector<QVariant> args;
+    };
+
+    class Store {
+    public:
+        Variable* var;
+        QVariant value;
+    };
+
+    class Step {
+    public:
+        int index; // statement
+        int jump;
+        Mask deps;
+        // ends of the calls and stores of this step
+        int calls;
+        int stores;
+    };
+
+    using StepVector = QVector<Step>;
+    using CallVector = QVector<Call>;
+    using StoreVector = QVector<Store>;
+
+    CommandBuffer();
+
+    bool valid() const {return mValid;}
+    void clear();
+
+    void begin();
+    void beginStep();
+    void endStep(int index, int jump);
+    void end() {mValid = true;}
+
+    // inputs whose values differ from the recorded ones
+    Mask changes() const;
+
+    const StepVector& steps() const {return mSteps;}
+    const CallVector& calls() const {return mCalls;}
+    const StoreVector& stores() const {return mStores;}
+
+    void read(const Variable* var) override;
+    void write(Variable* var) override;
+    void call(Function* fun, const QVector<QVariant>& vals, int start) override;
+
+private:
+
+    class Input {
+    public:
+        const Variable* var;
+        QVariant value;
+    };
+
+    using InputVector = QVector<Input>;
+    using MaskHash = QHash<const Variable*, Mask>;
+
+    static bool SameValue(const QVariant& a, const QVariant& b);
+
+private:
+
+    bool mValid;
+    StepVector mSteps;
+    CallVector mCalls;
+    StoreVector mStores;
+    InputVector mInputs;
+
+    // recording state
+    MaskHash mInputBits;
+    MaskHash mDeps;
+    Mask mStepDeps;
+    QVector<Variable*> mStepWrites;
+};
+
+}}
+
+#endif // COMMANDBUFFER_H
@@ -24,19 +24,23 @@
 
 #include "symbol.h"
 #include "math3d.h"
+#include "batchmath.h"
 
 #include <QVector>
 #include <QVector>
 #include <QVariant>
-#include <random>
 
 using Math3D::Vector4;
 using Math3D::Matrix4;
+using Math3D::Quaternion;
 
 
 #define COPY_AND_CLONE(T) T(const T& f): Function(f) {} \
                           T* clone() const override {return new T(*this);}
 
+#define BATCH_COPY_AND_CLONE(T) T(const T& f): BatchFunction(f) {} \
+                                T* clone() const override {return new T(*this);}
+
 
 namespace Demo {
 
@@ -44,6 +48,7 @@ using Real_T = BaseType<Math3D::Real>;
 using Integer_T = BaseType<Math3D::Integer>;
 using Vector_T = BaseType<Vector4>;
 using Matrix_T = BaseType<Matrix4>;
+using Quaternion_T = BaseType<Quaternion>;
 using Text_T = BaseType<QString>;
 
 class Function: public Symbol {
@@ -59,15 +64,33 @@ class Function: public Symbol {
 
         virtual const QVariant& execute(const QVector<QVariant>& vals, int start) = 0;
 
+        // false if the function needs the GUI thread, e.g. a current GL context
+        virtual bool glFree() const {return true;}
+
+        // false if a call may give a different result with the same
+        // arguments, e.g. random numbers, new GL names or GL queries
+        virtual bool replayable() const {return true;}
+
+        // profiler counters, updated by the statement evaluator
+        bool profiling() const {return mProfiling;}
+        void setProfiling(bool on) {mProfiling = on; mHits = 0; mNsecs = 0;}
+        void addSample(qint64 nsecs) {mHits += 1; mNsecs += nsecs;}
+        int hits() const {return mHits;}
+        qint64 nsecs() const {return mNsecs;}
+
     protected:
 
         Function(const QString& name, Type* type):
-            Symbol(name, type), mArgTypes(), mValue(), mIndex(0) {}
+            Symbol(name, type), mArgTypes(), mValue(), mIndex(0),
+            mProfiling(false), mHits(0), mNsecs(0) {}
 
         Function(const Function& f)
             : Symbol(f)
             , mValue()
-            , mIndex(f.index()) {
+            , mIndex(f.index())
+            , mProfiling(false)
+            , mHits(0)
+            , mNsecs(0) {
             for (auto t: f.argTypes()) {
                 mArgTypes << t->clone();
             }
@@ -85,6 +108,9 @@ class Function: public Symbol {
     private:
 
         unsigned  mIndex;
+        bool mProfiling;
+        int mHits;
+        qint64 mNsecs;
 };
 
 class StdFunction: public Function {
@@ -190,56 +216,6 @@ public:
 };
 
 
-class Random: public Function {
-
-public:
-
-    Random()
-        : Function("random", new Real_T)
-        , mDevice()
-        , mEngine(mDevice())
-        , mDist(0, 1)
-    {}
-
-    const QVariant& execute(const QVector<QVariant>&, int) override {
-        mValue.setValue(mDist(mEngine));
-        return mValue;
-    }
-
-    COPY_AND_CLONE(Random)
-
-private:
-    std::random_device mDevice;
-    std::default_random_engine mEngine;
-    std::uniform_real_distribution<Math3D::Real> mDist;
-};
-
-class RandomPos: public Function {
-
-public:
-
-    RandomPos()
-        : Function("randompos", new Vector_T)
-        , mDevice()
-        , mEngine(mDevice())
-        , mDist(0, 1)
-    {}
-
-    const QVariant& execute(const QVector<QVariant>&, int) override {
-        Vector4 v(mDist(mEngine), mDist(mEngine), mDist(mEngine), 1);
-        mValue.setValue(v);
-        return mValue;
-    }
-
-    COPY_AND_CLONE(RandomPos)
-
-private:
-    std::random_device mDevice;
-    std::default_random_engine mEngine;
-    std::uniform_real_distribution<Math3D::Real> mDist;
-};
-
-
 class FMod: public Function {
 
 public:
@@ -574,6 +550,222 @@ public:
     COPY_AND_CLONE(Size)
 };
 
+// Array of Vector functions running the Math3D::Batch kernels
+class BatchFunction: public Function {
+
+protected:
+
+    BatchFunction(const QString& name, Type* type): Function(name, type) {}
+    BatchFunction(const BatchFunction& f): Function(f) {}
+
+    static QVector<Vector4> vectors(const QVariant& v) {
+        QVector<Vector4> r;
+        auto list = v.toList();
+        r.reserve(list.size());
+        for (auto& item: list) r.append(item.value<Vector4>());
+        return r;
+    }
+
+    static QVariant variant(const QVector<Vector4>& vs) {
+        QVariantList list;
+        list.reserve(vs.size());
+        for (auto& v: vs) list.append(QVariant::fromValue(v));
+        return list;
+    }
+};
+
+class TransformPoints: public BatchFunction {
+
+public:
+
+    TransformPoints(): BatchFunction("transformpoints", new ArrayType(new Vector_T)) {
+        mArgTypes.append(new Matrix_T);
+        mArgTypes.append(new ArrayType(new Vector_T));
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        Matrix4 m = vals[start].value<Matrix4>();
+        QVector<Vector4> vs = vectors(vals[start + 1]);
+        Math3D::Batch::transformPoints(m, vs.constData(), vs.data(), vs.size(), true);
+        mValue = variant(vs);
+        return mValue;
+    }
+
+    BATCH_COPY_AND_CLONE(TransformPoints)
+};
+
+class TransformDirs: public BatchFunction {
+
+public:
+
+    TransformDirs(): BatchFunction("transformdirs", new ArrayType(new Vector_T)) {
+        mArgTypes.append(new Matrix_T);
+        mArgTypes.append(new ArrayType(new Vector_T));
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        Matrix4 m = vals[start].value<Matrix4>();
+        QVector<Vector4> vs = vectors(vals[start + 1]);
+        Math3D::Batch::transformDirections(m, vs.constData(), vs.data(), vs.size(), true);
+        mValue = variant(vs);
+        return mValue;
+    }
+
+    BATCH_COPY_AND_CLONE(TransformDirs)
+};
+
+class NormalizeAll: public BatchFunction {
+
+public:
+
+    NormalizeAll(): BatchFunction("normalizeall", new ArrayType(new Vector_T)) {
+        mArgTypes.append(new ArrayType(new Vector_T));
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        QVector<Vector4> vs = vectors(vals[start]);
+        Math3D::Batch::normalize(vs.data(), vs.size(), true);
+        mValue = variant(vs);
+        return mValue;
+    }
+
+    BATCH_COPY_AND_CLONE(NormalizeAll)
+};
+
+class CrossAll: public BatchFunction {
+
+public:
+
+    CrossAll(): BatchFunction("crossall", new ArrayType(new Vector_T)) {
+        mArgTypes.append(new ArrayType(new Vector_T));
+        mArgTypes.append(new ArrayType(new Vector_T));
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        QVector<Vector4> a = vectors(vals[start]);
+        QVector<Vector4> b = vectors(vals[start + 1]);
+        if (a.size() != b.size()) {
+            throw RunError("Array sizes differ", 0);
+        }
+        Math3D::Batch::cross(a.constData(), b.constData(), a.data(), a.size(), true);
+        mValue = variant(a);
+        return mValue;
+    }
+
+    BATCH_COPY_AND_CLONE(CrossAll)
+};
+
+// bounds(points) = array(min, max)
+class Bounds: public BatchFunction {
+
+public:
+
+    Bounds(): BatchFunction("bounds", new ArrayType(new Vector_T)) {
+        mArgTypes.append(new ArrayType(new Vector_T));
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        QVector<Vector4> vs = vectors(vals[start]);
+        QVector<Vector4> box(2);
+        Math3D::Batch::bounds(vs.constData(), vs.size(), box[0], box[1], true);
+        mValue = variant(box);
+        return mValue;
+    }
+
+    BATCH_COPY_AND_CLONE(Bounds)
+};
+
+// quaternion(angle, axis), angle in degrees as in rotation
+class Quat: public Function {
+
+public:
+
+    Quat(): Function("quaternion", new Quaternion_T) {
+        mArgTypes.append(new Real_T);
+        mArgTypes.append(new Vector_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        Math3D::Real angle = vals[start].value<Math3D::Real>() * Math3D::PI / 180;
+        Vector4 axis = vals[start + 1].value<Vector4>();
+        mValue.setValue(Quaternion::rotation(angle, axis));
+        return mValue;
+    }
+
+    COPY_AND_CLONE(Quat)
+};
+
+// slerp(q1, q2, t)
+class Slerp: public Function {
+
+public:
+
+    Slerp(): Function("slerp", new Quaternion_T) {
+        mArgTypes.append(new Quaternion_T);
+        mArgTypes.append(new Quaternion_T);
+        mArgTypes.append(new Real_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        Quaternion q1 = vals[start].value<Quaternion>();
+        Quaternion q2 = vals[start + 1].value<Quaternion>();
+        Math3D::Real t = vals[start + 2].value<Math3D::Real>();
+        mValue.setValue(Math3D::slerp(q1, q2, t));
+        return mValue;
+    }
+
+    COPY_AND_CLONE(Slerp)
+};
+
+// renormalize after long compositions
+class QuatNorm: public Function {
+
+public:
+
+    QuatNorm(): Function("quatnormalize", new Quaternion_T) {
+        mArgTypes.append(new Quaternion_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        mValue.setValue(vals[start].value<Quaternion>().normalized());
+        return mValue;
+    }
+
+    COPY_AND_CLONE(QuatNorm)
+};
+
+class QuatInverse: public Function {
+
+public:
+
+    QuatInverse(): Function("quatinverse", new Quaternion_T) {
+        mArgTypes.append(new Quaternion_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        mValue.setValue(vals[start].value<Quaternion>().conjugate());
+        return mValue;
+    }
+
+    COPY_AND_CLONE(QuatInverse)
+};
+
+class QuatMatrix: public Function {
+
+public:
+
+    QuatMatrix(): Function("quatmatrix", new Matrix_T) {
+        mArgTypes.append(new Quaternion_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        mValue.setValue(vals[start].value<Quaternion>().toMatrix());
+        return mValue;
+    }
+
+    COPY_AND_CLONE(QuatMatrix)
+};
+
 class Functions {
 
 public:
@@ -586,8 +778,6 @@ public:
         contents.append(new Vecx());
         contents.append(new VecPos());
         contents.append(new VecDir());
-        contents.append(new Random());
-        contents.append(new RandomPos());
         contents.append(new Mod());
         contents.append(new FMod());
         contents.append(new MatRow());
@@ -603,6 +793,16 @@ public:
         contents.append(new LookAt());
         contents.append(new Trace());
         contents.append(new Size());
+        contents.append(new TransformPoints());
+        contents.append(new TransformDirs());
+        contents.append(new NormalizeAll());
+        contents.append(new CrossAll());
+        contents.append(new Bounds());
+        contents.append(new Quat());
+        contents.append(new Slerp());
+        contents.append(new QuatNorm());
+        contents.append(new QuatInverse());
+        contents.append(new QuatMatrix());
         FUN(sin);
         FUN(cos);
         FUN(tan);
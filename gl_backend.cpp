@@ -0,0 +1,302 @@
+#include "gl_backend.h"
+
+#include <QIODevice>
+
+using namespace Demo::GL;
+
+
+NullBackend::NullBackend()
+    : mNames()
+    , mNextName(1)
+    , mError(GL_NO_ERROR)
+    , mArrayBuffer(0)
+    , mViewport{0, 0, 0, 0}
+{}
+
+void NullBackend::setError(GLenum err) {
+    // like GL, keep the first error until it is read
+    if (mError == GL_NO_ERROR) mError = err;
+}
+
+GLuint NullBackend::create(Kind kind) {
+    GLuint name = mNextName++;
+    mNames[name] = kind;
+    return name;
+}
+
+void NullBackend::generate(Kind kind, GLsizei n, GLuint* names) {
+    if (n < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < n; i++) names[i] = create(kind);
+}
+
+void NullBackend::remove(Kind kind, GLsizei n, const GLuint* names) {
+    if (n < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    // unknown names are silently ignored
+    for (GLsizei i = 0; i < n; i++) {
+        if (!exists(kind, names[i])) continue;
+        mNames.remove(names[i]);
+        if (kind == BufferName && names[i] == mArrayBuffer) mArrayBuffer = 0;
+    }
+}
+
+bool NullBackend::exists(Kind kind, GLuint name) const {
+    auto it = mNames.constFind(name);
+    return it != mNames.constEnd() && it.value() == kind;
+}
+
+void NullBackend::glGenTextures(GLsizei n, GLuint* textures) {
+    generate(TextureName, n, textures);
+}
+
+void NullBackend::glDeleteTextures(GLsizei n, const GLuint* textures) {
+    remove(TextureName, n, textures);
+}
+
+void NullBackend::glGenBuffers(GLsizei n, GLuint* buffers) {
+    generate(BufferName, n, buffers);
+}
+
+void NullBackend::glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    remove(BufferName, n, buffers);
+}
+
+void NullBackend::glGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    generate(FramebufferName, n, framebuffers);
+}
+
+void NullBackend::glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    remove(FramebufferName, n, framebuffers);
+}
+
+void NullBackend::glGenVertexArrays(GLsizei n, GLuint* arrays) {
+    generate(VertexArrayName, n, arrays);
+}
+
+void NullBackend::glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    remove(VertexArrayName, n, arrays);
+}
+
+void NullBackend::glGenQueries(GLsizei n, GLuint* ids) {
+    generate(QueryName, n, ids);
+}
+
+void NullBackend::glDeleteQueries(GLsizei n, const GLuint* ids) {
+    remove(QueryName, n, ids);
+}
+
+// no GPU, no time
+void NullBackend::glGetQueryObjectui64v(GLuint id, GLenum, GLuint64* params) {
+    if (!exists(QueryName, id)) {
+        setError(GL_INVALID_OPERATION);
+        return;
+    }
+    *params = 0;
+}
+
+GLuint NullBackend::glCreateShader(GLenum type) {
+    switch (type) {
+    case GL_VERTEX_SHADER:
+    case GL_TESS_CONTROL_SHADER:
+    case GL_TESS_EVALUATION_SHADER:
+    case GL_GEOMETRY_SHADER:
+    case GL_FRAGMENT_SHADER:
+    case GL_COMPUTE_SHADER:
+        return create(ShaderName);
+    default:
+        setError(GL_INVALID_ENUM);
+        return 0;
+    }
+}
+
+void NullBackend::glDeleteShader(GLuint shader) {
+    if (shader == 0) return;
+    if (!exists(ShaderName, shader)) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    mNames.remove(shader);
+}
+
+GLuint NullBackend::glCreateProgram() {
+    return create(ProgramName);
+}
+
+void NullBackend::glDeleteProgram(GLuint program) {
+    if (program == 0) return;
+    if (!exists(ProgramName, program)) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    mNames.remove(program);
+}
+
+GLboolean NullBackend::glIsTexture(GLuint texture) {
+    return exists(TextureName, texture) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean NullBackend::glIsBuffer(GLuint buffer) {
+    return exists(BufferName, buffer) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean NullBackend::glIsFramebuffer(GLuint framebuffer) {
+    return exists(FramebufferName, framebuffer) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean NullBackend::glIsVertexArray(GLuint array) {
+    return exists(VertexArrayName, array) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean NullBackend::glIsShader(GLuint shader) {
+    return exists(ShaderName, shader) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean NullBackend::glIsProgram(GLuint program) {
+    return exists(ProgramName, program) ? GL_TRUE : GL_FALSE;
+}
+
+// shaders always compile and programs always link
+void NullBackend::glGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    if (!exists(ShaderName, shader)) {
+        setError(exists(ProgramName, shader) ? GL_INVALID_OPERATION : GL_INVALID_VALUE);
+        return;
+    }
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+void NullBackend::glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    if (!exists(ProgramName, program)) {
+        setError(exists(ShaderName, program) ? GL_INVALID_OPERATION : GL_INVALID_VALUE);
+        return;
+    }
+    *params = pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS ? GL_TRUE : 0;
+}
+
+void NullBackend::glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (!exists(ShaderName, shader) || bufSize < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    if (length) *length = 0;
+    if (bufSize > 0) infoLog[0] = 0;
+}
+
+void NullBackend::glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (!exists(ProgramName, program) || bufSize < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    if (length) *length = 0;
+    if (bufSize > 0) infoLog[0] = 0;
+}
+
+void NullBackend::glGetIntegerv(GLenum pname, GLint* data) {
+    switch (pname) {
+    case GL_ARRAY_BUFFER_BINDING:
+        *data = mArrayBuffer;
+        break;
+    case GL_VIEWPORT:
+        for (int i = 0; i < 4; i++) data[i] = mViewport[i];
+        break;
+    default:
+        *data = 0;
+    }
+}
+
+GLint NullBackend::glGetUniformLocation(GLuint program, const GLchar*) {
+    if (!exists(ProgramName, program)) {
+        setError(GL_INVALID_VALUE);
+        return -1;
+    }
+    return 0;
+}
+
+GLint NullBackend::glGetAttribLocation(GLuint program, const GLchar*) {
+    if (!exists(ProgramName, program)) {
+        setError(GL_INVALID_VALUE);
+        return -1;
+    }
+    return 0;
+}
+
+GLenum NullBackend::glCheckFramebufferStatus(GLenum) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GLenum NullBackend::glGetError() {
+    GLenum err = mError;
+    mError = GL_NO_ERROR;
+    return err;
+}
+
+void NullBackend::glBindBuffer(GLenum target, GLuint buffer) {
+    // core profile: only generated names can be bound
+    if (buffer != 0 && !exists(BufferName, buffer)) {
+        setError(GL_INVALID_OPERATION);
+        return;
+    }
+    if (target == GL_ARRAY_BUFFER) mArrayBuffer = buffer;
+}
+
+void NullBackend::glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (width < 0 || height < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    mViewport[0] = x;
+    mViewport[1] = y;
+    mViewport[2] = width;
+    mViewport[3] = height;
+}
+
+void NullBackend::glBufferData(GLenum, GLsizeiptr size, const void*, GLenum) {
+    if (size < 0) setError(GL_INVALID_VALUE);
+}
+
+void NullBackend::glDrawArrays(GLenum, GLint first, GLsizei count) {
+    if (first < 0 || count < 0) setError(GL_INVALID_VALUE);
+}
+
+void NullBackend::glDrawElements(GLenum, GLsizei count, GLenum type, const void*) {
+    if (count < 0) {
+        setError(GL_INVALID_VALUE);
+        return;
+    }
+    if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT) {
+        setError(GL_INVALID_ENUM);
+    }
+}
+
+
+RecordingBackend::RecordingBackend(Backend* next, QIODevice* out)
+    : mNext(next)
+    , mStream(out)
+    , mCalls(0)
+{}
+
+RecordingBackend::~RecordingBackend() {
+    mStream.flush();
+    delete mNext;
+}
+
+RecordingBackend::Call::Call(RecordingBackend* parent, const char* name)
+    : mParent(parent)
+    , mFirst(true)
+{
+    mParent->mCalls++;
+    mParent->mStream << name << "(";
+}
+
+void RecordingBackend::Call::sep() {
+    if (!mFirst) mParent->mStream << ", ";
+    mFirst = false;
+}
+
+RecordingBackend::Call::~Call() {
+    mParent->mStream << ")\n";
+}
@@ -0,0 +1,246 @@
+#ifndef GL_BACKEND_H
+#define GL_BACKEND_H
+
+#include <QOpenGLFunctions_4_5_Core>
+#include <QHash>
+#include <QTextStream>
+
+class QIODevice;
+
+namespace Demo {
+namespace GL {
+
+// GL entry points used by scripts and blobs: return type, name,
+// parameters, arguments. The stateful ones get hand written
+// implementations in the null backend.
+#define GL_BACKEND_PLAIN(F) \
+    F(void, glActiveTexture, (GLenum texture), (texture)) \
+    F(void, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+    F(void, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+    F(void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+    F(void, glBindTexture, (GLenum target, GLuint texture), (target, texture)) \
+    F(void, glBindVertexArray, (GLuint array), (array)) \
+    F(void, glBlendColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    F(void, glBlendEquation, (GLenum mode), (mode)) \
+    F(void, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+    F(void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data)) \
+    F(void, glClear, (GLbitfield mask), (mask)) \
+    F(void, glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    F(void, glClearDepthf, (GLfloat d), (d)) \
+    F(void, glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha)) \
+    F(void, glCompileShader, (GLuint shader), (shader)) \
+    F(void, glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data), (target, level, internalformat, width, height, border, imageSize, data)) \
+    F(void, glCullFace, (GLenum mode), (mode)) \
+    F(void, glDepthFunc, (GLenum func), (func)) \
+    F(void, glDepthMask, (GLboolean flag), (flag)) \
+    F(void, glDepthRangef, (GLfloat n, GLfloat f), (n, f)) \
+    F(void, glDetachShader, (GLuint program, GLuint shader), (program, shader)) \
+    F(void, glDisable, (GLenum cap), (cap)) \
+    F(void, glDisableVertexAttribArray, (GLuint index), (index)) \
+    F(void, glDrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs)) \
+    F(void, glEnable, (GLenum cap), (cap)) \
+    F(void, glEnableVertexAttribArray, (GLuint index), (index)) \
+    F(void, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+    F(void, glFramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer), (target, attachment, texture, level, layer)) \
+    F(void, glFrontFace, (GLenum mode), (mode)) \
+    F(void, glGenerateMipmap, (GLenum target), (target)) \
+    F(GLboolean, glIsEnabled, (GLenum cap), (cap)) \
+    F(void, glLineWidth, (GLfloat width), (width)) \
+    F(void, glLinkProgram, (GLuint program), (program)) \
+    F(void, glMultiDrawElements, (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount), (mode, count, type, indices, drawcount)) \
+    F(void, glPatchParameteri, (GLenum pname, GLint value), (pname, value)) \
+    F(void, glPixelStorei, (GLenum pname, GLint param), (pname, param)) \
+    F(void, glQueryCounter, (GLuint id, GLenum target), (id, target)) \
+    F(void, glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units)) \
+    F(void, glShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), (shader, count, string, length)) \
+    F(void, glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask)) \
+    F(void, glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass)) \
+    F(void, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+    F(void, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+    F(void, glTexStorage1D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width), (target, levels, internalformat, width)) \
+    F(void, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+    F(void, glTexStorage3D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (target, levels, internalformat, width, height, depth)) \
+    F(void, glTexSubImage1D, (GLenum target, GLint level, GLint xoffset, GLsizei width, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, width, format, type, pixels)) \
+    F(void, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels)) \
+    F(void, glTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels)) \
+    F(void, glUniform1f, (GLint location, GLfloat v0), (location, v0)) \
+    F(void, glUniform1i, (GLint location, GLint v0), (location, v0)) \
+    F(void, glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2)) \
+    F(void, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3)) \
+    F(void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value)) \
+    F(void, glUseProgram, (GLuint program), (program)) \
+    F(void, glVertexAttrib1f, (GLuint index, GLfloat x), (index, x)) \
+    F(void, glVertexAttribI1i, (GLuint index, GLint x), (index, x)) \
+    F(void, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer))
+
+#define GL_BACKEND_STATEFUL(F) \
+    F(void, glGenTextures, (GLsizei n, GLuint* textures), (n, textures)) \
+    F(void, glDeleteTextures, (GLsizei n, const GLuint* textures), (n, textures)) \
+    F(void, glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+    F(void, glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers)) \
+    F(void, glGenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers)) \
+    F(void, glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers)) \
+    F(void, glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+    F(void, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays)) \
+    F(void, glGenQueries, (GLsizei n, GLuint* ids), (n, ids)) \
+    F(void, glDeleteQueries, (GLsizei n, const GLuint* ids), (n, ids)) \
+    F(void, glGetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params)) \
+    F(GLuint, glCreateShader, (GLenum type), (type)) \
+    F(void, glDeleteShader, (GLuint shader), (shader)) \
+    F(GLuint, glCreateProgram, (), ()) \
+    F(void, glDeleteProgram, (GLuint program), (program)) \
+    F(GLboolean, glIsTexture, (GLuint texture), (texture)) \
+    F(GLboolean, glIsBuffer, (GLuint buffer), (buffer)) \
+    F(GLboolean, glIsFramebuffer, (GLuint framebuffer), (framebuffer)) \
+    F(GLboolean, glIsVertexArray, (GLuint array), (array)) \
+    F(GLboolean, glIsShader, (GLuint shader), (shader)) \
+    F(GLboolean, glIsProgram, (GLuint program), (program)) \
+    F(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params)) \
+    F(void, glGetProgramiv, (GLuint program, GLenum pname, GLint* params), (program, pname, params)) \
+    F(void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog)) \
+    F(void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog)) \
+    F(void, glGetIntegerv, (GLenum pname, GLint* data), (pname, data)) \
+    F(GLint, glGetUniformLocation, (GLuint program, const GLchar* name), (program, name)) \
+    F(GLint, glGetAttribLocation, (GLuint program, const GLchar* name), (program, name)) \
+    F(GLenum, glCheckFramebufferStatus, (GLenum target), (target)) \
+    F(GLenum, glGetError, (), ()) \
+    F(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+    F(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    F(void, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage)) \
+    F(void, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+    F(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices))
+
+
+#define GL_BACKEND_FUNCTIONS(F) GL_BACKEND_PLAIN(F) GL_BACKEND_STATEFUL(F)
+
+
+// Everything GL goes through a backend. The real backend forwards to the
+// context, the null backend needs no context at all.
+class Backend {
+
+public:
+
+#define DECLARE(R, name, params, args) virtual R name params = 0;
+    GL_BACKEND_FUNCTIONS(DECLARE)
+#undef DECLARE
+
+    // false if there is no GL context behind the backend
+    virtual bool live() const = 0;
+
+    virtual ~Backend() = default;
+};
+
+
+class RealBackend: public Backend {
+
+public:
+
+    RealBackend(QOpenGLFunctions_4_5_Core* gl)
+        : mGL(gl) {}
+
+#define FORWARD(R, name, params, args) R name params override {return mGL->name args;}
+    GL_BACKEND_FUNCTIONS(FORWARD)
+#undef FORWARD
+
+    bool live() const override {return true;}
+
+private:
+
+    QOpenGLFunctions_4_5_Core* mGL;
+};
+
+
+// Hands out fake object names and checks the arguments it can check
+// without a context. Errors are reported by glGetError as usual.
+class NullBackend: public Backend {
+
+public:
+
+    NullBackend();
+
+#define SKIP(R, name, params, args) R name params override {ignore args; return R();}
+    GL_BACKEND_PLAIN(SKIP)
+#undef SKIP
+
+#define DECLARE(R, name, params, args) R name params override;
+    GL_BACKEND_STATEFUL(DECLARE)
+#undef DECLARE
+
+    bool live() const override {return false;}
+
+private:
+
+    template<typename... Args> static void ignore(Args...) {}
+
+    enum Kind {TextureName, BufferName, FramebufferName, VertexArrayName, ShaderName, ProgramName,
+               QueryName};
+
+    using NameHash = QHash<GLuint, Kind>;
+
+    void setError(GLenum err);
+    GLuint create(Kind kind);
+    void generate(Kind kind, GLsizei n, GLuint* names);
+    void remove(Kind kind, GLsizei n, const GLuint* names);
+    bool exists(Kind kind, GLuint name) const;
+
+private:
+
+    NameHash mNames;
+    GLuint mNextName;
+    GLenum mError;
+    GLuint mArrayBuffer;
+    GLint mViewport[4];
+};
+
+
+// Writes every call with its arguments, one per line, and then
+// passes it on.
+class RecordingBackend: public Backend {
+
+public:
+
+    // takes ownership of next
+    RecordingBackend(Backend* next, QIODevice* out);
+
+#define RECORD(R, name, params, args) R name params override {\
+    Call(this, #name) args; \
+    return mNext->name args;}
+    GL_BACKEND_FUNCTIONS(RECORD)
+#undef RECORD
+
+    bool live() const override {return mNext->live();}
+    int calls() const {return mCalls;}
+
+    ~RecordingBackend() override;
+
+private:
+
+    class Call {
+    public:
+        Call(RecordingBackend* parent, const char* name);
+        // no fold expressions in C++14
+        template<typename... Args> void operator() (Args... args) {
+            int dummy[] = {0, (put(args), 0)...};
+            Q_UNUSED(dummy)
+        }
+        ~Call();
+
+    private:
+        template<typename T> void put(T v) {sep(); mParent->mStream << v;}
+        template<typename T> void put(T* p) {sep(); mParent->mStream << "0x" << QString::number(quintptr(p), 16);}
+        void put(const GLchar* s) {sep(); mParent->mStream << '"' << s << '"';}
+        void put(GLboolean b) {sep(); mParent->mStream << (b ? "true" : "false");}
+        void sep();
+
+        RecordingBackend* mParent;
+        bool mFirst;
+    };
+
+    Backend* mNext;
+    QTextStream mStream;
+    int mCalls;
+};
+
+}} // namespace Demo::GL
+
+#endif // GL_BACKEND_H
@@ -39,29 +39,22 @@ class GLProc: public Demo::Function {
 public:
 
 
-#define ALT(item) case item: throw GLError(#item); break
-
     const QVariant& execute(const QVector<QVariant>& vals, int start) override {
 
         const QVariant& q = gl_execute(vals, start);
+        mParent->glCalled();
 
-        switch (glGetError()) {
-        ALT(GL_INVALID_ENUM);
-        ALT(GL_INVALID_VALUE);
-        ALT(GL_INVALID_OPERATION);
-        ALT(GL_STACK_UNDERFLOW);
-        ALT(GL_STACK_OVERFLOW);
-        ALT(GL_OUT_OF_MEMORY);
-        ALT(GL_INVALID_FRAMEBUFFER_OPERATION);
-        default: ;// nothing
+        // debug output is collected by a callback, checking it is cheap
+        if (mParent->errorPolicy() == GLWidget::CheckCalls ||
+                mParent->errorPolicy() == GLWidget::DebugOutput) {
+            mParent->throwOnError();
         }
 
         return q;
 
     }
 
-#undef ALT
-
+    bool glFree() const override {return false;}
 
 protected:
 
@@ -82,6 +75,41 @@ private:
 
 };
 
+// Caches blob name -> handle lookups. Text literals are interned by the
+// compiler, so a call site always passes the same string data.
+class BlobKeys {
+
+public:
+
+    using Resolver = int (Blob::*)(const QString&) const;
+
+    int find(const Blob& blob, int blobIndex, const QString& name, Resolver resolve) {
+        Key key(blobIndex, name.constData());
+        auto it = mEntries.find(key);
+        if (it != mEntries.end() && it->revision == blob.revision()) {
+            return it->handle;
+        }
+        // texts built at run time would grow the cache without bound
+        if (mEntries.size() > 256) mEntries.clear();
+        // the entry keeps the string data alive
+        Entry e{name, blob.revision(), (blob.*resolve)(name)};
+        mEntries[key] = e;
+        return e.handle;
+    }
+
+private:
+
+    using Key = QPair<int, const QChar*>;
+
+    struct Entry {
+        QString name;
+        unsigned revision;
+        int handle;
+    };
+
+    QHash<Key, Entry> mEntries;
+};
+
 #define COPY_AND_CLONE(T) T(const T& f): GLProc(f) {} \
                           T* clone() const override {return new T(*this);}
 
@@ -96,7 +124,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         // qCDebug(OGL) << "glEnable" << vals[start].value<Math3D::Integer>();
-        mParent->glEnable(vals[start].value<Math3D::Integer>());
+        mParent->backend()->glEnable(vals[start].value<Math3D::Integer>());
         mValue.setValue(0);
         return mValue;
     }
@@ -114,7 +142,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         // qCDebug(OGL) << "glDisable" << vals[start].value<Math3D::Integer>();
-        mParent->glDisable(vals[start].value<Math3D::Integer>());
+        mParent->backend()->glDisable(vals[start].value<Math3D::Integer>());
         mValue.setValue(0);
         return mValue;
     }
@@ -135,7 +163,7 @@ public:
         Math3D::Real near = vals[start].value<Math3D::Real>();
         Math3D::Real far = vals[start + 1].value<Math3D::Real>();
         // qCDebug(OGL) << "glDepthRange" << near << far;
-        mParent->glDepthRangef(near, far);
+        mParent->backend()->glDepthRangef(near, far);
         mValue.setValue(0);
         return mValue;
     }
@@ -154,7 +182,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Real w = vals[start].value<Math3D::Real>();
         // qCDebug(OGL) << "glLineWidth" << w;
-        mParent->glLineWidth(w);
+        mParent->backend()->glLineWidth(w);
         mValue.setValue(0);
         return mValue;
     }
@@ -173,7 +201,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Integer face = vals[start].value<Math3D::Integer>();
         // qCDebug(OGL) << "glFrontFace" << face;
-        mParent->glFrontFace(face);
+        mParent->backend()->glFrontFace(face);
         mValue.setValue(0);
         return mValue;
     }
@@ -192,7 +220,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Integer face = vals[start].value<Math3D::Integer>();
         // qCDebug(OGL) << "glCullFace" << face;
-        mParent->glCullFace(face);
+        mParent->backend()->glCullFace(face);
         mValue.setValue(0);
         return mValue;
     }
@@ -217,7 +245,7 @@ public:
         Math3D::Integer b = vals[start+2].value<Math3D::Integer>();
         Math3D::Integer a = vals[start+3].value<Math3D::Integer>();
         // qCDebug(OGL) << "glColorMask" << r << g << b << a;
-        mParent->glColorMask(r, g, b, a);
+        mParent->backend()->glColorMask(r, g, b, a);
         mValue.setValue(0);
         return mValue;
     }
@@ -236,7 +264,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Integer d = vals[start].value<Math3D::Integer>();
         // qCDebug(OGL) << "glDepthMask" << d;
-        mParent->glDepthMask(d);
+        mParent->backend()->glDepthMask(d);
         mValue.setValue(0);
         return mValue;
     }
@@ -255,7 +283,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Integer mask = vals[start].value<Math3D::Integer>();
         // qCDebug(OGL) << "glClear" << mask;
-        mParent->glClear(mask);
+        mParent->backend()->glClear(mask);
         mValue.setValue(0);
         return mValue;
     }
@@ -274,7 +302,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Vector4 color = vals[start].value<Vector4>();
         // qCDebug(OGL) << "glClearColor" << color[X] << color[Y] << color[Z] << color[W];
-        mParent->glClearColor(color[X], color[Y], color[Z], color[W]);
+        mParent->backend()->glClearColor(color[X], color[Y], color[Z], color[W]);
         mValue.setValue(0);
         return mValue;
     }
@@ -293,7 +321,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Math3D::Real depth = vals[start].value<Math3D::Real>();
         // qCDebug(OGL) << "glClearDepth" << depth;
-        mParent->glClearDepthf(depth);
+        mParent->backend()->glClearDepthf(depth);
         mValue.setValue(0);
         return mValue;
     }
@@ -315,6 +343,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(CreateShader)
 };
 
@@ -332,16 +362,16 @@ public:
         QByteArray bytes = vals[start+1].toString().toLatin1();
         const char *data = bytes.constData();
         // qCDebug(OGL) << "glShaderSource" << name;
-        mParent->glShaderSource(name, 1, &data, nullptr);
+        mParent->backend()->glShaderSource(name, 1, &data, nullptr);
         // qCDebug(OGL) << "glCompileShader" << name;
-        mParent->glCompileShader(name);
+        mParent->backend()->glCompileShader(name);
         int status;
-        mParent->glGetShaderiv(name, GL_COMPILE_STATUS, &status);
+        mParent->backend()->glGetShaderiv(name, GL_COMPILE_STATUS, &status);
         if (!status) {
             int len;
-            mParent->glGetShaderiv(name, GL_INFO_LOG_LENGTH, &len);
+            mParent->backend()->glGetShaderiv(name, GL_INFO_LOG_LENGTH, &len);
             char info[len];
-            mParent->glGetShaderInfoLog(name, len, &len, info);
+            mParent->backend()->glGetShaderInfoLog(name, len, &len, info);
             throw GLError(info);
         }
         mValue.setValue(0);
@@ -362,7 +392,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         int name = vals[start].value<int>();
         // qCDebug(OGL) << "glDeleteShader" << name;
-        if (!mParent->glIsShader(name)) {
+        if (!mParent->backend()->glIsShader(name)) {
             throw GLError(QString(R"("%1" is not a shader)").arg(name));
         }
         mParent->deresource("shader", name);
@@ -386,6 +416,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(CreateProgram)
 };
 
@@ -403,7 +435,7 @@ public:
         int prog = vals[start].value<int>();
         int shader = vals[start+1].value<int>();
         // qCDebug(OGL) << "glAttachShader" << prog << shader;
-        mParent->glAttachShader(prog, shader);
+        mParent->backend()->glAttachShader(prog, shader);
         mValue.setValue(0);
         return mValue;
     }
@@ -425,7 +457,7 @@ public:
         int prog = vals[start].value<int>();
         int shader = vals[start+1].value<int>();
         // qCDebug(OGL) << "glDetachShader" << prog << shader;
-        mParent->glDetachShader(prog, shader);
+        mParent->backend()->glDetachShader(prog, shader);
         mValue.setValue(0);
         return mValue;
     }
@@ -445,14 +477,14 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         int name = vals[start].value<int>();
         // qCDebug(OGL) << "glLinkProgram" << name;
-        mParent->glLinkProgram(name);
+        mParent->backend()->glLinkProgram(name);
         int status;
-        mParent->glGetProgramiv(name, GL_LINK_STATUS, &status);
+        mParent->backend()->glGetProgramiv(name, GL_LINK_STATUS, &status);
         if (!status) {
             int len;
-            mParent->glGetProgramiv(name, GL_INFO_LOG_LENGTH, &len);
+            mParent->backend()->glGetProgramiv(name, GL_INFO_LOG_LENGTH, &len);
             char info[len];
-            mParent->glGetProgramInfoLog(name, len, &len, info);
+            mParent->backend()->glGetProgramInfoLog(name, len, &len, info);
             throw GLError(info);
         }
         mValue.setValue(0);
@@ -474,7 +506,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         int name = vals[start].value<int>();
         // qCDebug(OGL) << "glUseProgram" << name;
-        mParent->glUseProgram(name);
+        mParent->backend()->glUseProgram(name);
         mValue.setValue(0);
         return mValue;
     }
@@ -494,7 +526,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         int name = vals[start].value<int>();
         // qCDebug(OGL) << "glDeleteProgram" << name;
-        if (!mParent->glIsProgram(name)) {
+        if (!mParent->backend()->glIsProgram(name)) {
             throw GLError(QString(R"("%1" is not a program)").arg(name));
         }
         mParent->deresource("program", name);
@@ -520,11 +552,13 @@ public:
         // qCDebug(OGL) << "glGetAttribLocation" << prog << name;
         QByteArray bytes = name.toLatin1();
         const char* data = bytes.constData();
-        int loc = mParent->glGetAttribLocation(prog, data);
+        int loc = mParent->backend()->glGetAttribLocation(prog, data);
         mValue.setValue(loc);
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GetAttribLocation)
 };
 
@@ -544,11 +578,13 @@ public:
         // qCDebug(OGL) << "glGetUniformLocation" << prog << name;
         QByteArray bytes = name.toLatin1();
         const char* data = bytes.constData();
-        int loc = mParent->glGetUniformLocation(prog, data);
+        int loc = mParent->backend()->glGetUniformLocation(prog, data);
         mValue.setValue(loc);
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GetUniformLocation)
 };
 
@@ -563,12 +599,14 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLenum pname = vals[start].value<int>();
         GLint v;
-        mParent->glGetIntegerv(pname, &v);
+        mParent->backend()->glGetIntegerv(pname, &v);
         // qCDebug(OGL) << "get integer" << pname << v;
         mValue.setValue(v);
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GetInteger)
 };
 
@@ -586,7 +624,7 @@ public:
         int loc = vals[start].value<int>();
         Math3D::Real uniform = vals[start+1].value<Math3D::Real>();
         // qCDebug(OGL) << "glUniform1f" << loc << uniform;
-        mParent->glUniform1f(loc, uniform);
+        mParent->backend()->glUniform1f(loc, uniform);
         mValue.setValue(0);
         return mValue;
     }
@@ -607,7 +645,7 @@ public:
         int loc = vals[start].value<int>();
         int uniform = vals[start+1].value<int>();
         // qCDebug(OGL) << "glUniform1i" << loc << uniform;
-        mParent->glUniform1i(loc, uniform);
+        mParent->backend()->glUniform1i(loc, uniform);
         mValue.setValue(0);
         return mValue;
     }
@@ -628,7 +666,7 @@ public:
         int loc = vals[start].value<int>();
         Vector4 uni = vals[start+1].value<Vector4>();
         // qCDebug(OGL) << "glUniform4f" << loc << uni[X] << uni[Y] << uni[Z] << uni[W];
-        mParent->glUniform4f(loc, uni[X], uni[Y], uni[Z], uni[W]);
+        mParent->backend()->glUniform4f(loc, uni[X], uni[Y], uni[Z], uni[W]);
         mValue.setValue(0);
         return mValue;
     }
@@ -649,7 +687,7 @@ public:
         int loc = vals[start].value<int>();
         Vector4 uni = vals[start+1].value<Vector4>();
         // qCDebug(OGL) << "glUniform4f" << loc << uni[X] << uni[Y] << uni[Z] << uni[W];
-        mParent->glUniform3f(loc, uni[X], uni[Y], uni[Z]);
+        mParent->backend()->glUniform3f(loc, uni[X], uni[Y], uni[Z]);
         mValue.setValue(0);
         return mValue;
     }
@@ -670,7 +708,7 @@ public:
         int loc = vals[start].value<int>();
         Matrix4 uni = vals[start+1].value<Matrix4>();
         // qCDebug(OGL) << "glUniformMatrix4F" << loc;
-        mParent->glUniformMatrix4fv(loc, 1, GL_FALSE, uni.readArray());
+        mParent->backend()->glUniformMatrix4fv(loc, 1, GL_FALSE, uni.readArray());
         mValue.setValue(0);
         return mValue;
     }
@@ -689,6 +727,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GenBuffer)
 };
 
@@ -703,7 +743,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "glDeleteBuffers" << name;
-        if (!mParent->glIsBuffer(name)) {
+        if (!mParent->backend()->glIsBuffer(name)) {
             throw GLError(QString(R"("%1" is not a buffer)").arg(name));
         }
         mParent->deresource("buffer", name);
@@ -728,7 +768,7 @@ public:
         GLuint target = vals[start].value<int>();
         GLuint buffer = vals[start+1].value<int>();
         // qCDebug(OGL) << "glBindBuffer" << target << buffer;
-        mParent->glBindBuffer(target, buffer);
+        mParent->backend()->glBindBuffer(target, buffer);
         mValue.setValue(0);
         return mValue;
     }
@@ -750,7 +790,7 @@ public:
         GLenum target = vals[start].value<int>();
         GLuint index = vals[start + 1].value<int>();
         GLuint buffer = vals[start + 2].value<int>();
-        mParent->glBindBufferBase(target, index, buffer);
+        mParent->backend()->glBindBufferBase(target, index, buffer);
         mValue.setValue(0);
         return mValue;
     }
@@ -805,7 +845,7 @@ public:
         traverse(vals[start+1]);
         GLuint usage = vals[start+2].value<int>();
         GLsizeiptr size = mData.size() * sizeof(GLfloat);
-        mParent->glBufferData(target, size, mData.constData(), usage);
+        mParent->backend()->glBufferData(target, size, mData.constData(), usage);
         mData.clear();
         mValue.setValue(0);
         return mValue;
@@ -830,7 +870,7 @@ public:
         GLintptr offset = vals[start+1].value<int>() * sizeof(GLfloat);
         traverse(vals[start+2]);
         GLsizeiptr size = mData.size() * sizeof(GLfloat);
-        mParent->glBufferSubData(target, offset, size, mData.constData());
+        mParent->backend()->glBufferSubData(target, offset, size, mData.constData());
         mData.clear();
         mValue.setValue(0);
         return mValue;
@@ -882,7 +922,14 @@ public:
         const Blob& blob = mParent->blob(vals[start+1].value<int>());
         GLuint usage = vals[start+2].value<int>();
         // qCDebug(OGL) << "glBufferData" << target << blob.name() << usage;
-        mParent->glBufferData(target, blob.bytelen(target), blob.bytes(target), usage);
+        mParent->backend()->glBufferData(target, blob.bytelen(target), blob.bytes(target), usage);
+        GLint buffer = 0;
+        if (target == GL_ARRAY_BUFFER) {
+            mParent->backend()->glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &buffer);
+        } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            mParent->backend()->glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
+        }
+        if (buffer != 0) blob.setUploaded(target, buffer);
         mValue.setValue(0);
         return mValue;
     }
@@ -910,7 +957,7 @@ public:
         GLboolean normalized = vals[start + 3].value<int>();
         GLsizei stride = vals[start + 4].value<int>() * sizeof(GLfloat);
         GLuint64 offset = vals[start + 5].value<int>() * sizeof(GLfloat);
-        mParent->glVertexAttribPointer(index,
+        mParent->backend()->glVertexAttribPointer(index,
                                        size,
                                        type,
                                        normalized,
@@ -935,12 +982,14 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint index = vals[start].value<int>();
-        const Blob& blob = mParent->blob(vals[start+1].value<int>());
+        int blobIndex = vals[start+1].value<int>();
+        const Blob& blob = mParent->blob(blobIndex);
         QString attr = vals[start+2].toString();
         // qCDebug(OGL) << "VertexAttribPointer" << index << blob.name() << attr;
-        const BlobSpec& spec = blob.spec(attr);
+        int key = mKeys.find(blob, blobIndex, attr, &Blob::specKey);
+        const BlobSpec spec = key < 0 ? BlobSpec() : blob.spec(key);
         // qCDebug(OGL) << "VertexAttribPointer" << spec.size << spec.offset;
-        mParent->glVertexAttribPointer(index,
+        mParent->backend()->glVertexAttribPointer(index,
                                        spec.size,
                                        spec.type,
                                        spec.normalized,
@@ -951,6 +1000,10 @@ public:
     }
 
     COPY_AND_CLONE(VertexAttribExtPointer)
+
+private:
+
+    BlobKeys mKeys;
 };
 
 class VertexAttrib1i: public GLProc {
@@ -965,7 +1018,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint index = vals[start].toInt();
         GLint v0 = vals[start+1].toInt();
-        mParent->glVertexAttribI1i(index, v0);
+        mParent->backend()->glVertexAttribI1i(index, v0);
         mValue.setValue(0);
         return mValue;
     }
@@ -985,7 +1038,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint index = vals[start].toInt();
         GLfloat v0 = vals[start+1].toFloat();
-        mParent->glVertexAttrib1f(index, v0);
+        mParent->backend()->glVertexAttrib1f(index, v0);
         mValue.setValue(0);
         return mValue;
     }
@@ -1004,16 +1057,131 @@ public:
     }
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
-        const Blob& blob = mParent->blob(vals[start].value<int>());
+        int blobIndex = vals[start].value<int>();
+        const Blob& blob = mParent->blob(blobIndex);
         QString attr = vals[start + 1].toString();
         GLuint mode = vals[start + 2].value<int>();
         // qCDebug(OGL) << "Draw" << blob.name() << attr << mode;
-        blob.draw(mode, attr);
+        int key = mKeys.find(blob, blobIndex, attr, &Blob::drawKey);
+        if (key < 0) {
+            throw RunError(QString("%1: no such model").arg(attr), 0);
+        }
+        blob.draw(mode, key);
         mValue.setValue(0);
         return mValue;
     }
 
     COPY_AND_CLONE(Draw)
+
+private:
+
+    BlobKeys mKeys;
+};
+
+// Model coordinates of quantized vertex positions: multiply the model
+// transform with it, the normals are not quantized.
+class Dequantization: public GLProc {
+
+public:
+
+    Dequantization(Demo::GLWidget* p): GLProc("dequantization", new Matrix_T, p) {
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Text_T);
+    }
+
+    const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
+        int blobIndex = vals[start].value<int>();
+        const Blob& blob = mParent->blob(blobIndex);
+        QString attr = vals[start + 1].toString();
+        int key = mKeys.find(blob, blobIndex, attr, &Blob::drawKey);
+        if (key < 0) {
+            throw RunError(QString("%1: no such model").arg(attr), 0);
+        }
+        mValue.setValue(blob.dequantization(key));
+        return mValue;
+    }
+
+    // the blob can change between calls
+    bool replayable() const override {return false;}
+
+    COPY_AND_CLONE(Dequantization)
+
+private:
+
+    BlobKeys mKeys;
+};
+
+// Level of detail of a model for the current viewport: the coarsest one
+// whose simplification plane distance projects to at most the given
+// pixels. The clip transform
+// maps model coordinates, without dequantization, to clip coordinates.
+class Lod: public GLProc {
+
+public:
+
+    Lod(Demo::GLWidget* p): GLProc("lod", new Integer_T, p) {
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Text_T);
+        mArgTypes.append(new Matrix_T);
+        mArgTypes.append(new Real_T);
+    }
+
+    const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
+        int blobIndex = vals[start].value<int>();
+        const Blob& blob = mParent->blob(blobIndex);
+        QString attr = vals[start + 1].toString();
+        Matrix4 clip = vals[start + 2].value<Matrix4>();
+        float pixels = vals[start + 3].toFloat();
+        int key = mKeys.find(blob, blobIndex, attr, &Blob::drawKey);
+        if (key < 0) {
+            throw RunError(QString("%1: no such model").arg(attr), 0);
+        }
+        // the viewport covers the widget, no need to ask GL
+        mValue.setValue(blob.lod(key, clip, mParent->width(), mParent->height(), pixels));
+        return mValue;
+    }
+
+    // the widget size can change between calls
+    bool replayable() const override {return false;}
+
+    COPY_AND_CLONE(Lod)
+
+private:
+
+    BlobKeys mKeys;
+};
+
+class DrawLod: public GLProc {
+
+public:
+
+    DrawLod(Demo::GLWidget* p): GLProc("drawlod", new Integer_T, p) {
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Text_T);
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Integer_T);
+    }
+
+    const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
+        int blobIndex = vals[start].value<int>();
+        const Blob& blob = mParent->blob(blobIndex);
+        QString attr = vals[start + 1].toString();
+        GLuint mode = vals[start + 2].value<int>();
+        int lod = vals[start + 3].value<int>();
+        int key = mKeys.find(blob, blobIndex, attr, &Blob::drawKey);
+        if (key < 0) {
+            throw RunError(QString("%1: no such model").arg(attr), 0);
+        }
+        blob.drawLod(mode, key, lod);
+        mValue.setValue(0);
+        return mValue;
+    }
+
+    COPY_AND_CLONE(DrawLod)
+
+private:
+
+    BlobKeys mKeys;
 };
 
 class DrawArrays: public GLProc {
@@ -1030,7 +1198,7 @@ public:
         GLenum mode = vals[start].value<int>();
         GLint first = vals[start + 1].value<int>();
         GLsizei count = vals[start + 2].value<int>();
-        mParent->glDrawArrays(mode, first, count);
+        mParent->backend()->glDrawArrays(mode, first, count);
         mValue.setValue(0);
         return mValue;
     }
@@ -1049,7 +1217,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "glEnableVertexAttribArray" << name;
-        mParent->glEnableVertexAttribArray(name);
+        mParent->backend()->glEnableVertexAttribArray(name);
         mValue.setValue(0);
         return mValue;
     }
@@ -1068,7 +1236,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "glDisableVertexAttribArray" << name;
-        mParent->glDisableVertexAttribArray(name);
+        mParent->backend()->glDisableVertexAttribArray(name);
         mValue.setValue(0);
         return mValue;
     }
@@ -1088,7 +1256,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "ActiveTexture" << name;
-        mParent->glActiveTexture(name);
+        mParent->backend()->glActiveTexture(name);
         mValue.setValue(0);
         return mValue;
     }
@@ -1108,7 +1276,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint target = vals[start].value<int>();
         // qCDebug(OGL) << "GenerateMipMap" << target;
-        mParent->glGenerateMipmap(target);
+        mParent->backend()->glGenerateMipmap(target);
         mValue.setValue(0);
         return mValue;
     }
@@ -1129,7 +1297,7 @@ public:
         GLuint target = vals[start].value<int>();
         GLuint texture = vals[start + 1].value<int>();
         // qCDebug(OGL) << "BindTexture" << target << texture;
-        mParent->glBindTexture(target, texture);
+        mParent->backend()->glBindTexture(target, texture);
         mValue.setValue(0);
         return mValue;
     }
@@ -1148,6 +1316,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GenTexture)
 };
 
@@ -1162,7 +1332,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "DeleteTexture" << name;
-        if (!mParent->glIsTexture(name)) {
+        if (!mParent->backend()->glIsTexture(name)) {
             throw GLError(QString(R"("%1" is not a texture)").arg(name));
         }
         mParent->deresource("texture", name);
@@ -1189,7 +1359,7 @@ public:
         GLuint name = vals[start + 1].value<int>();
         GLuint param = vals[start + 2].value<int>();
         // qCDebug(OGL) << "TexParameter" << target << name << param;
-        mParent->glTexParameteri(target, name, param);
+        mParent->backend()->glTexParameteri(target, name, param);
         mValue.setValue(0);
         return mValue;
     }
@@ -1210,7 +1380,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLenum pname = vals[start].value<int>();
         GLint value = vals[start + 1].value<int>();
-        mParent->glPatchParameteri(pname, value);
+        mParent->backend()->glPatchParameteri(pname, value);
         mValue.setValue(0);
         return mValue;
     }
@@ -1239,7 +1409,7 @@ public:
         // qCDebug(OGL) << "TexImage2D" << target << level << iformat << blob.name() << attr;
         const TexBlobSpec spec = blob.spec(attr);
         // qCDebug(OGL) << "TexImage2D" << spec.width << spec.height << spec.type;
-        mParent->glTexImage2D(target, level, iformat,
+        mParent->backend()->glTexImage2D(target, level, iformat,
                               spec.width, spec.height, 0, spec.format, spec.type, blob.readData(attr));
         mValue.setValue(0);
         return mValue;
@@ -1271,7 +1441,7 @@ public:
         GLsizei h = vals[start + 4].value<int>();
         GLenum format = vals[start + 5].value<int>();
         GLenum type = vals[start + 6].value<int>();
-        mParent->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid *) nullptr);
+        mParent->backend()->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid *) nullptr);
         mValue.setValue(0);
         return mValue;
     }
@@ -1313,7 +1483,7 @@ public:
         {
             GLubyte bytes[data.size()];
             for (int i = 0; i < data.size(); i++) bytes[i] = static_cast<GLubyte>(data[i]);
-            mParent->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) bytes);
+            mParent->backend()->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) bytes);
             break;
         }
         case GL_UNSIGNED_SHORT_5_6_5:
@@ -1323,7 +1493,7 @@ public:
         {
             GLushort shorts[data.size()];
             for (int i = 0; i < data.size(); i++) shorts[i] = static_cast<GLushort>(data[i]);
-            mParent->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) shorts);
+            mParent->backend()->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) shorts);
             break;
         }
         case GL_UNSIGNED_INT:
@@ -1331,14 +1501,14 @@ public:
         {
             GLuint ints[data.size()];
             for (int i = 0; i < data.size(); i++) ints[i] = static_cast<GLuint>(data[i]);
-            mParent->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) ints);
+            mParent->backend()->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) ints);
             break;
         }
         case GL_FLOAT:
         {
             GLfloat floats[data.size()];
             for (int i = 0; i < data.size(); i++) floats[i] = static_cast<GLfloat>(data[i]);
-            mParent->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) floats);
+            mParent->backend()->glTexImage2D(target, level, iformat, w, h, 0, format, type, (const GLvoid*) floats);
             break;
         }
         default:
@@ -1383,7 +1553,7 @@ public:
         {
             GLubyte bytes[data.size()];
             for (int i = 0; i < data.size(); i++) bytes[i] = static_cast<GLubyte>(data[i]);
-            mParent->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) bytes);
+            mParent->backend()->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) bytes);
             break;
         }
         case GL_UNSIGNED_SHORT_5_6_5:
@@ -1393,7 +1563,7 @@ public:
         {
             GLushort shorts[data.size()];
             for (int i = 0; i < data.size(); i++) shorts[i] = static_cast<GLushort>(data[i]);
-            mParent->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) shorts);
+            mParent->backend()->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) shorts);
             break;
         }
         case GL_UNSIGNED_INT:
@@ -1401,14 +1571,14 @@ public:
         {
             GLuint ints[data.size()];
             for (int i = 0; i < data.size(); i++) ints[i] = static_cast<GLuint>(data[i]);
-            mParent->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) ints);
+            mParent->backend()->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) ints);
             break;
         }
         case GL_FLOAT:
         {
             GLfloat floats[data.size()];
             for (int i = 0; i < data.size(); i++) floats[i] = static_cast<GLfloat>(data[i]);
-            mParent->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) floats);
+            mParent->backend()->glTexSubImage1D(target, level, xoffset, w, format, type, (const GLvoid*) floats);
             break;
         }
         default:
@@ -1437,7 +1607,7 @@ public:
         GLsizei levels = vals[start + 1].toInt();
         GLenum iformat = vals[start + 2].toInt();
         GLsizei w = vals[start + 3].toInt();
-        mParent->glTexStorage1D(target, levels, iformat, w);
+        mParent->backend()->glTexStorage1D(target, levels, iformat, w);
         mValue.setValue(0);
         return mValue;
     }
@@ -1461,7 +1631,7 @@ public:
         GLint y = vals[start + 1].value<int>();
         GLsizei w = vals[start + 2].value<int>();
         GLsizei h = vals[start + 3].value<int>();
-        mParent->glViewport(x, y, w, h);
+        mParent->backend()->glViewport(x, y, w, h);
         mValue.setValue(0);
         return mValue;
     }
@@ -1481,7 +1651,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint src = vals[start].value<int>();
         GLuint dst = vals[start + 1].value<int>();
-        mParent->glBlendFunc(src, dst);
+        mParent->backend()->glBlendFunc(src, dst);
         mValue.setValue(0);
         return mValue;
     }
@@ -1501,7 +1671,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint mode = vals[start].value<int>();
-        mParent->glBlendEquation(mode);
+        mParent->backend()->glBlendEquation(mode);
         mValue.setValue(0);
         return mValue;
     }
@@ -1519,7 +1689,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         Vector4 c = vals[start].value<Vector4>();
-        mParent->glBlendColor(c[X], c[Y], c[Z], c[W]);
+        mParent->backend()->glBlendColor(c[X], c[Y], c[Z], c[W]);
         mValue.setValue(0);
         return mValue;
     }
@@ -1540,7 +1710,7 @@ public:
         Math3D::Real factor = vals[start].value<Math3D::Real>();
         Math3D::Real units = vals[start + 1].value<Math3D::Real>();
         // qCDebug(OGL) << "glPolygonOffset" << depth;
-        mParent->glPolygonOffset(factor, units);
+        mParent->backend()->glPolygonOffset(factor, units);
         mValue.setValue(0);
         return mValue;
     }
@@ -1558,7 +1728,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint func = vals[start].value<int>();
-        mParent->glDepthFunc(func);
+        mParent->backend()->glDepthFunc(func);
         mValue.setValue(0);
         return mValue;
     }
@@ -1581,7 +1751,7 @@ public:
         GLuint func = vals[start].value<int>();
         GLint ref = vals[start+1].value<int>();
         GLuint mask = vals[start+2].value<int>();
-        mParent->glStencilFunc(func, ref, mask);
+        mParent->backend()->glStencilFunc(func, ref, mask);
         mValue.setValue(0);
         return mValue;
     }
@@ -1603,7 +1773,7 @@ public:
         GLuint sfail = vals[start].value<int>();
         GLuint dpfail = vals[start+1].value<int>();
         GLuint dppass = vals[start+2].value<int>();
-        mParent->glStencilOp(sfail, dpfail, dppass);
+        mParent->backend()->glStencilOp(sfail, dpfail, dppass);
         mValue.setValue(0);
         return mValue;
     }
@@ -1624,6 +1794,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GenFrameBuffer)
 };
 
@@ -1638,7 +1810,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
         // qCDebug(OGL) << "glDeleteFrameBuffers" << name;
-        if (!mParent->glIsFramebuffer(name)) {
+        if (!mParent->backend()->glIsFramebuffer(name)) {
             throw GLError(QString(R"("%1" is not a frame buffer)").arg(name));
         }
         mParent->deresource("frame_buffer", name);
@@ -1663,7 +1835,7 @@ public:
         GLuint target = vals[start].value<int>();
         GLuint buffer = vals[start+1].value<int>();
         // qCDebug(OGL) << "glBindFrameBuffer" << target << buffer;
-        mParent->glBindFramebuffer(target, buffer);
+        mParent->backend()->glBindFramebuffer(target, buffer);
         mValue.setValue(0);
         return mValue;
     }
@@ -1691,7 +1863,7 @@ public:
         GLuint texture = vals[start + 3].value<int>();
         GLint level = vals[start + 4].value<int>();
         // qCDebug(OGL) << "glFramebufferTexture2D" << GL_COLOR_ATTACHMENT0 << attachment << texture << level;
-        mParent->glFramebufferTexture2D(target, attachment, textarget, texture, level);
+        mParent->backend()->glFramebufferTexture2D(target, attachment, textarget, texture, level);
         mValue.setValue(0);
         return mValue;
     }
@@ -1718,7 +1890,7 @@ public:
         GLint level = vals[start + 3].value<int>();
         GLuint layer = vals[start + 4].value<int>();
         // qCDebug(OGL) << "glFramebufferTextureLayer" << target << name << param;
-        mParent->glFramebufferTextureLayer(target, attachment, texture, level, layer);
+        mParent->backend()->glFramebufferTextureLayer(target, attachment, texture, level, layer);
         mValue.setValue(0);
         return mValue;
     }
@@ -1737,7 +1909,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint target = vals[start].value<int>();
         // qCDebug(OGL) << "glCheckFramebufferStatus" << target;
-        GLuint status = mParent->glCheckFramebufferStatus(target);
+        GLuint status = mParent->backend()->glCheckFramebufferStatus(target);
         if (status != GL_FRAMEBUFFER_COMPLETE) {
             throw GLError(QString("Framebuffer is not complete (%1)").arg(status));
         }
@@ -1745,6 +1917,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(CheckFrameBufferStatus)
 };
 
@@ -1759,7 +1933,7 @@ public:
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint buf = vals[start].value<int>();
         // qCDebug(OGL) << "glDrawBuffer" << target;
-        mParent->glDrawBuffers(1, &buf);
+        mParent->backend()->glDrawBuffers(1, &buf);
         mValue.setValue(0);
         return mValue;
     }
@@ -1777,7 +1951,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint target = vals[start].value<int>();
-        mParent->glBindVertexArray(target);
+        mParent->backend()->glBindVertexArray(target);
         mValue.setValue(0);
         return mValue;
     }
@@ -1796,6 +1970,8 @@ public:
         return mValue;
     }
 
+    bool replayable() const override {return false;}
+
     COPY_AND_CLONE(GenVertexArray)
 };
 
@@ -1809,7 +1985,7 @@ public:
 
     const QVariant& gl_execute(const QVector<QVariant>& vals, int start) override {
         GLuint name = vals[start].value<int>();
-        if (!mParent->glIsVertexArray(name)) {
+        if (!mParent->backend()->glIsVertexArray(name)) {
             throw GLError(QString(R"("%1" is not a vertex array)").arg(name));
         }
         mParent->deresource("vertex_array", name);
@@ -1868,6 +2044,9 @@ public:
         contents.append(new VertexAttrib1f(p));
         contents.append(new VertexAttrib1i(p));
         contents.append(new Draw(p));
+        contents.append(new Dequantization(p));
+        contents.append(new Lod(p));
+        contents.append(new DrawLod(p));
         contents.append(new DrawArrays(p));
         contents.append(new EnableVertexAttribArray(p));
         contents.append(new DisableVertexAttribArray(p));
@@ -19,6 +19,7 @@
 // -----------------------------------------------------------------------
 
 #include <QtGlobal>
+#include <QSet>
 
 #include "gl_lang_compiler.h"
 #include "gl_lang_runner.h"
@@ -33,6 +34,7 @@
 #include "gl_lang_scanner.h"
 
 #include "scope.h"
+#include "gl_widget.h"
 #include "constant.h"
 #include "typedef.h"
 
@@ -44,6 +46,24 @@ using Math3D::Matrix4;
 
 using namespace Demo::GL;
 
+namespace {
+
+// the GL resources created during a run belong to the script
+class ScriptResources {
+public:
+    ScriptResources(Demo::GLWidget* context, const QString& script)
+        : mContext(context) {
+        if (mContext) mContext->beginScript(script);
+    }
+    ~ScriptResources() {
+        if (mContext) mContext->endScript();
+    }
+private:
+    Demo::GLWidget* mContext;
+};
+
+}
+
 
 Compiler::Compiler(const QString &name, Scope* globalScope, QObject *parent):
     QObject(parent),
@@ -56,9 +76,11 @@ Compiler::Compiler(const QString &name, Scope* globalScope, QObject *parent):
     mRunner(new Runner(this)),
     mReady(false),
     mRecompile(false),
+    mGLFree(true),
     mGlobalScope(globalScope) {
 
     setObjectName(name);
+    mRunner->setContext(globalScope->context());
 }
 
 
@@ -77,12 +99,13 @@ void Compiler::compile(const QString& script) {
     int err = gl_lang_parse(this, mScanner);
 
     if (!err) err = checkControls();
+    if (!err) err = checkYields();
 
     gl_lang_lex_destroy(mScanner);
 
     if (err) throw mError;
 
-    mRunner->setup(mStatements, mVariables, mGlobalScope->functions());
+    mRunner->setup(mStatements, mVariables, mExports, mGlobalScope->functions());
     mReady = true;
 }
 
@@ -105,12 +128,24 @@ int Compiler::checkControls() {
     return 1;
 }
 
+// a Yield outside the top level init script could not suspend
+int Compiler::checkYields() {
+    if (mRunner->yieldable()) return 0;
+    for (auto s: qAsConst(mStatements)) {
+        if (dynamic_cast<const Statement::Yield*>(s)) {
+            mError = CompileError("Yield outside the init script", s->pos());
+            return 1;
+        }
+    }
+    return 0;
+}
+
 bool Compiler::ready() const {
     return mReady || mRecompile;
 }
 
 
-void Compiler::run() {
+void Compiler::run(bool async) {
     if (mRecompile) {
         try {
             compile(mSource);
@@ -122,7 +157,69 @@ void Compiler::run() {
         throw RunError("Not compiled ", 0);
     }
     // qCDebug(OGL) << "running" << objectName();
-    mRunner->run();
+    if (async) {
+        mRunner->runAsync();
+    } else {
+        ScriptResources owner(mGlobalScope->context(), objectName());
+        mRunner->run();
+    }
+}
+
+void Compiler::resume() {
+    if (mRecompile || !mReady) {
+        run();
+        return;
+    }
+    ScriptResources owner(mGlobalScope->context(), objectName());
+    mRunner->resume();
+}
+
+bool Compiler::suspended() const {
+    return mReady && mRunner->suspended();
+}
+
+void Compiler::setTimeBudget(int msecs) {
+    mRunner->setTimeBudget(msecs);
+}
+
+int Compiler::timeBudget() const {
+    return mRunner->timeBudget();
+}
+
+void Compiler::setYieldable(bool on) {
+    mRunner->setYieldable(on);
+}
+
+void Compiler::setInstructionLimit(int limit) {
+    mRunner->setInstructionLimit(limit);
+}
+
+int Compiler::instructionLimit() const {
+    return mRunner->instructionLimit();
+}
+
+void Compiler::setTimeLimit(int msecs) {
+    mRunner->setTimeLimit(msecs);
+}
+
+int Compiler::timeLimit() const {
+    return mRunner->timeLimit();
+}
+
+int Compiler::instructions() const {
+    return mRunner->instructions();
+}
+
+void Compiler::setProfiling(bool on, bool gpu) {
+    mRunner->setProfiling(on, gpu);
+}
+
+void Compiler::setReplay(bool on) {
+    mRunner->setReplay(on);
+}
+
+bool Compiler::replay() const {
+    return mRunner->replay();
 }
 
 void Compiler::createError(const QString &item, QString detail) {
@@ -149,6 +246,7 @@ void Compiler::reset() {
 
     mReady = false;
     mRecompile = false;
+    mGLFree = true;
 
     mStackSize = 0;
     mStackPos = 0;
@@ -160,6 +258,7 @@ void Compiler::reset() {
 
     mCurrent.clear();
     mCurrImmed.clear();
+    mInterned.clear();
 
 
     qDeleteAll(mSymbols);
@@ -184,6 +283,7 @@ void Compiler::reset() {
     }
 
     mImportScripts.clear();
+    mGlobalImports.clear();
 
     addSymbol(new LocalVar("gl_result", new Integer_T));
 }
@@ -228,6 +328,16 @@ const QStringList& Compiler::subscripts() const {
 }
 
 
+const QStringList& Compiler::imports() const {
+    return mImportScripts;
+}
+
+
+const QStringList& Compiler::globalImports() const {
+    return mGlobalImports;
+}
+
+
 bool Compiler::isExported(const QString& name, const QString& script) const {
     if (script == "") { // global scope
         return mGlobalScope->exports().contains(name);
@@ -241,6 +351,7 @@ void Compiler::addImported(const QString& name, const QString& script) {
     Variable* v;
     if (script == "") { // global scope
         v = mGlobalScope->exports().value(name)->clone();
+        mGlobalImports.append(name);
     } else {
         v = mGlobalScope->compiler(script)->exports().value(name)->clone();
         if (!mImportScripts.contains(script)) {
@@ -268,6 +379,14 @@ void Compiler::addSubscript(const QString& name) {
     mSubscripts.append(name);
 }
 
+void Compiler::useFunction(const Function* fun) {
+    if (!fun->glFree()) mGLFree = false;
+}
+
+bool Compiler::glFree() const {
+    return mGLFree;
+}
+
 void Compiler::assignment() {
     LocationType* loc = gl_lang_get_lloc(mScanner);
     mStatements.append(new Statement::Assignment(mCurrent, mCurrImmed, mStackSize, loc->pos));
@@ -380,6 +499,11 @@ bool Compiler::endIf() {
     return true;
 }
 
+void Compiler::addYield() {
+    LocationType* loc = gl_lang_get_lloc(mScanner);
+    mStatements.append(new Statement::Yield(loc->pos));
+}
+
 
 void Compiler::pushBack(unsigned op, unsigned lrtype, int inc) {
     mCurrent.append((op & 0xfff) | ((lrtype & 0xff) << 12));
@@ -420,6 +544,14 @@ void Compiler::pushBackImmed(const QVariant& constVal) {
     mCurrImmed.append(constVal);
 }
 
+// equal text literals share their data: blob functions key their
+// name -> handle caches on it
+void Compiler::pushBackImmed(const QString& text) {
+    auto it = mInterned.constFind(text);
+    if (it == mInterned.constEnd()) it = mInterned.insert(text);
+    mCurrImmed.append(QVariant(*it));
+}
+
 void Compiler::setImmed(int index, int val) {
     mCurrImmed[index] = QVariant::fromValue(val);
 }
@@ -28,6 +28,7 @@
 #include <QVector>
 #include <QMap>
 #include <QStack>
+#include <QSet>
 #include <QtDebug>
 
 
@@ -86,7 +87,21 @@ public:
     // GL interface
     void compile(const QString& script);
     bool ready() const;
-    void run();
+    void run(bool async = false);
+    void resume();
+    bool suspended() const;
+    void setTimeBudget(int msecs);
+    int timeBudget() const;
+    void setYieldable(bool on);
+    void setInstructionLimit(int limit);
+    int instructionLimit() const;
+    void setTimeLimit(int msecs);
+    int timeLimit() const;
+    int instructions() const;
+    void setProfiling(bool on, bool gpu);
+    void setReplay(bool on);
+    bool replay() const;
+    const Runner* runner() const {return mRunner;}
 
     // grammar interface
     void assignment() override;
@@ -97,6 +112,7 @@ public:
     void pushBackImmed(int constVal) override;
     void pushBackImmed(Math3D::Real constVal) override;
     void pushBackImmed(const QVariant& constVal) override;
+    void pushBackImmed(const QString& text) override;
     void setImmed(int index, int val) override;
     int getImmed() const override;
     void createError(const QString& item, QString detail) override;
@@ -109,6 +125,7 @@ public:
     void addImported(const QString& v, const QString& script) override;
     bool isScript(const QString& name) const override;
     void addSubscript(const QString& name) override;
+    void useFunction(const Function* fun) override;
     void binit(const Type* t) override;
     void beginWhile() override;
     void beginIf() override;
@@ -116,9 +133,13 @@ public:
     bool endIf() override;
     bool addElse() override;
     bool addElsif() override;
+    void addYield() override;
 
     const QStringList& subscripts() const;
+    const QStringList& imports() const;
+    const QStringList& globalImports() const;
     const VariableMap& exports() const;
+    bool glFree() const;
 
     ~Compiler() override;
 
@@ -143,6 +164,7 @@ private:
 
     void reset();
     int checkControls();
+    int checkYields();
 
     class PendingJump {
     public:
@@ -174,6 +196,7 @@ private:
     SymbolMap mSymbols;
     CodeStack mCurrent;
     ValueStack mCurrImmed;
+    QSet<QString> mInterned;
     IndexStack mWhiles;
     PendingIfStack mConds;
     GuardJumpStack mGuardJumps;
@@ -186,9 +209,11 @@ private:
     Runner* mRunner;
     bool mReady;
     bool mRecompile;
+    bool mGLFree;
     QString mSource;
     Scope* mGlobalScope;
     QStringList mImportScripts;
+    QStringList mGlobalImports;
     QStringList mSubscripts;
     TypeList mTmpTypes;
 };
@@ -37,7 +37,7 @@ Completer::Completer(Scope* globalScope, CodeEditor *parent):
     mCompletionPos(-1) {
 
     mReserved << "Shared" << "Execute" << "From" << "import" <<
-                 "While" << "Endwhile" << "If" << "Else" << "Elsif" << "Endif" <<
+                 "While" << "Endwhile" << "Yield" << "If" << "Else" << "Elsif" << "Endif" <<
                  "Array" << "of" << "Type" << "Var" << "Record";
 
     mCompleter->setWidget(parent);
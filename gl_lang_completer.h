@@ -68,6 +68,7 @@ public:
     bool isScript(const QString& name) const override;
     void createError(const QString&, QString) override {}
     void addSubscript(const QString&) override {}
+    void useFunction(const Function*) override {}
     void binit(const Type*) override {}
     void assignment() override {}
     void pushBack(unsigned, unsigned, int) override {}
@@ -77,11 +78,13 @@ public:
     void pushBackImmed(int) override {}
     void pushBackImmed(Math3D::Real) override {}
     void pushBackImmed(const QVariant&) override {}
+    void pushBackImmed(const QString&) override {}
     void setImmed(int, int) override {}
     int getImmed() const override {return 0;}
     void beginWhile() override {}
     void beginIf() override {}
     bool endWhile() override {return true;}
+    void addYield() override {}
     bool endIf() override {return true;}
     bool addElse() override {return true;}
     bool addElsif() override {return true;}
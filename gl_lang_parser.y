@@ -75,7 +75,7 @@ using Demo::GL::Parser;
 
 %token <v_identifier> ID
 
-%token SHARED EXECUTE FROM IMPORT WHILE ENDWHILE IF ELSE ELSIF ENDIF ARRAY OF
+%token SHARED EXECUTE FROM IMPORT WHILE ENDWHILE YIELD IF ELSE ELSIF ENDIF ARRAY OF
 %token UNK BEGINSTRING ENDSTRING SEP TYPE VAR RECORD
 
 %token <v_int> '.'
@@ -341,6 +341,7 @@ statement: ID parameters {
   // qDebug() << "Code:" << opname(Parser::cFun) << fun->name() << fun->index();
   parser->pushBack(Parser::cFun, 0, 1 - $2.size());
   parser->pushBack(fun->index(), 0, 0);
+  parser->useFunction(fun);
   auto v = dynamic_cast<Variable*>(parser->symbol("gl_result"));
   parser->pushBack(Parser::cAss, 0, 0);
   parser->pushBack(v->index(), 0, 0);
@@ -359,6 +360,7 @@ statement: EXECUTE BEGINSTRING text ENDSTRING {
   auto dispatcher = dynamic_cast<Function*>(parser->symbol("dispatch"));
   parser->pushBack(Parser::cFun, 0, 0);
   parser->pushBack(dispatcher->index(), 0, 0);
+  parser->useFunction(dispatcher);
 
   auto v = dynamic_cast<Variable*>(parser->symbol("gl_result"));
   parser->pushBack(Parser::cAss, 0, 0);
@@ -380,6 +382,10 @@ statement: ENDWHILE {
   }
 };
 
+statement: YIELD {
+  parser->addYield();
+};
+
 statement: IF expression {
   if ($2->id() != Type::Integer) {
     HANDLE_ERROR("If", NOT_INTEGER_MSG);
@@ -555,6 +561,7 @@ factor: ID '(' parameters ')' {
   // qDebug() << "Code:" << opname(Parser::cFun) << fun->name();
   parser->pushBack(Parser::cFun, 0, 1 - $3.size());
   parser->pushBack(fun->index(), 0, 0);
+  parser->useFunction(fun);
 };
 
 
@@ -14,26 +14,37 @@ int GL::Parser::LRType(const Type* left, const Type* right) {
         {Type::Integer, Type::Vector, Parser::cIV},
         {Type::Integer, Type::Matrix, Parser::cIM},
         {Type::Integer, Type::Text, Parser::cIT},
+        {Type::Integer, Type::Quaternion, Parser::cIQ},
         {Type::Real, Type::Integer, Parser::cSI},
         {Type::Real, Type::Real, Parser::cSS},
         {Type::Real, Type::Vector, Parser::cSV},
         {Type::Real, Type::Matrix, Parser::cSM},
         {Type::Real, Type::Text, Parser::cST},
+        {Type::Real, Type::Quaternion, Parser::cSQ},
         {Type::Vector, Type::Integer, Parser::cVI},
         {Type::Vector, Type::Real, Parser::cVS},
         {Type::Vector, Type::Vector, Parser::cVV},
         {Type::Vector, Type::Matrix, Parser::cVM},
         {Type::Vector, Type::Text, Parser::cVT},
+        {Type::Vector, Type::Quaternion, Parser::cVQ},
         {Type::Matrix, Type::Integer, Parser::cMI},
         {Type::Matrix, Type::Real, Parser::cMS},
         {Type::Matrix, Type::Vector, Parser::cMV},
         {Type::Matrix, Type::Matrix, Parser::cMM},
         {Type::Matrix, Type::Text, Parser::cMT},
+        {Type::Matrix, Type::Quaternion, Parser::cMQ},
         {Type::Text, Type::Integer, Parser::cTI},
         {Type::Text, Type::Real, Parser::cTS},
         {Type::Text, Type::Vector, Parser::cTV},
         {Type::Text, Type::Matrix, Parser::cTM},
         {Type::Text, Type::Text, Parser::cTT},
+        {Type::Text, Type::Quaternion, Parser::cTQ},
+        {Type::Quaternion, Type::Integer, Parser::cQI},
+        {Type::Quaternion, Type::Real, Parser::cQS},
+        {Type::Quaternion, Type::Vector, Parser::cQV},
+        {Type::Quaternion, Type::Matrix, Parser::cQM},
+        {Type::Quaternion, Type::Text, Parser::cQT},
+        {Type::Quaternion, Type::Quaternion, Parser::cQQ},
         {-1, -1, 0}
     };
     int l = left->id();
@@ -118,6 +118,7 @@ public:
     virtual void pushBackImmed(int constVal) = 0;
     virtual void pushBackImmed(Math3D::Real constVal) = 0;
     virtual void pushBackImmed(const QVariant& constVal) = 0;
+    virtual void pushBackImmed(const QString& text) = 0;
     virtual void setImmed(int index, int val) = 0;
     virtual int getImmed() const = 0;
     virtual void createError(const QString& item, QString detail) = 0;
@@ -130,6 +131,7 @@ public:
     virtual void addImported(const QString& v, const QString& script) = 0;
     virtual bool isScript(const QString& name) const = 0;
     virtual void addSubscript(const QString& name) = 0;
+    virtual void useFunction(const Function* fun) = 0;
     virtual void binit(const Type* t) = 0;
     virtual void beginWhile() = 0;
     virtual void beginIf() = 0;
@@ -137,6 +139,7 @@ public:
     virtual bool endIf() = 0;
     virtual bool addElse() = 0;
     virtual bool addElsif() = 0;
+    virtual void addYield() = 0;
 
 
     // codes
@@ -148,11 +151,12 @@ public:
 
     // LR types
     enum LRTypes {
-        cII, cIS, cIV, cIM, cIT,
-        cSI, cSS, cSV, cSM, cST,
-        cVI, cVS, cVV, cVM, cVT,
-        cMI, cMS, cMV, cMM, cMT,
-        cTI, cTS, cTV, cTM, cTT
+        cII, cIS, cIV, cIM, cIT, cIQ,
+        cSI, cSS, cSV, cSM, cST, cSQ,
+        cVI, cVS, cVV, cVM, cVT, cVQ,
+        cMI, cMS, cMV, cMM, cMT, cMQ,
+        cTI, cTS, cTV, cTM, cTT, cTQ,
+        cQI, cQS, cQV, cQM, cQT, cQQ
     };
 
 
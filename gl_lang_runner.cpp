@@ -3,6 +3,8 @@
 #include "scope.h"
 #include "value.h"
 
+#include <QtConcurrent>
+
 using Math3D::Real;
 using Math3D::Vector4;
 using Math3D::Matrix4;
@@ -13,50 +15,416 @@ Runner::Runner(QObject* parent):
     QObject(parent),
     mStatements(),
     mVariables(),
-    mFunctions() {}
+    mFunctions(),
+    mContext(nullptr),
+    mYieldable(false),
+    mResume(0),
+    mTimeBudget(DefaultTimeBudget),
+    mInstructionLimit(DefaultInstructionLimit),
+    mTimeLimit(DefaultTimeLimit),
+    mInstructions(0),
+    mProfiling(false),
+    mGPUProfiling(false),
+    mReplay(false),
+    mReplayed(0),
+    mDivergences(0),
+    mRecordDelay(0),
+    mPending(false),
+    mFailed(false),
+    mBackInstructions(0),
+    mErrorPos(0) {}
 
 void Runner::setup(const StatementVector& sts,
                    const VariableMap& vars,
+                   const VariableMap& exports,
                    const FunctionVector& funcs) {
 
+    cancel();
+
+    // hot reload: locals and exports keep their values if name and type match
+    QMap<QString, const Variable*> prev;
+    for (const Variable* v: qAsConst(mVariables)) {
+        if (v->shared() && !mExports.contains(v->index())) continue; // imported
+        prev[v->name()] = v;
+    }
+    VariableIndexMap garbage = mVariables;
+
     qDeleteAll(mStatements);
     mStatements.clear();
-    qDeleteAll(mVariables);
     mVariables.clear();
+    qDeleteAll(mOwnFunctions);
+    mOwnFunctions.clear();
+    mExports.clear();
+    mResume = 0;
+    mInstructions = 0;
+    mProfile.clear();
+    mQueryStatements.clear();
+    mCommands.clear();
+    mReplayed = 0;
+    mDivergences = 0;
+    mRecordDelay = 0;
 
 
     mFunctions = funcs;
 
+    mYields.fill(false, sts.size());
     for (const Statement::Statement* s: sts) {
+        if (dynamic_cast<const Statement::Yield*>(s)) mYields.setBit(mStatements.size());
         mStatements.append(s->clone());
     }
 
     for (const Variable* v: vars.values()) {
         mVariables[v->index()] = v->clone();
     }
+
+    for (const Variable* v: exports.values()) {
+        mExports.append(v->index());
+    }
+
+    for (Variable* v: qAsConst(mVariables)) {
+        if (v->shared() && !mExports.contains(v->index())) continue;
+        const Variable* p = prev.value(v->name());
+        if (p && SameType(p->type(), v->type())) v->restore(p->storage());
+    }
+
+    qDeleteAll(garbage);
+}
+
+bool Runner::SameType(const Type* a, const Type* b) {
+    // assignable() converts integers to reals, ids don't tell compound types apart
+    return a->id() == b->id() && a->assignable(b) && b->assignable(a);
 }
 
 
 void Runner::run() {
-    int index = 0;
+    if (mPending) finish();
+    mResume = 0;
+    mInstructions = runFromStart();
+}
+
+void Runner::resume() {
+    if (mPending) finish();
+    int start = mResume;
+    mResume = 0;
+    if (start == 0) {
+        mInstructions = runFromStart();
+        return;
+    }
+    mInstructions = exec(mVariables, mFunctions, start, true);
+}
+
+void Runner::setReplay(bool on) {
+    mReplay = on;
+    mCommands.clear();
+    mDivergences = 0;
+    mRecordDelay = 0;
+}
+
+int Runner::runFromStart() {
+    mReplayed = 0;
+    // coroutines are interpreted
+    if (!mReplay || (mYieldable && mYields.count(true) > 0)) {
+        return exec(mVariables, mFunctions, 0, true);
+    }
+    if (mCommands.valid()) {
+        return execRecorded(mCommands.changes());
+    }
+    if (mRecordDelay > 0) {
+        mRecordDelay--;
+        return exec(mVariables, mFunctions, 0, true);
+    }
+    mCommands.begin();
+    setRecording(true);
+    int count;
+    try {
+        count = exec(mVariables, mFunctions, 0, true, true);
+    } catch (RunError&) {
+        setRecording(false);
+        mCommands.clear();
+        throw;
+    }
+    setRecording(false);
+    mCommands.end();
+    return count;
+}
+
+void Runner::setRecording(bool on) {
+    for (Statement::Statement* s: qAsConst(mStatements)) {
+        s->setRecorder(on ? &mCommands : nullptr);
+    }
+}
+
+// Replays the statements whose inputs have not changed since recording and
+// interprets the rest. If the control flow takes another path, the rest of
+// the script is interpreted and recorded again on the next run.
+int Runner::execRecorded(CommandBuffer::Mask changed) {
+    mClock.start();
+    const bool check = mContext && mContext->errorPolicy() == GLWidget::CheckStatements;
+    const bool profile = mProfiling;
+    const bool gpu = profile && mGPUProfiling && mContext;
+    if (gpu) collectQueries();
+    const CommandBuffer::CallVector& calls = mCommands.calls();
+    const CommandBuffer::StoreVector& stores = mCommands.stores();
+    QElapsedTimer clock;
+    int count = 0;
+    int call = 0;
+    int store = 0;
+    for (const CommandBuffer::Step& step: mCommands.steps()) {
+        Statement::Statement* s = mStatements[step.index];
+        bool timed = false;
+        if (gpu) timed = stamp(step.index);
+        if (profile) clock.start();
+        int jump = step.jump;
+        try {
+            if (step.deps & changed) {
+                jump = s->exec_and_jump(mVariables, mFunctions);
+                // e.g. a dispatched script may have written our inputs
+                if (step.deps & CommandBuffer::Volatile) changed |= mCommands.changes();
+            } else {
+                for (; call < step.calls; ++call) {
+                    Function* fun = calls[call].fun;
+                    if (fun->profiling()) {
+                        QElapsedTimer funClock;
+                        funClock.start();
+                        fun->execute(calls[call].args, 0);
+                        fun->addSample(funClock.nsecsElapsed());
+                    } else {
+                        fun->execute(calls[call].args, 0);
+                    }
+                }
+                for (; store < step.stores; ++store) {
+                    stores[store].var->setValue(stores[store].value);
+                }
+                ++mReplayed;
+            }
+            if (check) mContext->throwOnError();
+        } catch (RunError& e) {
+            if (timed) unstamp();
+            throw RunError(e.msg(), s->pos());
+        } catch (GL::GLError& e) {
+            if (timed) unstamp();
+            throw RunError(e.msg(), s->pos());
+        } catch (ValueError& e) {
+            if (timed) unstamp();
+            throw RunError(e.msg(), s->pos());
+        }
+        if (profile) {
+            Sample& sample = mProfile[s->pos()];
+            sample.hits += 1;
+            sample.nsecs += clock.nsecsElapsed();
+            if (timed) stamp(step.index);
+        }
+        ++count;
+        call = step.calls;
+        store = step.stores;
+        if (jump != step.jump) {
+            int next = step.index + jump;
+            mCommands.clear();
+            mDivergences = qMin(mDivergences + 1, 8);
+            mRecordDelay = (1 << mDivergences) - 1;
+            return count + exec(mVariables, mFunctions, next, true);
+        }
+    }
+    mDivergences = 0;
+    return count;
+}
+
+int Runner::exec(VariableIndexMap& vars, const FunctionVector& funcs, int start,
+                 bool foreground, bool record) {
+    if (foreground) mClock.start();
+    const bool check = foreground && mContext &&
+            mContext->errorPolicy() == GLWidget::CheckStatements;
+    const bool profile = foreground && mProfiling;
+    const bool gpu = profile && mGPUProfiling && mContext;
+    if (gpu) collectQueries();
+    QElapsedTimer clock;
+    QElapsedTimer watchdog;
+    watchdog.start();
+    int nextTimeCheck = TimeCheckInterval;
+    int count = 0;
+    int index = start;
     while (index < mStatements.size()) {
         Statement::Statement* s = mStatements[index];
+        if (foreground && mYieldable && mYields.testBit(index) && mClock.hasExpired(mTimeBudget)) {
+            mResume = index + 1;
+            return count;
+        }
+        int jump;
+        bool timed = false;
+        if (gpu) timed = stamp(index);
+        if (profile) clock.start();
         try {
-            index += s->exec_and_jump(mVariables, mFunctions);
+            if (record) mCommands.beginStep();
+            jump = s->exec_and_jump(vars, funcs);
+            if (record) mCommands.endStep(index, jump);
+            if (check) mContext->throwOnError();
         } catch (RunError& e) {
+            if (timed) unstamp();
             throw RunError(e.msg(), s->pos());
         } catch (GL::GLError& e) {
+            if (timed) unstamp();
             throw RunError(e.msg(), s->pos());
         } catch (ValueError& e) {
+            if (timed) unstamp();
             throw RunError(e.msg(), s->pos());
         }
+        if (profile) {
+            Sample& sample = mProfile[s->pos()];
+            sample.hits += 1;
+            sample.nsecs += clock.nsecsElapsed();
+            if (timed) stamp(index);
+        }
+        ++count;
+        // watchdog: only loops jump backwards, to their While statement
+        if (jump < 0 && count > mInstructionLimit) {
+            throw RunError(QString("Instruction limit (%1) exceeded").arg(mInstructionLimit),
+                           mStatements[index + jump]->pos());
+        }
+        if (jump < 0 && count >= nextTimeCheck) {
+            nextTimeCheck = count + TimeCheckInterval;
+            if (watchdog.hasExpired(mTimeLimit)) {
+                throw RunError(QString("Time limit (%1 ms) exceeded").arg(mTimeLimit),
+                               mStatements[index + jump]->pos());
+            }
+        }
+        index += jump;
+    }
+    return count;
+}
+
+void Runner::setProfiling(bool on, bool gpu) {
+    mProfiling = on;
+    mGPUProfiling = on && gpu;
+    mProfile.clear();
+    if (mGPUProfiling || mQueries.isEmpty() || !mContext) return;
+    mContext->makeCurrent();
+    mContext->backend()->glDeleteQueries(mQueries.size(), mQueries.data());
+    mQueries.clear();
+    mQueryStatements.clear();
+}
+
+// Timestamp query pairs bracket the profiled statements. The results are
+// read at the beginning of the next run, when the GPU has most likely
+// finished the previous frame.
+bool Runner::stamp(int index) {
+    int n = mQueryStatements.size();
+    if (n % 2 == 0) {
+        if (n == MaxQueries) return false;
+        if (n == mQueries.size()) {
+            mQueries.resize(n + 256);
+            mContext->backend()->glGenQueries(256, mQueries.data() + n);
+        }
+    }
+    mContext->backend()->glQueryCounter(mQueries[n], GL_TIMESTAMP);
+    mQueryStatements.append(index);
+    return true;
+}
+
+// a failed statement leaves its begin query unpaired: reuse it
+void Runner::unstamp() {
+    mQueryStatements.removeLast();
+}
+
+void Runner::collectQueries() {
+    for (int i = 0; i + 1 < mQueryStatements.size(); i += 2) {
+        GLuint64 t0, t1;
+        mContext->backend()->glGetQueryObjectui64v(mQueries[i], GL_QUERY_RESULT, &t0);
+        mContext->backend()->glGetQueryObjectui64v(mQueries[i + 1], GL_QUERY_RESULT, &t1);
+        int index = mQueryStatements[i];
+        if (index >= mStatements.size()) continue;
+        mProfile[mStatements[index]->pos()].gpuNsecs += t1 - t0;
     }
+    mQueryStatements.clear();
+}
+
+void Runner::runAsync() {
+    if (mPending) {
+        finish();
+    } else {
+        mInstructions = exec(mVariables, mFunctions);
+    }
+    start();
+}
+
+void Runner::start() {
+    // function instances keep their return values: the worker needs its own
+    if (mOwnFunctions.isEmpty()) {
+        bool forked = false;
+        for (const Function* f: mFunctions) {
+            Function* own = f->clone();
+            // random numbers from an engine of our own, so that runs do not
+            // depend on thread timing
+            auto random = dynamic_cast<RandomFunction*>(own);
+            if (random) {
+                if (!forked) mRandom = random->engine()->fork();
+                forked = true;
+                random->setEngine(&mRandom);
+            }
+            mOwnFunctions.append(own);
+        }
+    }
+
+    // snapshot the shared variables, locals are private to this runner anyway
+    mBackVariables = mVariables;
+    for (auto it = mVariables.constBegin(); it != mVariables.constEnd(); ++it) {
+        auto v = dynamic_cast<const SharedVar*>(it.value());
+        if (!v) continue;
+        LocalVar* snap = v->snapshot();
+        mSnapshots[it.key()] = snap;
+        mBackVariables[it.key()] = snap;
+    }
+
+    mFailed = false;
+    mPending = true;
+    mFuture = QtConcurrent::run([this] () {
+        try {
+            mBackInstructions = exec(mBackVariables, mOwnFunctions);
+        } catch (RunError& e) {
+            mFailed = true;
+            mError = e.msg();
+            mErrorPos = e.pos();
+        }
+    });
+}
+
+void Runner::finish() {
+    mFuture.waitForFinished();
+    mPending = false;
+    mInstructions = mBackInstructions;
+
+    if (!mFailed) {
+        for (unsigned index: qAsConst(mExports)) {
+            if (!mSnapshots.contains(index)) continue;
+            mVariables[index]->restore(mSnapshots[index]->storage());
+        }
+    }
+
+    qDeleteAll(mSnapshots);
+    mSnapshots.clear();
+    mBackVariables.clear();
+
+    if (mFailed) {
+        mFailed = false;
+        throw RunError(mError, mErrorPos);
+    }
+}
+
+void Runner::cancel() {
+    if (!mPending) return;
+    mFuture.waitForFinished();
+    mPending = false;
+    mFailed = false;
+    qDeleteAll(mSnapshots);
+    mSnapshots.clear();
+    mBackVariables.clear();
 }
 
 
 Runner::~Runner() {
+    cancel();
     qDeleteAll(mStatements);
     qDeleteAll(mVariables);
+    qDeleteAll(mOwnFunctions);
 }
 
 
@@ -2,15 +2,24 @@
 #define RUNNER_H
 
 #include "gl_lang_compiler.h"
+#include "commandbuffer.h"
+#include "random.h"
 
 #include <QString>
 #include <QStringList>
 #include <QStack>
 #include <QMap>
 #include <QVariant>
+#include <QFuture>
+#include <QBitArray>
+#include <QElapsedTimer>
 #include <QtDebug>
 
 namespace Demo {
+
+class LocalVar;
+class GLWidget;
+
 namespace GL {
 
 
@@ -25,7 +34,66 @@ public:
     using StatementVector = Compiler::StatementVector;
     using FunctionVector = Compiler::FunctionVector;
 
-    void setup(const StatementVector& sts, const VariableMap& vars, const FunctionVector& funcs);
+    void setup(const StatementVector& sts, const VariableMap& vars,
+               const VariableMap& exports, const FunctionVector& funcs);
+    void setContext(GLWidget* context) {mContext = context;}
+
+    // Worker thread interface: commit the results of the previous
+    // background run and start the next one. The first call runs
+    // the script synchronously.
+    void runAsync();
+
+    // Coroutine interface: continue a script suspended at a Yield
+    // statement, or run it from the start if it is not suspended.
+    void resume();
+    bool suspended() const {return mResume > 0;}
+    // time in milliseconds a script may run before yielding
+    void setTimeBudget(int msecs) {mTimeBudget = msecs;}
+    int timeBudget() const {return mTimeBudget;}
+    // Yield statements do not compile unless set. Only the top level init
+    // script yields: a subscript would return to its caller unfinished.
+    void setYieldable(bool on) {mYieldable = on;}
+    bool yieldable() const {return mYieldable;}
+
+    static const int DefaultTimeBudget = 10;
+
+    // Watchdog: a run is aborted when a loop iterates after this many
+    // statements have been executed, or after running this many
+    // milliseconds. The clock is read every TimeCheckInterval statements.
+    void setInstructionLimit(int limit) {mInstructionLimit = limit;}
+    int instructionLimit() const {return mInstructionLimit;}
+    void setTimeLimit(int msecs) {mTimeLimit = msecs;}
+    int timeLimit() const {return mTimeLimit;}
+    // statements executed by the last run (i.e. frame)
+    int instructions() const {return mInstructions;}
+
+    static const int DefaultInstructionLimit = 10000000;
+    static const int DefaultTimeLimit = 5000;
+    static const int TimeCheckInterval = 4096;
+
+    // Profiler: hit counts and CPU time, optionally GPU time, per
+    // statement. Statements are identified by their source position.
+    class Sample {
+    public:
+        Sample(): hits(0), nsecs(0), gpuNsecs(0) {}
+        int hits;
+        qint64 nsecs;
+        qint64 gpuNsecs;
+    };
+    using Profile = QMap<int, Sample>;
+
+    void setProfiling(bool on, bool gpu = false);
+    const Profile& profile() const {return mProfile;}
+
+    static const int MaxQueries = 4096;
+
+    // Record and replay: a run from the start replays the command buffer
+    // of an earlier run, only the statements depending on changed
+    // inputs are interpreted. Off by default.
+    void setReplay(bool on);
+    bool replay() const {return mReplay;}
+    // statements replayed from the command buffer by the last run
+    int replayed() const {return mReplayed;}
 
     ~Runner() override;
 
@@ -40,13 +108,68 @@ private:
     Runner &operator=(const Runner&); // Not implemented
 
     using VariableIndexMap = Demo::Statement::Statement::VariableIndexMap;
-
+    using SnapshotMap = QMap<unsigned, Demo::LocalVar*>;
+
+    // foreground runs may yield and check for GL errors
+    int exec(VariableIndexMap& vars, const FunctionVector& funcs, int start = 0,
+             bool foreground = false, bool record = false);
+    int runFromStart();
+    int execRecorded(CommandBuffer::Mask changed);
+    void setRecording(bool on);
+    void start();
+    void finish();
+    void cancel();
+    bool stamp(int index);
+    void unstamp();
+    void collectQueries();
+
+    static bool SameType(const Type* a, const Type* b);
 
 private:
 
     StatementVector mStatements;
     VariableIndexMap mVariables;
     FunctionVector mFunctions;
+    QVector<unsigned> mExports;
+    GLWidget* mContext;
+
+    // coroutine state
+    QBitArray mYields;
+    bool mYieldable;
+    int mResume;
+    int mTimeBudget;
+    QElapsedTimer mClock;
+
+    int mInstructionLimit;
+    int mTimeLimit;
+    int mInstructions;
+
+    // profiler state
+    bool mProfiling;
+    bool mGPUProfiling;
+    Profile mProfile;
+    QVector<unsigned> mQueries;
+    QVector<int> mQueryStatements;
+
+    // record and replay state
+    bool mReplay;
+    CommandBuffer mCommands;
+    int mReplayed;
+    // back off from recording scripts that keep diverging
+    int mDivergences;
+    int mRecordDelay;
+
+    // worker thread state
+    VariableIndexMap mBackVariables;
+    SnapshotMap mSnapshots;
+    FunctionVector mOwnFunctions;
+    RandomEngine mRandom;
+    QFuture<void> mFuture;
+    bool mPending;
+    bool mFailed;
+    int mBackInstructions;
+    QString mError;
+    int mErrorPos;
 };
 
 
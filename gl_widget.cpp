@@ -15,6 +15,7 @@
 #include <QDir>
 #include <QApplication>
 #include <QTimer>
+#include <QOpenGLDebugLogger>
 
 using Math3D::Matrix4;
 using Math3D::Vector4;
@@ -46,6 +47,36 @@ public:
         return new CameraConstraint(*this);
     }
 
+    bool glFree() const override {return false;}
+
+private:
+
+    GLWidget* mParent;
+};
+
+// camera * model in double precision, for models far from the origin
+class CameraRelative: public Function {
+public:
+    CameraRelative(GLWidget* p)
+        : Function("camerarelative", new Matrix_T)
+        , mParent(p)
+    {
+        mArgTypes.append(new Matrix_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        mValue.setValue(mParent->cameraRelative(vals[start].value<Matrix4>()));
+        return mValue;
+    }
+
+    CameraRelative* clone() const override {
+        return new CameraRelative(*this);
+    }
+
+    // reads the camera directly, not through the camera variable
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
+
 private:
 
     GLWidget* mParent;
@@ -68,6 +99,9 @@ public:
         return new DefaultFrameBuffer(*this);
     }
 
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
+
 private:
     GLWidget* mParent;
 };
@@ -89,6 +123,9 @@ public:
         return new Paused(*this);
     }
 
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
+
 private:
     GLWidget* mParent;
 };
@@ -111,6 +148,9 @@ public:
         return new RegisterSource(*this);
     }
 
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
+
 private:
     GLWidget* mParent;
 };
@@ -136,6 +176,9 @@ public:
         return new ReadFromSource(*this);
     }
 
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
+
 private:
     GLWidget* mParent;
 };
@@ -143,8 +186,8 @@ private:
 
 #define ALT(item) case item: return QString(#item);
 
-static QString checkError() {
-    switch (glGetError()) {
+static QString checkError(GL::Backend* backend) {
+    switch (backend->glGetError()) {
         ALT(GL_INVALID_ENUM);
         ALT(GL_INVALID_VALUE);
         ALT(GL_INVALID_OPERATION);
@@ -159,7 +202,7 @@ static QString checkError() {
 
 #undef ALT
 
-#define CHECK_GL do {QString msg = checkError(); if (!msg.isEmpty()) {qCWarning(OGL) << msg;}} while (false)
+#define CHECK_GL do {QString msg = checkError(mBackend); if (!msg.isEmpty()) {qCWarning(OGL) << msg;}} while (false)
 
 
 #define updateGL update
@@ -168,6 +211,7 @@ GLWidget::GLWidget(QWidget *parent)
     : QOpenGLWidget(parent)
     , OpenGLFunctions()
     , mInitialized(false)
+    , mInitDone(false)
     , mDim(500)
     , mMover(new Mover(this))
     , mNear(.1)
@@ -176,6 +220,13 @@ GLWidget::GLWidget(QWidget *parent)
     , mEncoder(nullptr)
     , mDownloader(nullptr)
     , mRecording(false)
+    , mDrawing(false)
+    , mInitSuspended(false)
+    , mErrorPolicy(CheckStatements)
+    , mRequestedPolicy(CheckStatements)
+    , mGLCalled(false)
+    , mBackend(new GL::RealBackend(this))
+    , mDebugLogger(nullptr)
     , mMaxFrames(25*60)
 {
 
@@ -203,6 +254,8 @@ void GLWidget::addGLSymbols(SymbolMap& globals, VariableMap& exports) {
 
     Function* func = new CameraConstraint(this);
     globals[func->name()] = func;
+    func = new CameraRelative(this);
+    globals[func->name()] = func;
     func = new DefaultFrameBuffer(this);
     globals[func->name()] = func;
     func = new Paused(this);
@@ -313,6 +366,7 @@ GL::TexBlob* Demo::GLWidget::texBlob(const SymbolMap& globals, const QString& na
 
 Demo::GLWidget::~GLWidget() {
     delete mCamera;
+    delete mBackend;
     for (DataCache& c: mDataCache.values()) {
         c.source->stop();
         c.source->wait(1000);
@@ -328,10 +382,66 @@ void Demo::GLWidget::initializeGL() {
             qFatal("initializeOpenGLFunctions failed");
         }
         mInitialized = true;
+        if (mErrorPolicy == DebugOutput) setupDebugOutput();
         emit openGLReady(mInitialized);
     }
 }
 
+void Demo::GLWidget::setBackend(GL::Backend* backend) {
+    delete mBackend;
+    mBackend = backend;
+    if (!mBackend->live()) mInitialized = true;
+}
+
+void Demo::GLWidget::setErrorPolicy(ErrorPolicy policy) {
+    mErrorPolicy = policy;
+    mRequestedPolicy = policy;
+    mDebugError.clear();
+    if (!mInitialized) return;
+    makeCurrent();
+    if (mErrorPolicy == DebugOutput) {
+        setupDebugOutput();
+    } else if (mDebugLogger && mDebugLogger->isLogging()) {
+        mDebugLogger->stopLogging();
+    }
+}
+
+void Demo::GLWidget::setupDebugOutput() {
+    if (!mDebugLogger) {
+        mDebugLogger = new QOpenGLDebugLogger(this);
+        connect(mDebugLogger, SIGNAL(messageLogged(QOpenGLDebugMessage)),
+                this, SLOT(debugMessage(QOpenGLDebugMessage)));
+    }
+    if (mDebugLogger->isLogging()) return;
+    if (!mDebugLogger->initialize()) {
+        qCWarning(OGL) << "No debug context: checking GL errors per statement";
+        mErrorPolicy = CheckStatements;
+        return;
+    }
+    // synchronous: messages arrive before the offending call returns
+    mDebugLogger->startLogging(QOpenGLDebugLogger::SynchronousLogging);
+}
+
+void Demo::GLWidget::debugMessage(const QOpenGLDebugMessage& msg) {
+    if (msg.type() != QOpenGLDebugMessage::ErrorType) {
+        qCDebug(OGL) << msg.message();
+        return;
+    }
+    if (mDebugError.isEmpty()) mDebugError = msg.message();
+}
+
+void Demo::GLWidget::throwOnError() {
+    QString msg;
+    if (mErrorPolicy == DebugOutput) {
+        msg = mDebugError;
+        mDebugError.clear();
+    } else if (mErrorPolicy != CheckStatements || mGLCalled) {
+        msg = checkError(mBackend);
+    }
+    mGLCalled = false;
+    if (!msg.isEmpty()) throw GL::GLError(msg);
+}
+
 void Demo::GLWidget::saveToDisk(bool on, const QString& basePath) {
     if (on) {
         if (mRecording) return;
@@ -398,20 +508,42 @@ void Demo::GLWidget::dataSourceClosed() {
 
 void Demo::GLWidget::paintGL()
 {
-    emit draw();
+    drawFrame();
     if (!mRecording) return;
     mDownloader->readFrame();
 }
 
+void Demo::GLWidget::drawFrame() {
+    // continue a time-sliced init script, draw when it has completed
+    if (mInitSuspended) {
+        mInitSuspended = false;
+        emit resume();
+        if (mInitSuspended) return;
+        mInitDone = true;
+    }
+    mDrawing = true;
+    emit draw();
+    mDrawing = false;
+}
+
 void Demo::GLWidget::initChanged() {
     if (!mInitialized) return;
     makeCurrent();
     CHECK_GL;
+    mInitDone = false;
     defaults();
+    mInitSuspended = false;
     emit init();
+    // a suspended init is done after its last slice
+    mInitDone = !mInitSuspended;
     updateGL();
 }
 
+void Demo::GLWidget::initSuspended() {
+    mInitSuspended = true;
+    update();
+}
+
 void Demo::GLWidget::drawChanged() {
     makeCurrent();
     CHECK_GL;
@@ -429,7 +561,7 @@ void Demo::GLWidget::realResize() {
     // qCDebug(OGL) << "resizing";
     int w = mWidthVar->value().toInt();
     int h = mHeightVar->value().toInt();
-    glViewport(0, 0, w, h);
+    mBackend->glViewport(0, 0, w, h);
     CHECK_GL;
     Real a = Real(w) / Real(h);
     Real ct = 1 / tan(Math3D::PI / 180 * 45 / 2);
@@ -459,7 +591,13 @@ void Demo::GLWidget::realResize() {
     mInvProjVar->setValue(QVariant::fromValue(invproj));
 
     // init statements might depend on the viewport or projection
-    initChanged();
+    if (!mInitDone) {
+        initChanged();
+        return;
+    }
+    makeCurrent();
+    emit resized();
+    updateGL();
 }
 
 void Demo::GLWidget::setProjection(float near, float far) {
@@ -567,6 +705,10 @@ void Demo::GLWidget::move() {
     mMover->move();
 }
 
+Matrix4 Demo::GLWidget::cameraRelative(const Matrix4& model) const {
+    return mCamera->relative(model);
+}
+
 void Demo::GLWidget::cameraStop() {
     if (mTimer->isActive()) mTimer->stop();
     // revert last op
@@ -617,45 +759,22 @@ void Demo::GLWidget::keyPressEvent(QKeyEvent* ev) {
 
 
 GLuint Demo::GLWidget::resource(const QString &res, GLenum param) {
-    if (res == "texture") {
-        auto r = new Texture(this);
-        CHECK_GL;
-        mResources[QString("texture_%1").arg(r->name)] = r;
-        return r->name;
-    }
-    if (res == "shader") {
-        auto r = new Shader(this, param);
-        mResources[QString("shader_%1").arg(r->name)] = r;
-        CHECK_GL;
-        return r->name;
-    }
-    if (res == "program") {
-        auto r = new Program(this);
-        mResources[QString("program_%1").arg(r->name)] = r;
-        CHECK_GL;
-        return r->name;
-    }
-    if (res == "buffer") {
-        auto r = new Buffer(this);
-        mResources[QString("buffer_%1").arg(r->name)] = r;
-        CHECK_GL;
-        return r->name;
-    }
-    if (res == "frame_buffer") {
-        auto r = new FrameBuffer(this);
-        mResources[QString("frame_buffer_%1").arg(r->name)] = r;
-        CHECK_GL;
-        return r->name;
-    }
-    if (res == "vertex_array") {
-        auto r = new VertexArray(this);
-        mResources[QString("vertex_array_%1").arg(r->name)] = r;
-        CHECK_GL;
-        return r->name;
-    }
+    if (res == "texture") return addResource(res, new Texture(this));
+    if (res == "shader") return addResource(res, new Shader(this, param));
+    if (res == "program") return addResource(res, new Program(this));
+    if (res == "buffer") return addResource(res, new Buffer(this));
+    if (res == "frame_buffer") return addResource(res, new FrameBuffer(this));
+    if (res == "vertex_array") return addResource(res, new VertexArray(this));
     return 0;
 }
 
+GLuint Demo::GLWidget::addResource(const QString& res, Resource* r) {
+    CHECK_GL;
+    if (!mScripts.isEmpty()) r->script = mScripts.last();
+    mResources[QString("%1_%2").arg(res).arg(r->name)] = r;
+    return r->name;
+}
+
 
 void Demo::GLWidget::deresource(const QString &res, GLuint name) {
     QString key = QString("%1_%2").arg(res).arg(name);
@@ -663,48 +782,70 @@ void Demo::GLWidget::deresource(const QString &res, GLuint name) {
         delete mResources[key];
         mResources.remove(key);
     }
+    if (res == "buffer") {
+        for (auto blob: qAsConst(mBlobs)) blob->forgetUpload(name);
+    }
+    CHECK_GL;
+}
+
+
+void Demo::GLWidget::releaseResources(const QStringList& scripts) {
+    auto it = mResources.begin();
+    while (it != mResources.end()) {
+        Resource* r = it.value();
+        if (r->script.isEmpty() || !scripts.contains(r->script)) {
+            ++it;
+            continue;
+        }
+        if (it.key().startsWith("buffer_")) {
+            for (auto blob: qAsConst(mBlobs)) blob->forgetUpload(r->name);
+        }
+        delete r;
+        it = mResources.erase(it);
+    }
     CHECK_GL;
 }
 
 
 void Demo::GLWidget::defaults() {
     // qCDebug(OGL) << "resetting to defaults";
-    glDisable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_POLYGON_OFFSET_FILL);
-    glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-    glDisable(GL_SAMPLE_COVERAGE);
-    glDisable(GL_SCISSOR_TEST);
-    glDisable(GL_STENCIL_TEST);
+    mBackend->glDisable(GL_BLEND);
+    mBackend->glDisable(GL_CULL_FACE);
+    mBackend->glDisable(GL_DEPTH_TEST);
+    mBackend->glDisable(GL_POLYGON_OFFSET_FILL);
+    mBackend->glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    mBackend->glDisable(GL_SAMPLE_COVERAGE);
+    mBackend->glDisable(GL_SCISSOR_TEST);
+    mBackend->glDisable(GL_STENCIL_TEST);
 
-    glEnable(GL_DITHER);
+    mBackend->glEnable(GL_DITHER);
 
-    glDepthRange(0, 1);
-    glLineWidth(1);
+    mBackend->glDepthRangef(0, 1);
+    mBackend->glLineWidth(1);
 
-    glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
+    mBackend->glFrontFace(GL_CCW);
+    mBackend->glCullFace(GL_BACK);
 
-    glColorMask(1, 1, 1, 1);
-    glDepthMask(1);
+    mBackend->glColorMask(1, 1, 1, 1);
+    mBackend->glDepthMask(1);
 
-    glClearColor(0, 0, 0, 0);
-    glClearDepth(1);
+    mBackend->glClearColor(0, 0, 0, 0);
+    mBackend->glClearDepthf(1);
 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    mBackend->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-    glUseProgram(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_1D, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0 + 1);
-    glBindTexture(GL_TEXTURE_1D, 0);
-    glBindVertexArray(0);
+    mBackend->glUseProgram(0);
+    mBackend->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    mBackend->glActiveTexture(GL_TEXTURE0);
+    mBackend->glBindTexture(GL_TEXTURE_1D, 0);
+    mBackend->glBindTexture(GL_TEXTURE_2D, 0);
+    mBackend->glActiveTexture(GL_TEXTURE0 + 1);
+    mBackend->glBindTexture(GL_TEXTURE_1D, 0);
+    mBackend->glBindVertexArray(0);
 
     qDeleteAll(mResources);
     mResources.clear();
+    for (auto blob: qAsConst(mBlobs)) blob->forgetUploads();
 
     CHECK_GL;
 
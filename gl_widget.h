@@ -3,13 +3,16 @@
 
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_4_5_Core>
+#include <QOpenGLDebugMessage>
 #include "logging.h"
 #include "math3d.h"
 #include "gl_lang_compiler.h"
 #include "datasource.h"
+#include "gl_backend.h"
 
 
 class QMouseEvent;
+class QOpenGLDebugLogger;
 
 class Camera;
 
@@ -37,6 +40,25 @@ public:
     GLWidget(QWidget *parent = nullptr);
     void addGLSymbols(SymbolMap& globals, VariableMap& exports);
 
+    // When to look for GL errors in scripts. DebugOutput needs a debug
+    // context, otherwise errors are checked per statement.
+    enum ErrorPolicy {CheckCalls, CheckStatements, DebugOutput, NoChecks};
+
+    void setErrorPolicy(ErrorPolicy policy);
+    // in effect: differs from the requested policy after a fallback
+    ErrorPolicy errorPolicy() const {return mErrorPolicy;}
+    ErrorPolicy requestedErrorPolicy() const {return mRequestedPolicy;}
+    // throws GL::GLError
+    void throwOnError();
+    // CheckStatements: only statements calling GL are checked
+    void glCalled() {mGLCalled = true;}
+
+    GL::Backend* backend() const {return mBackend;}
+    // Takes ownership. Without a live context the widget counts as
+    // initialized, scripts can then be run headless with drawFrame.
+    void setBackend(GL::Backend* backend);
+    void drawFrame();
+
     const GL::Blob& blob(int index) const {return *mBlobs[index];}
     const GL::TexBlob& texBlob(int index) const {return *mTexBlobs[index];}
     GL::Blob* blob(const SymbolMap& globals, const QString& name) const;
@@ -47,6 +69,7 @@ public:
     void animReset(int);
     bool animRunning() const;
     void cameraStop();
+    Math3D::Matrix4 cameraRelative(const Math3D::Matrix4& model) const;
     void saveToDisk(bool on, const QString& basePath);
 
     void setProjection(float near, float far);
@@ -54,7 +77,15 @@ public:
     GLuint resource(const QString& res, GLenum param = 0);
     void deresource(const QString& res, GLuint name);
 
+    // Resources created while a script runs belong to it, or to the
+    // innermost script when they are nested by dispatch
+    void beginScript(const QString& name) {mScripts.append(name);}
+    void endScript() {mScripts.removeLast();}
+    // deletes the resources of the scripts before they run again
+    void releaseResources(const QStringList& scripts);
+
     bool initialized() const {return mInitialized;}
+    bool drawing() const {return mDrawing;}
 
     using DataVector = DataSource::DataVector;
 
@@ -68,6 +99,7 @@ public slots:
 
     void initChanged();
     void drawChanged();
+    void initSuspended();
 
 protected:
 
@@ -135,6 +167,7 @@ private:
 
         Demo::GLWidget* parent;
         GLuint name;
+        QString script; // creator
 
         virtual ~Resource() = default;
     };
@@ -143,10 +176,10 @@ private:
     public:
         Texture(Demo::GLWidget* owner)
             : Resource(owner) {
-            parent->glGenTextures(1, &name);
+            parent->backend()->glGenTextures(1, &name);
         }
         ~Texture() {
-            parent->glDeleteTextures(1, &name);
+            parent->backend()->glDeleteTextures(1, &name);
         }
     };
 
@@ -154,10 +187,10 @@ private:
     public:
         Shader(Demo::GLWidget* owner, GLenum type)
             : Resource(owner) {
-            name = parent->glCreateShader(type);
+            name = parent->backend()->glCreateShader(type);
         }
         ~Shader() {
-            parent->glDeleteShader(name);
+            parent->backend()->glDeleteShader(name);
         }
     };
 
@@ -165,10 +198,10 @@ private:
     public:
         Program(Demo::GLWidget* owner)
             : Resource(owner) {
-            name = parent->glCreateProgram();
+            name = parent->backend()->glCreateProgram();
         }
         ~Program() {
-            parent->glDeleteProgram(name);
+            parent->backend()->glDeleteProgram(name);
         }
     };
 
@@ -176,10 +209,10 @@ private:
     public:
         Buffer(Demo::GLWidget* owner)
             : Resource(owner) {
-            parent->glGenBuffers(1, &name);
+            parent->backend()->glGenBuffers(1, &name);
         }
         ~Buffer() {
-            parent->glDeleteBuffers(1, &name);
+            parent->backend()->glDeleteBuffers(1, &name);
         }
     };
 
@@ -187,10 +220,10 @@ private:
     public:
         FrameBuffer(Demo::GLWidget* owner)
             : Resource(owner) {
-            parent->glGenFramebuffers(1, &name);
+            parent->backend()->glGenFramebuffers(1, &name);
         }
         ~FrameBuffer() {
-            parent->glDeleteFramebuffers(1, &name);
+            parent->backend()->glDeleteFramebuffers(1, &name);
         }
     };
 
@@ -198,10 +231,10 @@ private:
     public:
         VertexArray(Demo::GLWidget* owner)
             : Resource(owner) {
-            parent->glGenVertexArrays(1, &name);
+            parent->backend()->glGenVertexArrays(1, &name);
         }
         ~VertexArray() {
-            parent->glDeleteVertexArrays(1, &name);
+            parent->backend()->glDeleteVertexArrays(1, &name);
         }
     };
 
@@ -230,6 +263,8 @@ private:
 signals:
 
     void init();
+    void resume();
+    void resized();
     void draw();
     void hidden();
     void toggleAnimate();
@@ -238,6 +273,8 @@ signals:
 private:
 
     void defaults();
+    GLuint addResource(const QString& res, Resource* r);
+    void setupDebugOutput();
     void addBlob(QObject* blob, SymbolMap& globals);
 
     void zoom();
@@ -251,11 +288,14 @@ private slots:
     void realResize();
     void encodingFinished();
     void dataSourceClosed();
+    void debugMessage(const QOpenGLDebugMessage& msg);
 
 private:
 
     bool mInitialized;
+    bool mInitDone;
     ResourceMap mResources;
+    QStringList mScripts; // running, innermost last
     BlobVector mBlobs;
     TexBlobVector mTexBlobs;
     Variable* mCameraVar;
@@ -279,6 +319,14 @@ private:
     VideoEncoder* mEncoder;
     GL::Downloader* mDownloader;
     bool mRecording;
+    bool mDrawing;
+    bool mInitSuspended;
+    ErrorPolicy mErrorPolicy;
+    ErrorPolicy mRequestedPolicy;
+    bool mGLCalled;
+    GL::Backend* mBackend;
+    QOpenGLDebugLogger* mDebugLogger;
+    QString mDebugError;
     CacheMap mDataCache;
     int mMaxFrames;
 
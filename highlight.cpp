@@ -52,6 +52,7 @@ Highlight::Highlight(Compiler* c, QTextDocument* parent):
     mFormats[IMPORT] = mReserved;
     mFormats[WHILE] = mReserved;
     mFormats[ENDWHILE] = mReserved;
+    mFormats[YIELD] = mReserved;
     mFormats[IF] = mReserved;
     mFormats[ELSE] = mReserved;
     mFormats[ENDIF] = mReserved;
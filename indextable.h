@@ -0,0 +1,142 @@
+#ifndef INDEXTABLE_H
+#define INDEXTABLE_H
+
+#include <QVector>
+#include <QtGlobal>
+
+namespace Demo {
+
+// splitmix64 finalizer
+inline quint64 mixBits(quint64 x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Vertex/texture/normal index triplet of a face corner. Missing
+// components are Absent, so that 1// and 1/1/ differ.
+class VertexKey {
+public:
+
+    static const quint32 Absent = ~0u;
+
+    VertexKey(quint32 v = Absent, quint32 n = Absent, quint32 t = Absent)
+        : v_index(v)
+        , n_index(n)
+        , t_index(t) {}
+
+    bool operator== (const VertexKey& k) const {
+        return v_index == k.v_index && n_index == k.n_index && t_index == k.t_index;
+    }
+
+    quint64 hash() const {
+        return mixBits((quint64(v_index) << 32 | n_index) ^ (quint64(t_index) * 0x9e3779b97f4a7c15ULL));
+    }
+
+    quint32 v_index;
+    quint32 n_index;
+    quint32 t_index;
+};
+
+// Undirected edge between two vertex data indices
+class EdgeKey {
+public:
+
+    EdgeKey(quint32 v1 = 0, quint32 v2 = 0)
+        : bits(v1 < v2 ? quint64(v1) << 32 | v2 : quint64(v2) << 32 | v1) {}
+
+    bool operator== (const EdgeKey& k) const {return bits == k.bits;}
+
+    quint64 hash() const {return mixBits(bits);}
+
+    quint64 bits;
+};
+
+// Open addressing hash table from keys to indices: linear probing in a
+// power of two table that is kept at most half full.
+template <typename Key> class IndexTable {
+
+public:
+
+    static const quint32 Empty = ~0u;
+
+    IndexTable() {resize(16);}
+
+    void clear() {
+        mSize = 0;
+        if (mValues.size() > 16) {
+            resize(16);
+        } else {
+            mValues.fill(Empty);
+        }
+    }
+
+    // room for count keys without rehashing
+    void reserve(int count) {
+        int capacity = 16;
+        while (capacity < 2 * count) capacity *= 2;
+        if (capacity > mValues.size()) rehash(capacity);
+    }
+
+    int size() const {return mSize;}
+
+    // value of key, or Empty
+    quint32 value(const Key& key) const {
+        for (quint32 i = key.hash() & mMask;; i = (i + 1) & mMask) {
+            if (mValues[i] == Empty) return Empty;
+            if (mKeys[i] == key) return mValues[i];
+        }
+    }
+
+    // Value of key. A new key gets the given value and inserted is set.
+    quint32 insert(const Key& key, quint32 value, bool& inserted) {
+        Key* keys = mKeys.data();
+        quint32* values = mValues.data();
+        quint32 i = key.hash() & mMask;
+        for (; values[i] != Empty; i = (i + 1) & mMask) {
+            if (keys[i] == key) {
+                inserted = false;
+                return values[i];
+            }
+        }
+        inserted = true;
+        keys[i] = key;
+        values[i] = value;
+        if (2 * ++mSize > mValues.size()) rehash(2 * mValues.size());
+        return value;
+    }
+
+private:
+
+    void resize(int capacity) {
+        mKeys = QVector<Key>(capacity);
+        mValues = QVector<quint32>(capacity, Empty);
+        mMask = capacity - 1;
+    }
+
+    void rehash(int capacity) {
+        QVector<Key> oldKeys = mKeys;
+        QVector<quint32> oldValues = mValues;
+        resize(capacity);
+        Key* keys = mKeys.data();
+        quint32* values = mValues.data();
+        for (int k = 0; k < oldValues.size(); k++) {
+            if (oldValues[k] == Empty) continue;
+            quint32 i = oldKeys[k].hash() & mMask;
+            while (values[i] != Empty) i = (i + 1) & mMask;
+            keys[i] = oldKeys[k];
+            values[i] = oldValues[k];
+        }
+    }
+
+    QVector<Key> mKeys;
+    QVector<quint32> mValues;
+    quint32 mMask;
+    int mSize = 0;
+};
+
+template <typename Key> const quint32 IndexTable<Key>::Empty;
+
+} // namespace Demo
+
+#endif // INDEXTABLE_H
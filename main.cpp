@@ -21,9 +21,11 @@
 #include <QApplication>
 #include <QtPlugin>
 #include <QSurfaceFormat>
+#include <QSettings>
 
 #include "logging.h"
 #include "mainwindow.h"
+#include "benchmark.h"
 
 Q_IMPORT_PLUGIN(ImageStore)
 Q_IMPORT_PLUGIN(ModelStore)
@@ -50,12 +52,18 @@ int main(int argc, char *argv[]) {
 
     qRegisterMetaType<Math3D::Vector4>();
     qRegisterMetaType<Math3D::Matrix4>();
+    qRegisterMetaType<Math3D::Quaternion>();
     QMetaType::registerDebugStreamOperator<Math3D::Matrix4>();
     QMetaType::registerDebugStreamOperator<Math3D::Vector4>();
+    QMetaType::registerDebugStreamOperator<Math3D::Quaternion>();
 
     QSurfaceFormat format;
     format.setVersion(4, 5);
     format.setProfile(QSurfaceFormat::CoreProfile);
+    // GL errors reported by KHR_debug, see GLWidget::setErrorPolicy
+    if (QSettings().value("glerrors").toString() == "debug") {
+        format.setOption(QSurfaceFormat::DebugContext);
+    }
     QSurfaceFormat::setDefaultFormat(format);
 
     qSetMessagePattern("[%{category} "
@@ -67,6 +75,19 @@ int main(int argc, char *argv[]) {
                        "[%{file}:%{line}] - %{message}");
     QLoggingCategory::setFilterRules(QStringLiteral("OpenGLDemo.debug=true"));
 
+    // headless: OpenGLDemo --benchmark frames [--interpret] [--trace file] [project.ini ...]
+    if (demo == "--benchmark") {
+        return Demo::runBenchmark(args.value(2).toInt(), args.mid(3));
+    }
+    // OpenGLDemo --benchmark-math iterations
+    if (demo == "--benchmark-math") {
+        return Demo::runMathBenchmark(args.value(2).toInt());
+    }
+    // OpenGLDemo --benchmark-models iterations [model.obj ...]
+    if (demo == "--benchmark-models") {
+        return Demo::runModelBenchmark(args.value(2).toInt(), args.mid(3));
+    }
+
     Demo::MainWindow mw(demo);
     mw.show();
 
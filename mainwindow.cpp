@@ -28,6 +28,7 @@
 #include "constant.h"
 #include "scope.h"
 #include "depthzoom.h"
+#include "modelstore.h"
 
 #include <QtDebug>
 #include <QMessageBox>
@@ -74,9 +75,15 @@ MainWindow::MainWindow(const QString& project)
     // Initialize globals
     mGlobals = new Scope(mGLWidget, this);
 
+    auto models = dynamic_cast<GL::ModelStore*>(mGLWidget->blob(mGlobals->symbols(), "modelstore"));
+    if (models) {
+        connect(models, SIGNAL(loadProgress(int, int)), this, SLOT(modelsLoading(int, int)));
+    }
+
     // cannot record until opengl is initialized
     mUI->actionRecord->setEnabled(false);
     connect(mGLWidget, SIGNAL(openGLReady(bool)), mUI->actionRecord, SLOT(setEnabled(bool)));
+    connect(mGLWidget, SIGNAL(openGLReady(bool)), this, SLOT(openGLReady()));
 
     // init the projection near/far values
     depthChanged(zoom->near(), zoom->far());
@@ -91,6 +98,7 @@ MainWindow::MainWindow(const QString& project)
     mUI->projectItems->addAction(mUI->actionCompile);
     mUI->projectItems->addAction(mUI->actionDelete);
     mUI->projectItems->addAction(mUI->actionReload);
+    mUI->projectItems->addAction(mUI->actionTriangleList);
 
     readSettings();
 
@@ -373,6 +381,14 @@ void Demo::MainWindow::on_actionReload_triggered() {
     mProject->setData(item, QVariant::fromValue(fileName), Project::FileRole);
 }
 
+void Demo::MainWindow::on_actionTriangleList_triggered(bool on) {
+    auto item = getSelection();
+    if (item.parent() != mProject->itemParent(Project::ModelItems)) return;
+    mProject->setTriangleLayout(item, on);
+    mProjectModified = true;
+    setProjectModified();
+}
+
 void Demo::MainWindow::on_actionQuit_triggered() {
     close();
 }
@@ -491,6 +507,7 @@ void Demo::MainWindow::selectionChanged() {
         mUI->actionDelete->setEnabled(false);
         mUI->actionReload->setEnabled(false);
         mUI->actionComplete->setEnabled(false);
+        mUI->actionTriangleList->setEnabled(false);
 
         QWidget* curr = mUI->editorsTabs->currentWidget();
         if (curr) curr->setDisabled(true);
@@ -515,6 +532,7 @@ void Demo::MainWindow::selectionChanged() {
         mUI->actionDelete->setEnabled(false);
         mUI->actionReload->setEnabled(false);
         mUI->actionComplete->setEnabled(false);
+        mUI->actionTriangleList->setEnabled(false);
 
         QWidget* curr = mUI->editorsTabs->currentWidget();
         if (curr) curr->setDisabled(true);
@@ -553,6 +571,7 @@ void Demo::MainWindow::setupScriptActions(const QModelIndex& selection) {
         ADDACTION(Compile);
         REMACTION(Delete);
         REMACTION(Reload);
+        REMACTION(TriangleList);
         mUI->actionRename->setEnabled(false);
         mUI->actionDelete->setEnabled(false);
     } else {
@@ -565,6 +584,7 @@ void Demo::MainWindow::setupScriptActions(const QModelIndex& selection) {
         ADDACTION(Compile);
         ADDACTION(Delete);
         REMACTION(Reload);
+        REMACTION(TriangleList);
         mUI->actionRename->setEnabled(true);
         mUI->actionDelete->setEnabled(true);
     }
@@ -590,6 +610,7 @@ void Demo::MainWindow::setupScriptActions(const QModelIndex& selection) {
     mUI->actionCompile->setDisabled(mUI->actionAutocompile->isChecked());
 
     mUI->actionReload->setEnabled(false);
+    mUI->actionTriangleList->setEnabled(false);
 
     mUI->actionComplete->setEnabled(curr && curr == widget);
 
@@ -627,6 +648,15 @@ void Demo::MainWindow::setupResourceActions(const QModelIndex& selection) {
     bool unbound = mProject->data(selection, Project::FileNameRole).toString().isEmpty();
     mUI->actionReload->setDisabled(unbound);
 
+    if (selection.parent() == mProject->itemParent(Project::ModelItems)) {
+        ADDACTION(TriangleList);
+        mUI->actionTriangleList->setEnabled(true);
+        mUI->actionTriangleList->setChecked(mProject->triangleLayout(selection));
+    } else {
+        REMACTION(TriangleList);
+        mUI->actionTriangleList->setEnabled(false);
+    }
+
     mUI->actionComplete->setEnabled(false);
 
     QWidget* curr = mUI->editorsTabs->currentWidget();
@@ -650,6 +680,25 @@ void Demo::MainWindow::scriptModification_changed(bool edited) {
     setProjectModified();
 }
 
+void Demo::MainWindow::modelsLoading(int done, int total) {
+    if (done < total) {
+        mUI->statusbar->showMessage(QString("Loading models %1/%2").arg(done).arg(total));
+    } else {
+        mUI->statusbar->clearMessage();
+    }
+    // models are loaded in the middle of opening the project
+    mUI->statusbar->repaint();
+}
+
+static const QStringList errorPolicies{"calls", "statements", "debug", "none"};
+
+void Demo::MainWindow::openGLReady() {
+    if (mGLWidget->errorPolicy() == mGLWidget->requestedErrorPolicy()) return;
+    mUI->statusbar->showMessage(QString("GL errors: using \"%1\" instead of \"%2\"")
+                                .arg(errorPolicies[mGLWidget->errorPolicy()])
+                                .arg(errorPolicies[mGLWidget->requestedErrorPolicy()]));
+}
+
 void Demo::MainWindow::on_actionAutocompile_toggled(bool on) {
     mUI->actionCompile->setDisabled(true);
     if (!mProject) return;
@@ -694,6 +743,29 @@ void Demo::MainWindow::on_actionCompileProject_triggered() {
 }
 
 
+void Demo::MainWindow::on_actionProfile_toggled(bool on) {
+    if (mProject) mProject->setProfiling(on, mUI->actionProfileGPU->isChecked());
+}
+
+void Demo::MainWindow::on_actionProfileGPU_toggled(bool on) {
+    if (mProject) mProject->setProfiling(mUI->actionProfile->isChecked(), on);
+}
+
+void Demo::MainWindow::on_actionExportProfile_triggered() {
+    if (!mProject) return;
+    QString fname = QFileDialog::getSaveFileName(
+        this,
+        "Select file to export the profile to",
+        mProject->directory().absoluteFilePath("profile.tsv"),
+        "Tab separated tables (*.tsv *.txt)"
+    );
+    if (fname.isEmpty()) return;
+    if (!mProject->exportProfile(fname)) {
+        qWarning() << "Cannot write" << fname;
+    }
+}
+
+
 void Demo::MainWindow::on_actionComplete_triggered() {
     if (!mProject) return;
     const QItemSelectionModel* s = mUI->projectItems->selectionModel();
@@ -718,6 +790,10 @@ void Demo::MainWindow::readSettings() {
 
     mGLWidget->resize(settings.value("scenesize", QSize(400, 225)).toSize());
 
+    int policy = errorPolicies.indexOf(settings.value("glerrors", "statements").toString());
+    if (policy < 0) policy = GLWidget::CheckStatements;
+    mGLWidget->setErrorPolicy(static_cast<GLWidget::ErrorPolicy>(policy));
+
     if (settings.value("scenevisible", false).toBool()) {
         on_actionViewScene_triggered();
     }
@@ -747,6 +823,8 @@ void Demo::MainWindow::writeSettings() {
 
     settings.setValue("scenevisible", QVariant::fromValue(mGLWidget->isVisible()));
     settings.setValue("scenesize", QVariant::fromValue(mGLWidget->size()));
+    // keep the preference even if the context could not honor it
+    settings.setValue("glerrors", errorPolicies[mGLWidget->requestedErrorPolicy()]);
 
 }
 
@@ -830,6 +908,7 @@ void Demo::MainWindow::openProject(const QString &path) {
 
         delete mProject;
         mProject = newp;
+        mProject->setProfiling(mUI->actionProfile->isChecked(), mUI->actionProfileGPU->isChecked());
 
         connect(mUI->projectItems->selectionModel(),
                 SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)),
@@ -88,6 +88,9 @@ private slots:
     //! As it says.
     void on_actionReload_triggered();
 
+    //! Draw the selected model from a triangle list or from strips.
+    void on_actionTriangleList_triggered(bool on);
+
     //! As it says.
     void on_actionQuit_triggered();
 
@@ -112,8 +115,13 @@ private slots:
     void on_actionComplete_triggered();
     void on_actionViewScene_triggered();
     void on_actionRecord_toggled(bool on);
+    void on_actionProfile_toggled(bool on);
+    void on_actionProfileGPU_toggled(bool on);
+    void on_actionExportProfile_triggered();
 
     void scriptModification_changed(bool edited);
+    void modelsLoading(int done, int total);
+    void openGLReady();
 
     void depthChanged(float near, float far);
 
@@ -6,6 +6,11 @@
 #include <GL/gl.h>
 #include "logging.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#define MATH3D_SSE
+#include <immintrin.h>
+#endif
+
 namespace Math3D {
 
 #define OSTREAM_MATH3D
@@ -35,6 +40,240 @@ inline Real rads(Real x) {return x * RADS_PER_DEG;}
 inline Real degs(Real x) {return x * DEGS_PER_RAD;}
 
 
+// --------------------------------------------------------------
+// Kernels: column major 4x4 matrices and 4-vectors.
+// Scalar:: is the reference implementation, Kernel:: the one used
+// by the classes: SSE2, AVX and FMA when the compiler enables them.
+// Outputs must not alias inputs.
+// --------------------------------------------------------------
+
+namespace Scalar {
+
+// out = a * b
+inline void mul(const Real* a, const Real* b, Real* out) {
+    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) {
+        Real s = 0;
+        for (int i = 0; i < 4; ++i) s += b[4 * x + i] * a[4 * i + y];
+        out[4 * x + y] = s;
+    }
+}
+
+// out = m * v
+inline void transform(const Real* m, const Real* v, Real* out) {
+    for (int y = 0; y < 4; ++y) {
+        out[y] = v[0] * m[y] + v[1] * m[4 + y] + v[2] * m[8 + y] + v[3] * m[12 + y];
+    }
+}
+
+inline void transpose(const Real* m, Real* out) {
+    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) out[4 * x + y] = m[4 * y + x];
+}
+
+// cofactor expansion, returns false if m is singular
+inline bool inverse(const Real* m, Real* out) {
+    Real c[16];
+    c[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+           m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    c[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+           m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    c[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+           m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    c[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+            m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    c[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+           m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    c[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+           m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    c[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+           m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    c[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+            m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    c[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+           m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    c[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+           m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    c[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+            m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    c[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+            m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    c[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+           m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    c[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+           m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    c[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+            m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    c[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+            m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    Real det = m[0] * c[0] + m[1] * c[4] + m[2] * c[8] + m[3] * c[12];
+    if (det == 0) return false;
+    Real r = 1 / det;
+    for (int i = 0; i < 16; ++i) out[i] = c[i] * r;
+    return true;
+}
+
+} // namespace Scalar
+
+#ifdef MATH3D_SSE
+
+namespace Kernel {
+
+// a * b + c
+inline __m128 madd(__m128 a, __m128 b, __m128 c) {
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+#define M3D_SHUFFLE(v, w, x, y, z, t) _mm_shuffle_ps(v, w, _MM_SHUFFLE(t, z, y, x))
+#define M3D_SPLAT(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+
+inline void mul(const Real* a, const Real* b, Real* out) {
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+#ifdef __AVX__
+    // two result columns per round, one in each 128 bit lane
+    __m256 c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a0, 1);
+    __m256 c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(a1), a1, 1);
+    __m256 c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a2), a2, 1);
+    __m256 c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(a3), a3, 1);
+    for (int x = 0; x < 4; x += 2) {
+        __m256 bx = _mm256_loadu_ps(b + 4 * x);
+        __m256 r = _mm256_mul_ps(c0, _mm256_shuffle_ps(bx, bx, 0x00));
+#ifdef __FMA__
+        r = _mm256_fmadd_ps(c1, _mm256_shuffle_ps(bx, bx, 0x55), r);
+        r = _mm256_fmadd_ps(c2, _mm256_shuffle_ps(bx, bx, 0xaa), r);
+        r = _mm256_fmadd_ps(c3, _mm256_shuffle_ps(bx, bx, 0xff), r);
+#else
+        r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_shuffle_ps(bx, bx, 0x55)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_shuffle_ps(bx, bx, 0xaa)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_shuffle_ps(bx, bx, 0xff)));
+#endif
+        _mm256_storeu_ps(out + 4 * x, r);
+    }
+#else
+    for (int x = 0; x < 4; ++x) {
+        __m128 bx = _mm_loadu_ps(b + 4 * x);
+        __m128 r = _mm_mul_ps(a0, M3D_SPLAT(bx, 0));
+        r = madd(a1, M3D_SPLAT(bx, 1), r);
+        r = madd(a2, M3D_SPLAT(bx, 2), r);
+        r = madd(a3, M3D_SPLAT(bx, 3), r);
+        _mm_storeu_ps(out + 4 * x, r);
+    }
+#endif
+}
+
+inline void transform(const Real* m, const Real* v, Real* out) {
+    __m128 vv = _mm_loadu_ps(v);
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m), M3D_SPLAT(vv, 0));
+    r = madd(_mm_loadu_ps(m + 4), M3D_SPLAT(vv, 1), r);
+    r = madd(_mm_loadu_ps(m + 8), M3D_SPLAT(vv, 2), r);
+    r = madd(_mm_loadu_ps(m + 12), M3D_SPLAT(vv, 3), r);
+    _mm_storeu_ps(out, r);
+}
+
+inline void transpose(const Real* m, Real* out) {
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(out, c0);
+    _mm_storeu_ps(out + 4, c1);
+    _mm_storeu_ps(out + 8, c2);
+    _mm_storeu_ps(out + 12, c3);
+}
+
+// 2x2 blocks are stored as (m00, m01, m10, m11)
+
+// a * b
+inline __m128 mul2(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, M3D_SHUFFLE(b, b, 0, 3, 0, 3)),
+                      _mm_mul_ps(M3D_SHUFFLE(a, a, 1, 0, 3, 2), M3D_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// adj(a) * b
+inline __m128 adjMul2(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(M3D_SHUFFLE(a, a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(M3D_SHUFFLE(a, a, 1, 1, 2, 2), M3D_SHUFFLE(b, b, 2, 3, 0, 1)));
+}
+
+// a * adj(b)
+inline __m128 mulAdj2(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, M3D_SHUFFLE(b, b, 3, 0, 3, 0)),
+                      _mm_mul_ps(M3D_SHUFFLE(a, a, 1, 0, 3, 2), M3D_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// block wise inverse. The blocks are taken from the columns, which
+// inverts the transpose; the transpose of that is the inverse.
+inline bool inverse(const Real* m, Real* out) {
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+
+    __m128 A = _mm_movelh_ps(c0, c1);
+    __m128 B = _mm_movehl_ps(c1, c0);
+    __m128 C = _mm_movelh_ps(c2, c3);
+    __m128 D = _mm_movehl_ps(c3, c2);
+
+    // (|A| |B| |C| |D|)
+    __m128 dets = _mm_sub_ps(_mm_mul_ps(M3D_SHUFFLE(c0, c2, 0, 2, 0, 2), M3D_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+                             _mm_mul_ps(M3D_SHUFFLE(c0, c2, 1, 3, 1, 3), M3D_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    __m128 detA = M3D_SPLAT(dets, 0);
+    __m128 detB = M3D_SPLAT(dets, 1);
+    __m128 detC = M3D_SPLAT(dets, 2);
+    __m128 detD = M3D_SPLAT(dets, 3);
+
+    __m128 DC = adjMul2(D, C);
+    __m128 AB = adjMul2(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mul2(B, DC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mul2(C, AB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mulAdj2(D, AB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mulAdj2(A, DC));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+    __m128 tr = _mm_mul_ps(AB, M3D_SHUFFLE(DC, DC, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, M3D_SHUFFLE(tr, tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, M3D_SHUFFLE(tr, tr, 2, 3, 0, 1));
+    __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+    if (_mm_cvtss_f32(det) == 0) return false;
+
+    __m128 r = _mm_div_ps(_mm_setr_ps(1, -1, -1, 1), det);
+    X = _mm_mul_ps(X, r);
+    Y = _mm_mul_ps(Y, r);
+    Z = _mm_mul_ps(Z, r);
+    W = _mm_mul_ps(W, r);
+
+    // adjugate and transpose of the blocks
+    _mm_storeu_ps(out, M3D_SHUFFLE(X, Y, 3, 1, 3, 1));
+    _mm_storeu_ps(out + 4, M3D_SHUFFLE(X, Y, 2, 0, 2, 0));
+    _mm_storeu_ps(out + 8, M3D_SHUFFLE(Z, W, 3, 1, 3, 1));
+    _mm_storeu_ps(out + 12, M3D_SHUFFLE(Z, W, 2, 0, 2, 0));
+    return true;
+}
+
+#undef M3D_SHUFFLE
+#undef M3D_SPLAT
+
+} // namespace Kernel
+
+#else
+
+namespace Kernel {
+using Scalar::mul;
+using Scalar::transform;
+using Scalar::transpose;
+using Scalar::inverse;
+} // namespace Kernel
+
+#endif // MATH3D_SSE
+
+
 // --------------------------------------------------------------
 // Classes: Vector4
 // --------------------------------------------------------------
@@ -276,10 +515,7 @@ inline Matrix4& Matrix4::operator-= (const Matrix4& m) {
 // ----------------- (3) ----------------------------------------
 inline Matrix4& Matrix4::operator*= (const Matrix4& m1) {
     Matrix4 m;
-    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) {
-            m(x)[y] = 0;
-            for (int i = 0; i < 4; ++i) m(x)[y] += m1[x][i] * (*this)[i][y];
-    }
+    Kernel::mul(e, m1.readArray(), m.getArray());
     Real* self_v = getArray();
     const Real* v = m.readArray();
     for (int i = 0; i < 16; ++i) self_v[i] = v[i];
@@ -305,7 +541,7 @@ inline Matrix4 Matrix4::transpose3() const {
 // ----------------- (6) ----------------------------------------
 inline Matrix4 Matrix4::transpose4() const {
     Matrix4 m;
-    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) m(x)[y] = (*this)[y][x];
+    Kernel::transpose(e, m.getArray());
     return m;
 }
 
@@ -340,13 +576,13 @@ inline Matrix4 Matrix4::comatrix() const {
 
 
 // ----------------- (8c) ----------------------------------------
+// general inverse, NaNs for a singular matrix
 inline Matrix4 Matrix4::inverse() const {
-    Matrix4 m = comatrix().transpose3();
-    Real dt = (*this)[0][0] * m[0][0] + (*this)[0][1] * m[1][0] + (*this)[0][2] * m[2][0];
-    m *= 1 / dt;
-    Matrix4 m2;
-    m2.setTranslation(- m * translation());
-    return m2 * m;
+    Matrix4 m;
+    if (!Kernel::inverse(e, m.getArray())) {
+        for (Real& v: m.e) v = std::nan("");
+    }
+    return m;
 }
 
 
@@ -456,19 +692,16 @@ inline Vector4 Matrix4::row3(int i) const {
 
 // ---------------- (15) ----------------------------------------
 inline Vector4 operator* (const Matrix4& m, const Vector4& v) {
-    return Vector4(v[X]*m[X][X] + v[Y]*m[Y][X] + v[Z]*m[Z][X] + v[W]*m[W][X],
-                   v[X]*m[X][Y] + v[Y]*m[Y][Y] + v[Z]*m[Z][Y] + v[W]*m[W][Y],
-                   v[X]*m[X][Z] + v[Y]*m[Y][Z] + v[Z]*m[Z][Z] + v[W]*m[W][Z]);
-
+    Real r[4];
+    Kernel::transform(m.readArray(), v.readArray(), r);
+    // w = 1
+    return Vector4(r[X], r[Y], r[Z]);
 }
 
 // ---------------- (16) ----------------------------------------
 inline Matrix4 operator* (const Matrix4& m1, const Matrix4& m2) {
     Matrix4 m;
-    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) {
-        m(x)[y] = 0;
-        for (int i = 0; i < 4; ++i) m(x)[y] += m2[x][i] * m1[i][y];
-    }
+    Kernel::mul(m1.readArray(), m2.readArray(), m.getArray());
     return m;
 }
 
@@ -536,7 +769,7 @@ inline Matrix4& Matrix4::doTranspose3() {
 // ---------------- (23) ----------------------------------------
 inline Matrix4& Matrix4::doTranspose4() {
     Matrix4 m;
-    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) m(x)[y] = (*this)[y][x];
+    Kernel::transpose(e, m.getArray());
     const Real* v = m.readArray();
     for (int i = 0; i < 16; ++i) e[i] = v[i];
     return *this;
@@ -598,6 +831,250 @@ inline Matrix4 projection3(const Vector4& v) {
     return m;
 }
 
+// --------------------------------------------------------------
+// Classes: Vector4d, Matrix4d
+// Double precision for long transformation chains and coordinates far
+// from the origin. Convert to float just before upload.
+// --------------------------------------------------------------
+
+class Vector4d {
+
+public:
+
+    Vector4d(double x = 0, double y = 0, double z = 0, double w = 1) {e[X] = x; e[Y] = y; e[Z] = z; e[W] = w;}
+    explicit Vector4d(const Vector4& v) {for (int i = 0; i < 4; ++i) e[i] = v[i];}
+
+    const double& operator[] (int i) const {return e[i];}
+    double& operator() (int i) {return e[i];}
+
+    Vector4 toFloat() const {return Vector4(e[X], e[Y], e[Z], e[W]);}
+
+    Vector4d& operator+= (const Vector4d& v) {e[X] += v[X]; e[Y] += v[Y]; e[Z] += v[Z]; return *this;}
+    Vector4d& operator-= (const Vector4d& v) {e[X] -= v[X]; e[Y] -= v[Y]; e[Z] -= v[Z]; return *this;}
+    Vector4d& operator*= (double s) {e[X] *= s; e[Y] *= s; e[Z] *= s; return *this;}
+
+    double length3() const {return std::sqrt(e[X] * e[X] + e[Y] * e[Y] + e[Z] * e[Z]);}
+    Vector4d normalized3() const {double s = 1 / length3(); return Vector4d(e[X] * s, e[Y] * s, e[Z] * s);}
+
+private:
+
+    double e[4];
+};
+
+inline double dot3(const Vector4d& v1, const Vector4d& v2) {
+    return v1[X] * v2[X] + v1[Y] * v2[Y] + v1[Z] * v2[Z];
+}
+
+inline Vector4d cross(const Vector4d& v1, const Vector4d& v2) {
+  return Vector4d(v1[Y] * v2[Z] - v1[Z] * v2[Y],
+                  v1[Z] * v2[X] - v1[X] * v2[Z],
+                  v1[X] * v2[Y] - v1[Y] * v2[X]);
+}
+
+inline Vector4d operator- (const Vector4d& v) {return Vector4d(-v[X], -v[Y], -v[Z]);}
+inline Vector4d operator* (const Vector4d& v, double s) {return Vector4d(v[X] * s, v[Y] * s, v[Z] * s);}
+inline Vector4d operator* (double s, const Vector4d& v) {return v * s;}
+inline Vector4d operator+ (const Vector4d& v1, const Vector4d& v2) {return Vector4d(v1[X] + v2[X], v1[Y] + v2[Y], v1[Z] + v2[Z]);}
+inline Vector4d operator- (const Vector4d& v1, const Vector4d& v2) {return Vector4d(v1[X] - v2[X], v1[Y] - v2[Y], v1[Z] - v2[Z]);}
+
+
+class Matrix4d {
+
+public:
+
+    Matrix4d() = default;
+    explicit Matrix4d(const Matrix4& m) {
+        const Real* v = m.readArray();
+        for (int i = 0; i < 16; ++i) e[i] = v[i];
+    }
+
+    // column first as in Matrix4
+    const double* operator[] (int i) const {return &e[i<<2];}
+    double* operator() (int i) {return &e[i<<2];}
+
+    Matrix4 toFloat() const {
+        Matrix4 m;
+        Real* v = m.getArray();
+        for (int i = 0; i < 16; ++i) v[i] = e[i];
+        return m;
+    }
+
+    Matrix4d& setIdentity() {
+        for (double& m: e) m = 0;
+        e[0] = e[5] = e[10] = e[15] = 1;
+        return *this;
+    }
+
+    Matrix4d& setTranslation(const Vector4d& t) {
+        setIdentity();
+        e[12] = t[X];
+        e[13] = t[Y];
+        e[14] = t[Z];
+        return *this;
+    }
+
+    Matrix4d& setRotation(double angle, Vector4d axis) {
+        double c = std::cos(angle);
+        double s = std::sin(angle);
+        double omc = 1 - c;
+        axis = axis.normalized3();
+        double x = axis[X];
+        double y = axis[Y];
+        double z = axis[Z];
+        setIdentity();
+        e[0] = x * x * omc + c;
+        e[1] = x * y * omc + z * s;
+        e[2] = x * z * omc - y * s;
+        e[4] = x * y * omc - z * s;
+        e[5] = y * y * omc + c;
+        e[6] = y * z * omc + x * s;
+        e[8] = x * z * omc + y * s;
+        e[9] = y * z * omc - x * s;
+        e[10] = z * z * omc + c;
+        return *this;
+    }
+
+    // rows u, v, n
+    Matrix4d& setBasis(const Vector4d& v, const Vector4d& n) {
+        Vector4d u = cross(v, n);
+        setIdentity();
+        for (int x = 0; x < 3; ++x) {
+            e[4 * x] = u[x];
+            e[4 * x + 1] = v[x];
+            e[4 * x + 2] = n[x];
+        }
+        return *this;
+    }
+
+    Vector4d row3(int i) const {return Vector4d(e[i], e[4 + i], e[8 + i]);}
+
+private:
+
+    double e[16];
+};
+
+inline Matrix4d operator* (const Matrix4d& m1, const Matrix4d& m2) {
+    Matrix4d m;
+    for (int x = 0; x < 4; ++x) for (int y = 0; y < 4; ++y) {
+        double s = 0;
+        for (int i = 0; i < 4; ++i) s += m2[x][i] * m1[i][y];
+        m(x)[y] = s;
+    }
+    return m;
+}
+
+// w = 1 as in Matrix4
+inline Vector4d operator* (const Matrix4d& m, const Vector4d& v) {
+    return Vector4d(v[X]*m[X][X] + v[Y]*m[Y][X] + v[Z]*m[Z][X] + v[W]*m[W][X],
+                    v[X]*m[X][Y] + v[Y]*m[Y][Y] + v[Z]*m[Z][Y] + v[W]*m[W][Y],
+                    v[X]*m[X][Z] + v[Y]*m[Y][Z] + v[Z]*m[Z][Z] + v[W]*m[W][Z]);
+}
+
+// --------------------------------------------------------------
+// Classes: Quaternion
+// Rotation as (x, y, z) = sin(angle / 2) * axis, w = cos(angle / 2).
+// Composes with 16 multiplies and renormalizes cheaply.
+// --------------------------------------------------------------
+
+class Quaternion {
+
+public:
+
+    Quaternion(Real x = 0, Real y = 0, Real z = 0, Real w = 1) {e[X] = x; e[Y] = y; e[Z] = z; e[W] = w;}
+
+    // same convention as Matrix4::setRotation
+    static Quaternion rotation(Real angle, const Vector4& axis) {
+        Vector4 n = axis.normalized3();
+        Real s = std::sin(angle / 2);
+        return Quaternion(n[X] * s, n[Y] * s, n[Z] * s, std::cos(angle / 2));
+    }
+
+    const Real& operator[] (int i) const {return e[i];}
+    Real& operator() (int i) {return e[i];}
+
+    const Real* readArray() const {return e;}
+
+    Real norm() const {return std::sqrt(e[X] * e[X] + e[Y] * e[Y] + e[Z] * e[Z] + e[W] * e[W]);}
+
+    Quaternion normalized() const {
+        Real s = 1 / norm();
+        return Quaternion(e[X] * s, e[Y] * s, e[Z] * s, e[W] * s);
+    }
+
+    // inverse of a unit quaternion
+    Quaternion conjugate() const {return Quaternion(-e[X], -e[Y], -e[Z], e[W]);}
+
+    Matrix4 toMatrix() const {
+        Real x = e[X], y = e[Y], z = e[Z], w = e[W];
+        Matrix4 m;
+        m.setIdentity();
+        m(0)[0] = 1 - 2 * (y * y + z * z);
+        m(0)[1] = 2 * (x * y + w * z);
+        m(0)[2] = 2 * (x * z - w * y);
+        m(1)[0] = 2 * (x * y - w * z);
+        m(1)[1] = 1 - 2 * (x * x + z * z);
+        m(1)[2] = 2 * (y * z + w * x);
+        m(2)[0] = 2 * (x * z + w * y);
+        m(2)[1] = 2 * (y * z - w * x);
+        m(2)[2] = 1 - 2 * (x * x + y * y);
+        return m;
+    }
+
+private:
+
+    Real e[4];
+};
+
+// q1 * q2 rotates first by q2, then by q1 as with matrices
+inline Quaternion operator* (const Quaternion& q1, const Quaternion& q2) {
+    return Quaternion(q1[W] * q2[X] + q1[X] * q2[W] + q1[Y] * q2[Z] - q1[Z] * q2[Y],
+                      q1[W] * q2[Y] - q1[X] * q2[Z] + q1[Y] * q2[W] + q1[Z] * q2[X],
+                      q1[W] * q2[Z] + q1[X] * q2[Y] - q1[Y] * q2[X] + q1[Z] * q2[W],
+                      q1[W] * q2[W] - q1[X] * q2[X] - q1[Y] * q2[Y] - q1[Z] * q2[Z]);
+}
+
+// rotated (x, y, z), w = 1 as in q.toMatrix() * v
+inline Vector4 operator* (const Quaternion& q, const Vector4& v) {
+    Vector4 u(q[X], q[Y], q[Z]);
+    Vector4 t = 2 * cross(u, v);
+    Vector4 r = v + q[W] * t + cross(u, t);
+    return Vector4(r[X], r[Y], r[Z]);
+}
+
+inline Quaternion operator- (const Quaternion& q) {
+    return Quaternion(-q[X], -q[Y], -q[Z], -q[W]);
+}
+
+// q and -q are the same rotation
+inline bool operator== (const Quaternion& q1, const Quaternion& q2) {
+    Real d = q1[X] * q2[X] + q1[Y] * q2[Y] + q1[Z] * q2[Z] + q1[W] * q2[W];
+    Real s = d < 0 ? -1 : 1;
+    for (int i = 0; i < 4; ++i) {
+        if (!eqz(q1[i] - s * q2[i])) return false;
+    }
+    return true;
+}
+
+// shortest arc interpolation, t in [0, 1]
+inline Quaternion slerp(const Quaternion& q1, const Quaternion& q2, Real t) {
+    Real d = q1[X] * q2[X] + q1[Y] * q2[Y] + q1[Z] * q2[Z] + q1[W] * q2[W];
+    Quaternion q = d < 0 ? -q2 : q2;
+    d = std::fabs(d);
+    Real a = 1 - t;
+    Real b = t;
+    // nearly parallel: normalized lerp
+    if (d < 1 - 1e-5f) {
+        Real theta = std::acos(d);
+        Real s = 1 / std::sin(theta);
+        a = std::sin(a * theta) * s;
+        b = std::sin(b * theta) * s;
+    }
+    return Quaternion(a * q1[X] + b * q[X],
+                      a * q1[Y] + b * q[Y],
+                      a * q1[Z] + b * q[Z],
+                      a * q1[W] + b * q[W]).normalized();
+}
+
 } // namespace Math3D
 
 #ifdef OSTREAM_MATH3D
@@ -631,11 +1108,19 @@ inline QDebug operator<< (QDebug dbg, const Math3D::Matrix4& m) {
     return dbg;
 }
 
+inline QDebug operator<< (QDebug dbg, const Math3D::Quaternion& q) {
+    dbg << "q(" << q[0];
+    for (int i = 1; i < 4; ++i) dbg << ", " << q[i];
+    dbg << ')';
+    return dbg;
+}
+
 
 #endif  // OSTREAM_MATH3D
 
 Q_DECLARE_METATYPE(Math3D::Vector4)
 Q_DECLARE_METATYPE(Math3D::Matrix4)
+Q_DECLARE_METATYPE(Math3D::Quaternion)
 
 
 #endif // MATH3D_H
@@ -0,0 +1,590 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Demo;
+using Mesh::IndexVector;
+
+namespace {
+
+// Forsyth's scoring for an LRU cache of 32 vertices
+const int ForsythCache = 32;
+const float CacheDecayPower = 1.5f;
+const float LastTriangleScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+float vertexScore(int cachePosition, int remaining) {
+    // no triangles left
+    if (remaining == 0) return -1;
+    float score = 0;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the vertices of the last triangle score the same
+            score = LastTriangleScore;
+        } else {
+            float scale = 1.0f / (ForsythCache - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+        }
+    }
+    return score + ValenceBoostScale * std::pow(float(remaining), -ValenceBoostPower);
+}
+
+// the cache simulated by the overdraw clusters and the statistics
+const uint FifoCache = 16;
+
+// Misses of a triangle in a FIFO cache: a vertex is cached if it was
+// missed less than cacheSize misses ago. Adding cacheSize + 1 to the
+// timestamp empties the cache.
+int updateCache(const uint* t, uint cacheSize, uint* timestamps, uint& timestamp) {
+    int misses = 0;
+    for (int k = 0; k < 3; k++) {
+        if (timestamp - timestamps[t[k]] > cacheSize) {
+            timestamps[t[k]] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+const uint Unused = ~0u;
+
+// smallest cosine of the rotation of a triangle by a collapse
+const double MinCosine = 0.25;
+
+// Sum of squared distances to weighted planes
+class Quadric {
+public:
+    Quadric()
+        : a00(0), a01(0), a02(0), a11(0), a12(0), a22(0)
+        , b0(0), b1(0), b2(0), c(0), w(0) {}
+
+    // unit normal n, n.x + d = 0
+    Quadric(const double* n, double d, double weight)
+        : a00(weight * n[0] * n[0]), a01(weight * n[0] * n[1]), a02(weight * n[0] * n[2])
+        , a11(weight * n[1] * n[1]), a12(weight * n[1] * n[2]), a22(weight * n[2] * n[2])
+        , b0(weight * n[0] * d), b1(weight * n[1] * d), b2(weight * n[2] * d)
+        , c(weight * d * d), w(weight) {}
+
+    Quadric& operator+= (const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02;
+        a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c; w += q.w;
+        return *this;
+    }
+
+    // mean squared distance of p
+    double error(const Math3D::Vector4& p) const {
+        if (w <= 0) return 0;
+        double x = p[0], y = p[1], z = p[2];
+        double e = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(0.0, e / w);
+    }
+
+    double a00, a01, a02, a11, a12, a22, b0, b1, b2, c, w;
+};
+
+class Plane {
+public:
+    // unit normal n, n.x + d = 0
+    double n[3];
+    double d;
+
+    double distance(const Math3D::Vector4& p) const {
+        return std::abs(n[0] * p[0] + n[1] * p[1] + n[2] * p[2] + d);
+    }
+};
+
+void faceNormal(const Math3D::Vector4& a, const Math3D::Vector4& b, const Math3D::Vector4& d, double* n) {
+    double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    double e2[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+class Collapse {
+public:
+    uint from;
+    uint to;
+    double cost;
+};
+
+}
+
+IndexVector Mesh::optimizeVertexCache(const IndexVector& triangles, int vertexCount) {
+    int numTriangles = triangles.size() / 3;
+    IndexVector result;
+    result.reserve(3 * numTriangles);
+    if (numTriangles == 0) return result;
+    const uint* tri = triangles.constData();
+
+    // remaining triangles of vertex v: adjacency[offsets[v], offsets[v] + remaining[v])
+    QVector<int> remaining(vertexCount, 0);
+    for (int i = 0; i < 3 * numTriangles; i++) {
+        remaining[tri[i]]++;
+    }
+    QVector<int> offsets(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    QVector<int> adjacency(3 * numTriangles);
+    QVector<int> fill = offsets;
+    for (int i = 0; i < 3 * numTriangles; i++) {
+        adjacency[fill[tri[i]]++] = i / 3;
+    }
+
+    QVector<int> cachePosition(vertexCount, -1);
+    QVector<float> vertexScores(vertexCount);
+    for (int v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+    }
+    QVector<float> triangleScores(numTriangles);
+    int best = 0;
+    for (int t = 0; t < numTriangles; t++) {
+        const uint* p = tri + 3 * t;
+        triangleScores[t] = vertexScores[p[0]] + vertexScores[p[1]] + vertexScores[p[2]];
+        if (triangleScores[t] > triangleScores[best]) best = t;
+    }
+    QVector<char> emitted(numTriangles, 0);
+
+    uint cache[ForsythCache + 3];
+    int cacheSize = 0;
+    int cursor = 0;
+    for (int n = 0; n < numTriangles; n++) {
+        if (best < 0) {
+            // dead end: the next triangle in input order
+            while (emitted[cursor]) cursor++;
+            best = cursor;
+        }
+        const uint* p = tri + 3 * best;
+        emitted[best] = 1;
+        result << p[0] << p[1] << p[2];
+
+        for (int k = 0; k < 3; k++) {
+            int* a = adjacency.data() + offsets[p[k]];
+            int& r = remaining[p[k]];
+            for (int i = 0; i < r; i++) {
+                if (a[i] == best) {
+                    a[i] = a[--r];
+                    break;
+                }
+            }
+        }
+
+        // the triangle to the front of the cache
+        uint next[ForsythCache + 3];
+        int nextSize = 0;
+        for (int k = 0; k < 3; k++) {
+            if (std::find(next, next + nextSize, p[k]) == next + nextSize) next[nextSize++] = p[k];
+        }
+        for (int i = 0; i < cacheSize; i++) {
+            if (cache[i] != p[0] && cache[i] != p[1] && cache[i] != p[2]) next[nextSize++] = cache[i];
+        }
+        for (int i = 0; i < nextSize; i++) {
+            uint v = next[i];
+            cachePosition[v] = i < ForsythCache ? i : -1;
+            vertexScores[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        // rescore the triangles of the cached and evicted vertices
+        best = -1;
+        float bestScore = 0;
+        for (int i = 0; i < nextSize; i++) {
+            uint v = next[i];
+            const int* a = adjacency.constData() + offsets[v];
+            for (int j = 0; j < remaining[v]; j++) {
+                const uint* q = tri + 3 * a[j];
+                float score = vertexScores[q[0]] + vertexScores[q[1]] + vertexScores[q[2]];
+                triangleScores[a[j]] = score;
+                if (best < 0 || score > bestScore) {
+                    best = a[j];
+                    bestScore = score;
+                }
+            }
+        }
+
+        cacheSize = std::min(nextSize, ForsythCache);
+        std::copy(next, next + cacheSize, cache);
+    }
+    return result;
+}
+
+IndexVector Mesh::optimizeOverdraw(const IndexVector& triangles, const Vector4Vector& positions, float threshold) {
+    int numTriangles = triangles.size() / 3;
+    if (numTriangles == 0) return triangles;
+    const uint* tri = triangles.constData();
+
+    QVector<uint> timestamps(positions.size(), 0);
+    uint timestamp = FifoCache + 1;
+
+    // three misses start a new patch of the mesh
+    QVector<int> patches;
+    for (int t = 0; t < numTriangles; t++) {
+        int misses = updateCache(tri + 3 * t, FifoCache, timestamps.data(), timestamp);
+        if (t == 0 || misses == 3) patches.append(t);
+    }
+
+    // split the patches as long as the ACMR stays close to the patch ACMR
+    QVector<int> clusters;
+    for (int k = 0; k < patches.size(); k++) {
+        int begin = patches[k];
+        int end = k + 1 < patches.size() ? patches[k + 1] : numTriangles;
+
+        timestamp += FifoCache + 1;
+        int misses = 0;
+        for (int t = begin; t < end; t++) {
+            misses += updateCache(tri + 3 * t, FifoCache, timestamps.data(), timestamp);
+        }
+        float target = threshold * misses / (end - begin);
+
+        timestamp += FifoCache + 1;
+        clusters.append(begin);
+        int clusterMisses = 0;
+        int clusterSize = 0;
+        for (int t = begin; t < end; t++) {
+            clusterMisses += updateCache(tri + 3 * t, FifoCache, timestamps.data(), timestamp);
+            clusterSize++;
+            if (clusterMisses <= target * clusterSize) {
+                clusters.append(t + 1);
+                timestamp += FifoCache + 1;
+                clusterMisses = 0;
+                clusterSize = 0;
+            }
+        }
+        // the last cluster is empty or above the target: merged to the previous
+        if (clusters.last() != begin) clusters.removeLast();
+    }
+
+    // occlusion potential: cluster centroid to mesh centroid along the cluster normal
+    int numClusters = clusters.size();
+    QVector<float> normals(3 * numClusters, 0);
+    QVector<float> centroids(3 * numClusters, 0);
+    QVector<float> areas(numClusters, 0);
+    float mesh[3] = {0, 0, 0};
+    float meshArea = 0;
+    for (int c = 0; c < numClusters; c++) {
+        int end = c + 1 < numClusters ? clusters[c + 1] : numTriangles;
+        float* n = normals.data() + 3 * c;
+        float* m = centroids.data() + 3 * c;
+        for (int t = clusters[c]; t < end; t++) {
+            const Math3D::Vector4& a = positions[tri[3 * t]];
+            const Math3D::Vector4& b = positions[tri[3 * t + 1]];
+            const Math3D::Vector4& d = positions[tri[3 * t + 2]];
+            float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float e2[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+            float x = e1[1] * e2[2] - e1[2] * e2[1];
+            float y = e1[2] * e2[0] - e1[0] * e2[2];
+            float z = e1[0] * e2[1] - e1[1] * e2[0];
+            float area = std::sqrt(x * x + y * y + z * z);
+            n[0] += x;
+            n[1] += y;
+            n[2] += z;
+            for (int i = 0; i < 3; i++) {
+                m[i] += area * (a[i] + b[i] + d[i]) / 3;
+            }
+            areas[c] += area;
+        }
+        for (int i = 0; i < 3; i++) mesh[i] += m[i];
+        meshArea += areas[c];
+    }
+    if (meshArea > 0) {
+        for (int i = 0; i < 3; i++) mesh[i] /= meshArea;
+    }
+
+    QVector<float> keys(numClusters, 0);
+    for (int c = 0; c < numClusters; c++) {
+        if (areas[c] == 0) continue;
+        const float* n = normals.constData() + 3 * c;
+        const float* m = centroids.constData() + 3 * c;
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len == 0) continue;
+        float dot = 0;
+        for (int i = 0; i < 3; i++) dot += (m[i] / areas[c] - mesh[i]) * n[i];
+        keys[c] = dot / len;
+    }
+
+    QVector<int> order(numClusters);
+    for (int c = 0; c < numClusters; c++) order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&keys] (int a, int b) {return keys[a] > keys[b];});
+
+    IndexVector result;
+    result.reserve(triangles.size());
+    for (int c: qAsConst(order)) {
+        int end = c + 1 < numClusters ? clusters[c + 1] : numTriangles;
+        for (int i = 3 * clusters[c]; i < 3 * end; i++) result.append(tri[i]);
+    }
+    return result;
+}
+
+IndexVector Mesh::optimizeVertexFetch(IndexVector& triangles, int vertexCount) {
+    IndexVector remap(vertexCount, Unused);
+    uint next = 0;
+    for (uint& v: triangles) {
+        if (remap[v] == Unused) remap[v] = next++;
+        v = remap[v];
+    }
+    for (uint& r: remap) {
+        if (r == Unused) r = next++;
+    }
+    return remap;
+}
+
+IndexVector Mesh::simplify(const IndexVector& triangles, const Vector4Vector& positions, int targetCount, float& planeDistance) {
+    planeDistance = 0;
+    IndexVector result = triangles;
+    int vertexCount = positions.size();
+    if (result.size() / 3 <= targetCount) return result;
+
+    // kept vertices: at borders, at non-manifold edges and at seams. The
+    // edges are checked again after each pass, a vertex stays locked.
+    QVector<char> locked(vertexCount, 0);
+    QVector<quint64> edges;
+    auto lockEdges = [&locked, &edges] (const IndexVector& tri) {
+        edges.clear();
+        edges.reserve(tri.size());
+        for (int i = 0; i < tri.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                quint64 a = tri[i + k];
+                quint64 b = tri[i + (k + 1) % 3];
+                edges.append(a < b ? a << 32 | b : b << 32 | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (int i = 0; i < edges.size();) {
+            int j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i]) j++;
+            if (j - i != 2) {
+                locked[edges[i] >> 32] = 1;
+                locked[edges[i] & 0xffffffff] = 1;
+            }
+            i = j;
+        }
+    };
+    QVector<uint> order;
+    QVector<char> used(vertexCount, 0);
+    for (uint v: qAsConst(result)) {
+        if (!used[v]) order.append(v);
+        used[v] = 1;
+    }
+    auto less = [&positions] (uint a, uint b) {
+        const Math3D::Vector4& p = positions[a];
+        const Math3D::Vector4& q = positions[b];
+        if (p[0] != q[0]) return p[0] < q[0];
+        if (p[1] != q[1]) return p[1] < q[1];
+        return p[2] < q[2];
+    };
+    std::sort(order.begin(), order.end(), less);
+    for (int i = 1; i < order.size(); i++) {
+        if (!less(order[i - 1], order[i])) locked[order[i - 1]] = locked[order[i]] = 1;
+    }
+
+    // area weighted face planes rank the collapses. The reported plane
+    // distance is the largest distance of a kept vertex to the original
+    // face planes merged into it: vertices do not move, so only the planes
+    // of the merged vertex need to be measured. It is not a bound on the
+    // distance between the surfaces.
+    QVector<Quadric> quadrics(vertexCount);
+    QVector<Plane> planes;
+    QVector<QVector<int>> vertexPlanes(vertexCount);
+    for (int i = 0; i < result.size(); i += 3) {
+        const Math3D::Vector4& a = positions[result[i]];
+        double n[3];
+        faceNormal(a, positions[result[i + 1]], positions[result[i + 2]], n);
+        double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len == 0) continue;
+        for (int k = 0; k < 3; k++) n[k] /= len;
+        double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+        Quadric q(n, d, len / 2);
+        for (int k = 0; k < 3; k++) {
+            quadrics[result[i + k]] += q;
+            vertexPlanes[result[i + k]].append(planes.size());
+        }
+        planes.append({{n[0], n[1], n[2]}, d});
+    }
+
+    double maxDistance = 0;
+    QVector<int> offsets(vertexCount + 1);
+    QVector<int> adjacency;
+    QVector<uint> remap(vertexCount);
+    QVector<char> touched(vertexCount);
+    QVector<int> marks(vertexCount, 0);
+    int mark = 0;
+    while (result.size() / 3 > targetCount) {
+        int numTriangles = result.size() / 3;
+        const uint* tri = result.constData();
+        lockEdges(result);
+
+        // triangles of vertex v: adjacency[offsets[v], offsets[v + 1])
+        offsets.fill(0);
+        for (uint v: qAsConst(result)) offsets[v + 1]++;
+        for (int v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+        adjacency.resize(result.size());
+        QVector<int> fill = offsets;
+        for (int i = 0; i < result.size(); i++) adjacency[fill[tri[i]]++] = i / 3;
+
+        // each edge once, both directions
+        QVector<Collapse> collapses;
+        for (int i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                uint a = tri[i + k];
+                uint b = tri[i + (k + 1) % 3];
+                if (a > b) continue;
+                Quadric q = quadrics[a];
+                q += quadrics[b];
+                if (!locked[a]) collapses.append({a, b, q.error(positions[b])});
+                if (!locked[b]) collapses.append({b, a, q.error(positions[a])});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [] (const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost;
+        });
+
+        // independent collapses: the triangles around a merged vertex are
+        // left alone for the rest of the pass
+        for (int v = 0; v < vertexCount; v++) remap[v] = v;
+        touched.fill(0);
+        // a collapse removes about two triangles
+        int budget = (numTriangles - targetCount) / 2 + 1;
+        int done = 0;
+        for (const Collapse& c: qAsConst(collapses)) {
+            if (done == budget) break;
+            if (touched[c.from] || touched[c.to]) continue;
+            // no flipped triangles, nor ones turned on their edge: a
+            // triangle may not rotate by more than about 75 degrees
+            bool flips = false;
+            for (int j = offsets[c.from]; j < offsets[c.from + 1] && !flips; j++) {
+                const uint* t = tri + 3 * adjacency[j];
+                if (t[0] == c.to || t[1] == c.to || t[2] == c.to) continue;
+                Math3D::Vector4 p[3];
+                for (int k = 0; k < 3; k++) p[k] = positions[t[k]];
+                double before[3];
+                faceNormal(p[0], p[1], p[2], before);
+                for (int k = 0; k < 3; k++) {
+                    if (t[k] == c.from) p[k] = positions[c.to];
+                }
+                double after[3];
+                faceNormal(p[0], p[1], p[2], after);
+                double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2])
+                                           * (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                flips = dot <= MinCosine * lengths;
+            }
+            if (flips) continue;
+            // link condition: the only vertices next to both ends are the
+            // ones opposite the edge, else the collapse pinches the surface
+            mark++;
+            int opposite = 0;
+            for (int j = offsets[c.from]; j < offsets[c.from + 1]; j++) {
+                const uint* t = tri + 3 * adjacency[j];
+                for (int k = 0; k < 3; k++) {
+                    if (t[k] == c.to) opposite++;
+                    if (t[k] != c.from) marks[t[k]] = mark;
+                }
+            }
+            int shared = 0;
+            for (int j = offsets[c.to]; j < offsets[c.to + 1]; j++) {
+                const uint* t = tri + 3 * adjacency[j];
+                for (int k = 0; k < 3; k++) {
+                    if (t[k] == c.to || marks[t[k]] != mark) continue;
+                    marks[t[k]] = 0;
+                    shared++;
+                }
+            }
+            if (shared != opposite) continue;
+            for (int j = offsets[c.from]; j < offsets[c.from + 1]; j++) {
+                const uint* t = tri + 3 * adjacency[j];
+                for (int k = 0; k < 3; k++) touched[t[k]] = 1;
+            }
+            remap[c.from] = c.to;
+            quadrics[c.to] += quadrics[c.from];
+            const Math3D::Vector4& p = positions[c.to];
+            for (int k: qAsConst(vertexPlanes[c.from])) {
+                maxDistance = std::max(maxDistance, planes[k].distance(p));
+            }
+            vertexPlanes[c.to] += vertexPlanes[c.from];
+            vertexPlanes[c.from].clear();
+            done++;
+        }
+        if (done == 0) break;
+
+        IndexVector next;
+        next.reserve(result.size());
+        for (int i = 0; i < result.size(); i += 3) {
+            uint a = remap[tri[i]];
+            uint b = remap[tri[i + 1]];
+            uint d = remap[tri[i + 2]];
+            if (a == b || b == d || d == a) continue;
+            next << a << b << d;
+        }
+        result = next;
+    }
+    planeDistance = maxDistance;
+    return result;
+}
+
+void Mesh::appendStrip(IndexVector& triangles, const IndexVector& strip) {
+    for (int k = 2; k < strip.size(); k++) {
+        uint a = strip[k - 2];
+        uint b = strip[k - 1];
+        uint c = strip[k];
+        if (a == b || b == c || c == a) continue;
+        // every other triangle of a strip is reversed
+        if (k % 2) {
+            triangles << b << a << c;
+        } else {
+            triangles << a << b << c;
+        }
+    }
+}
+
+Mesh::Statistics Mesh::analyze(const IndexVector& triangles, int vertexCount, int vertexSize) {
+    Statistics stats;
+    int numTriangles = triangles.size() / 3;
+    if (numTriangles == 0) return stats;
+    const uint* tri = triangles.constData();
+
+    const int LineSize = 64;
+    const uint Lines = 16384 / LineSize;
+    qint64 numLines = (qint64(vertexCount) * vertexSize + LineSize - 1) / LineSize;
+    QVector<uint> lineStamps(numLines, 0);
+    uint lineTime = Lines + 1;
+    qint64 fetched = 0;
+
+    QVector<uint> timestamps(vertexCount, 0);
+    uint timestamp = FifoCache + 1;
+    int misses = 0;
+    for (int i = 0; i < 3 * numTriangles; i++) {
+        uint v = tri[i];
+        if (timestamp - timestamps[v] <= FifoCache) continue;
+        timestamps[v] = timestamp++;
+        misses++;
+        // the vertex shader reads the vertex
+        qint64 first = qint64(v) * vertexSize / LineSize;
+        qint64 last = (qint64(v) * vertexSize + vertexSize - 1) / LineSize;
+        for (qint64 l = first; l <= last; l++) {
+            if (lineTime - lineStamps[l] > Lines) {
+                lineStamps[l] = lineTime++;
+                fetched += LineSize;
+            }
+        }
+    }
+
+    int used = 0;
+    QVector<char> seen(vertexCount, 0);
+    for (int i = 0; i < 3 * numTriangles; i++) {
+        if (!seen[tri[i]]) {
+            seen[tri[i]] = 1;
+            used++;
+        }
+    }
+
+    stats.acmr = float(misses) / numTriangles;
+    stats.atvr = float(misses) / used;
+    stats.overfetch = float(fetched) / (qint64(used) * vertexSize);
+    return stats;
+}
@@ -0,0 +1,62 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include "math3d.h"
+#include <QVector>
+
+namespace Demo {
+namespace Mesh {
+
+// Index order optimization of indexed triangle lists. Triangles are index
+// triplets with counter clockwise winding, vertices are indexed from 0 to
+// vertexCount - 1.
+
+using IndexVector = QVector<uint>;
+using Vector4Vector = QVector<Math3D::Vector4>;
+
+// Triangle order for a post-transform vertex cache (Forsyth). Returns the
+// reordered triangles.
+IndexVector optimizeVertexCache(const IndexVector& triangles, int vertexCount);
+
+// Reorders clusters of cache optimized triangles so that the clusters
+// likely to occlude others come first (Sander, Nehab & Barczak). The
+// clusters are split as long as their ACMR stays within threshold times
+// the ACMR of the input.
+IndexVector optimizeOverdraw(const IndexVector& triangles, const Vector4Vector& positions, float threshold = 1.05f);
+
+// Vertex order of first use. Returns the new index of each vertex; unused
+// vertices are moved to the end. The triangles are remapped in place.
+IndexVector optimizeVertexFetch(IndexVector& triangles, int vertexCount);
+
+// Quadric error edge collapse (Garland & Heckbert) towards targetCount
+// triangles. Vertices are not moved, a collapse merges a vertex into a
+// neighbour. Border vertices and vertices sharing their position with
+// others, e.g. at texture seams, are kept, and a collapse may not pinch
+// the surface (link condition). Sets planeDistance to the largest
+// distance of a kept vertex to the planes of the original faces around
+// the vertices merged into it, an estimate of the error and not a bound.
+IndexVector simplify(const IndexVector& triangles, const Vector4Vector& positions, int targetCount, float& planeDistance);
+
+// Triangles of a triangle strip, degenerate ones dropped
+void appendStrip(IndexVector& triangles, const IndexVector& strip);
+
+class Statistics {
+public:
+    Statistics()
+        : acmr(0)
+        , atvr(0)
+        , overfetch(0) {}
+    // vertex shader invocations per triangle and per used vertex
+    float acmr;
+    float atvr;
+    // vertex bytes read through 64 byte cache lines per byte used
+    float overfetch;
+};
+
+// FIFO cache of 16 vertices, 16 kB of cache lines for vertexSize strided
+// vertices
+Statistics analyze(const IndexVector& triangles, int vertexCount, int vertexSize);
+
+}} // namespace Demo::Mesh
+
+#endif // MESHOPTIMIZER_H
@@ -2,6 +2,16 @@
 #include "logging.h"
 #include <QPluginLoader>
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QtConcurrent>
+#include <QSemaphore>
+#include <QFloat16>
+#include <algorithm>
+#include <cmath>
 
 #include "wavefront_parser.h"
 #ifndef YYSTYPE
@@ -15,42 +25,68 @@
 #include "triangleoptimizer.h"
 #include "gl_widget.h"
 #include "patcher.h"
+#include "batchmath.h"
+#include "objreader.h"
+#include "meshoptimizer.h"
 
 using Math3D::Vector4;
 
 using namespace Demo::GL;
 
+const GLuint ModelStore::RestartIndex;
+
 ModelStore::ModelStore()
     : ProjectFolder("modelstore")
     , Blob()
     , mContext(nullptr)
-    , mError()
-    , mScanner(nullptr)
-    , mPatchState()
+    , mCacheDir()
 {
     mData[GL_ARRAY_BUFFER] = Data();
     mData[GL_ELEMENT_ARRAY_BUFFER] = Data();
 }
 
+ModelStore::Loader::Loader()
+    : mError()
+    , mScanner(nullptr)
+    , mReader(true)
+    , mSourceSize(0)
+    , mSourceTime(0)
+    , mPatchState()
+{}
+
 void ModelStore::rename(const QString& from, const QString& to) {
     if (mIndexMap.contains(from)) {
         int index = mIndexMap.take(from);
         mIndexMap[to] = index;
         mModels[index].name = to;
-        mSpecs[to + ":vertex"] = mSpecs.take(from + ":vertex");
-        mSpecs[to + ":normal"] = mSpecs.take(from + ":normal");
-        mSpecs[to + ":tex"] = mSpecs.take(from + ":tex");
+        if (mLayouts.contains(from)) mLayouts[to] = mLayouts.take(from);
+        if (mFormats.contains(from)) mFormats[to] = mFormats.take(from);
+        changed();
+        renameSpec(from + ":vertex", to + ":vertex");
+        renameSpec(from + ":normal", to + ":normal");
+        renameSpec(from + ":tex", to + ":tex");
     }
 }
 
 void ModelStore::remove(int index) {
     if (index < 0 || index >= mModels.size()) return;
+    const Model& model = mModels[index];
+    // the other models stay where they are
+    mVertexHeap.release(model.vertexOffset, model.vertexBytes);
+    mElementHeap.release(model.elementOffset, model.elementBytes);
+    removeSpec(model.name + ":vertex");
+    removeSpec(model.name + ":normal");
+    removeSpec(model.name + ":tex");
+    mLayouts.remove(model.name);
+    mFormats.remove(model.name);
     mModels.removeAt(index);
     mIndexMap.clear();
     for (int k = 0; k < mModels.size(); ++k) {
         mIndexMap[mModels[k].name] = k;
     }
-    makeModelBuffer();
+    changed();
+    mMoved = false;
+    mRescaled = false;
 }
 
 int ModelStore::size() const {
@@ -76,37 +112,58 @@ void ModelStore::setContext(GLWidget *context) {
 
 #define ALT(item) case item: throw RunError(#item, 0); break
 
-void ModelStore::draw(unsigned int mode, const QString& name) const {
+int ModelStore::drawKey(const QString& name) const {
+    return mIndexMap.value(name, -1);
+}
+
+void ModelStore::draw(unsigned int mode, int index) const {
+    drawLod(mode, index, 0);
+}
+
+// the wireframe has always full detail
+void ModelStore::drawLod(unsigned int mode, int index, int lod) const {
     if (!mContext) {
         throw RunError("Context not initialized", 0);
     }
     int id;
-    mContext->glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &id);
+    mContext->backend()->glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &id);
     if (id == 0) {
         throw RunError("Missing array buffer binding", 0);
     }
-    if (!mIndexMap.contains(name)) {
-        throw RunError(QString("%1: no such model").arg(name), 0);
+    if (index < 0 || index >= mModels.size()) {
+        throw RunError("No such model", 0);
     }
-    int index = mIndexMap[name];
-    if (mode == GL_TRIANGLES || mode == GL_POINTS) {
+    const Model& model = mModels[index];
+    if (lod < 0 || lod > model.lods.size()) {
+        throw RunError("No such level of detail", 0);
+    }
+    if (lod > 0 && (mode == GL_TRIANGLES || mode == GL_POINTS)) {
+        GLsizei count = model.lods[lod - 1].triangles.size();
+        size_t offset = model.lods[lod - 1].offset;
+        mContext->backend()->glDrawElements(mode, count, model.indexType, (const GLvoid*) offset);
+    } else if (model.layout == Triangles && (mode == GL_TRIANGLES || mode == GL_POINTS)) {
+        GLsizei count = model.triangles.size();
+        size_t offset = model.trianglesOffset;
+        mContext->backend()->glDrawElements(mode, count, model.indexType, (const GLvoid*) offset);
+    } else if (mode == GL_TRIANGLES || mode == GL_POINTS) {
         if (mode == GL_TRIANGLES) mode = GL_TRIANGLE_STRIP;
-        const GLsizei* count = mModels[index].stripSizes.constData();
-        const uintptr_t* offsets = mModels[index].stripOffsets.constData();
-        GLsizei numStrips = mModels[index].stripOffsets.size();
-        mContext->glMultiDrawElements(mode, count, GL_UNSIGNED_INT, (const GLvoid*const*) offsets, numStrips);
-        // for (int i = 0; i < numStrips; i++) {
-        //     mContext->glDrawElements(mode, count[i], GL_UNSIGNED_INT, (const GLvoid*) offsets[i]);
-        // }
+        GLsizei count = model.strips.size();
+        size_t offset = model.stripsOffset;
+        // all strips in one call, restart indices are skipped as points too.
+        // Scripts may have enabled restart themselves: leave it as it was.
+        GLboolean restart = mContext->backend()->glIsEnabled(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        if (!restart) mContext->backend()->glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        mContext->backend()->glDrawElements(mode, count, model.indexType, (const GLvoid*) offset);
+        if (!restart) mContext->backend()->glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
     } else if (mode == GL_LINES) {
-        GLsizei count = mModels[index].wireFrame.size();
-        size_t offset = mModels[index].wireFrameOffset;
-        mContext->glDrawElements(GL_LINES, count, GL_UNSIGNED_INT, (const GLvoid*) offset);
+        GLsizei count = model.wireFrame.size();
+        size_t offset = model.wireFrameOffset;
+        mContext->backend()->glDrawElements(GL_LINES, count, model.indexType, (const GLvoid*) offset);
     } else {
         throw RunError("Unsupported drawing mode", 0);
     }
 
-    switch (glGetError()) {
+    switch (mContext->backend()->glGetError()) {
     ALT(GL_INVALID_ENUM);
     ALT(GL_INVALID_VALUE);
     ALT(GL_INVALID_OPERATION);
@@ -116,15 +173,45 @@ void ModelStore::draw(unsigned int mode, const QString& name) const {
 
 #undef ALT
 
-void ModelStore::appendVertex(float x, float y, float z, float w) {
+Math3D::Matrix4 ModelStore::dequantization(int index) const {
+    Math3D::Matrix4 m;
+    m.setIdentity();
+    if (index < 0 || index >= mModels.size()) return m;
+    const Model& model = mModels[index];
+    if (format(model.name) != Quantized) return m;
+    Vector4 extent = model.hi - model.lo;
+    m.setScaling(extent[0], extent[1], extent[2]);
+    for (int i = 0; i < 3; i++) m(3)[i] = model.lo[i];
+    return m;
+}
+
+// An object space error e moves a vertex at most e * |row3(i)| in clip
+// x and y, i.e. e * |row3(i)| * size / 2w pixels. The smallest w is at the
+// bounding sphere; full detail if the sphere reaches the camera plane.
+int ModelStore::lod(int index, const Math3D::Matrix4& clip, float width, float height, float pixels) const {
+    if (index < 0 || index >= mModels.size()) return 0;
+    const Model& model = mModels[index];
+    if (model.lods.isEmpty()) return 0;
+    Vector4 center = (model.lo + model.hi) * 0.5;
+    float radius = (model.hi - model.lo).length3() * 0.5;
+    Vector4 row = clip.row3(3);
+    float w = Math3D::dot3(row, center) + clip[3][3] - radius * row.length3();
+    if (w <= 0) return 0;
+    float scale = std::max(clip.row3(0).length3() * width, clip.row3(1).length3() * height) / (2 * w);
+    int lod = 0;
+    while (lod < model.lods.size() && model.lods[lod].planeDistance * scale <= pixels) lod++;
+    return lod;
+}
+
+void ModelStore::Loader::appendVertex(float x, float y, float z, float w) {
     mVertices.append(Vector4(x, y, z, w));
 }
 
-void ModelStore::appendNormal(float x, float y, float z) {
+void ModelStore::Loader::appendNormal(float x, float y, float z) {
     mNormals.append(Vector4(x, y, z, 0));
 }
 
-void ModelStore::appendTex(float u, float v) {
+void ModelStore::Loader::appendTex(float u, float v) {
     mTexCoords.append(Vector4(u, v, 0, 0));
 }
 
@@ -134,68 +221,55 @@ static unsigned int makeIndex(int x, unsigned int l) {
     return (x - 1) % l;
 }
 
-QString ModelStore::makeKey(const WF::TripletIndex& t) {
-    unsigned int v_index = makeIndex(t.v_index, mVertices.size());
-    unsigned int n_index = makeIndex(t.n_index, mNormals.size());
-    unsigned int t_index = makeIndex(t.t_index, mTexCoords.size());
-
-    if (t.n_index && t.t_index) {
-        return QString("%1:%2:%3").arg(v_index).arg(n_index).arg(t_index);
-    }
-
-    if (t.n_index) {
-        return QString("%1:%2:").arg(v_index).arg(n_index);
-    }
-
-    if (t.t_index) {
-        return QString("%1::%2").arg(v_index).arg(t_index);
-    }
-
-    return QString("%1::").arg(v_index);
+Demo::VertexKey ModelStore::Loader::makeKey(const WF::TripletIndex& t, uint Lv, uint Ln, uint Lt) {
+    VertexKey key(makeIndex(t.v_index, Lv));
+    if (t.n_index) key.n_index = makeIndex(t.n_index, Ln);
+    if (t.t_index) key.t_index = makeIndex(t.t_index, Lt);
+    return key;
 }
 
-QString ModelStore::makeKey(uint v1, uint v2) {
-    if (v1 < v2) return QString("%1:%2").arg(v1).arg(v2);
-    return QString("%1:%2").arg(v2).arg(v1);
+void ModelStore::Loader::appendFace(const WF::TripletIndexVector& ts) {
+    appendFace(ts.constData(), ts.size(), mVertices.size(), mNormals.size(), mTexCoords.size());
 }
 
-void ModelStore::appendFace(const WF::TripletIndexVector& ts) {
-    if (ts.size() < 3) return;
+// Lv, Ln, Lt: number of vertices, normals and tex coords read before the face
+void ModelStore::Loader::appendFace(const WF::TripletIndex* ts, int size, uint Lv, uint Ln, uint Lt) {
+    if (size < 3) return;
 
-    unsigned int Lv = mVertices.size();
     if (!Lv) return;
 
     IndexVector face;
-    for (const WF::TripletIndex& t: ts) {
-        QString key = makeKey(t);
-        if (!mVertexCache.contains(key)) {
+    for (int i = 0; i < size; i++) {
+        const WF::TripletIndex& t = ts[i];
+        bool inserted;
+        GLuint index = mVertexCache.insert(makeKey(t, Lv, Ln, Lt), mVertexData.size(), inserted);
+        if (inserted) {
             unsigned int v_index = makeIndex(t.v_index, Lv);
             VertexData data(mVertices[v_index]);
 
             if (!t.n_index) {
                 mGenNormals.append(v_index);
             } else {
-                unsigned int n_index = makeIndex(t.n_index, mNormals.size());
+                unsigned int n_index = makeIndex(t.n_index, Ln);
                 data.normal = mNormals[n_index];
             }
 
             if (!t.t_index) {
                 mGenTexes.append(v_index);
             } else {
-                unsigned int t_index = makeIndex(t.t_index, mTexCoords.size());
+                unsigned int t_index = makeIndex(t.t_index, Lt);
                 data.tex = mTexCoords[t_index];
             }
             mVertexData.append(data);
-            mVertexCache[key] = mVertexData.size() - 1;
         }
-        face.append(mVertexCache[key]);
+        face.append(index);
     }
 
     // append wireframe indices
     for (int i = 1; i < face.size(); i++) {
-        QString key = makeKey(face[i-1], face[i]);
-        if (mEdgeCache.contains(key)) continue;
-        mEdgeCache[key] = 0; // value is unimportant
+        bool inserted;
+        mEdgeCache.insert(EdgeKey(face[i-1], face[i]), 0, inserted); // value is unimportant
+        if (!inserted) continue;
         mWireframeIndices.append(face[i-1]);
         mWireframeIndices.append(face[i]);
     }
@@ -209,29 +283,29 @@ void ModelStore::appendFace(const WF::TripletIndexVector& ts) {
 }
 
 
-bool ModelStore::inPatchDef() const {
+bool ModelStore::Loader::inPatchDef() const {
     return mPatchState.insurf;
 }
 
-void ModelStore::setPatchType(const QString& name, bool) {
+void ModelStore::Loader::setPatchType(const QString& name, bool) {
     delete mPatchState.patcher;
     mPatchState.patcher = WF::Patcher::Create(name);
 }
 
-void ModelStore::setPatchKnots(const QString& v, const WF::NumericVector& knots) {
+void ModelStore::Loader::setPatchKnots(const QString& v, const WF::NumericVector& knots) {
     mPatchState.patcher->setKnots(v, knots);
 }
 
-void ModelStore::setPatchRank(int udeg, int vdeg) {
+void ModelStore::Loader::setPatchRank(int udeg, int vdeg) {
     mPatchState.udeg = udeg;
     mPatchState.vdeg = vdeg;
 }
 
-bool ModelStore::checkPatchState() const {
+bool ModelStore::Loader::checkPatchState() const {
     return mPatchState.checkState();
 }
 
-void ModelStore::beginPatch(float u0, float u1, float v0, float v1, const WF::IndexVector& controlpoints) {
+void ModelStore::Loader::beginPatch(float u0, float u1, float v0, float v1, const WF::IndexVector& controlpoints) {
     mPatchState.insurf = true;
     mPatchState.patcher->setBoundary(u0, u1, v0, v1);
     Vector4Vector cv;
@@ -242,7 +316,7 @@ void ModelStore::beginPatch(float u0, float u1, float v0, float v1, const WF::In
     mPatchState.patcher->setControlPoints(mPatchState.udeg, mPatchState.vdeg, cv);
 }
 
-void ModelStore::endPatch() {
+void ModelStore::Loader::endPatch() {
     mPatchState.insurf = false;
     mPatchState.patcher->gendata(mPatchState.vertices.size());
     mPatchState.wireframe.append(mPatchState.patcher->wireframe());
@@ -258,72 +332,205 @@ void ModelStore::endPatch() {
 }
 
 
-void ModelStore::makeModelBuffer() {
+// byte ranges are aligned for GLuint indices and float attributes
+static uint align4(uint size) {
+    return (size + 3) & ~3u;
+}
 
-    mSpecs.clear();
-    delete mData[GL_ARRAY_BUFFER].data;
-    mData[GL_ARRAY_BUFFER] = Data();
-    delete mData[GL_ELEMENT_ARRAY_BUFFER].data;
-    mData[GL_ELEMENT_ARRAY_BUFFER] = Data();
+static char* packIndices(const QVector<GLuint>& indices, GLenum type, char* q) {
+    if (type == GL_UNSIGNED_INT) {
+        ::memcpy(q, indices.constData(), indices.size() * sizeof(GLuint));
+        return q + indices.size() * sizeof(GLuint);
+    }
+    GLushort* s = reinterpret_cast<GLushort*>(q);
+    for (GLuint idx: indices) *s++ = idx;
+    return reinterpret_cast<char*>(s);
+}
 
-    // pass 1: compute specs & buffer length
-    uint32_t vertexSize = 0;
-    uint32_t elemSize = 0;
-    for (Model& model: mModels) {
-        // vertex data sizes & offsets
-        uint32_t modelSize = model.vertices.size() * sizeof(GLfloat) * 8;
-        // blob specs: num components, type, is normalized, packing offset, data offset
-        mSpecs[model.name + ":vertex"] = BlobSpec(3, GL_FLOAT, false, 0, vertexSize);
-        mSpecs[model.name + ":normal"] = BlobSpec(3, GL_FLOAT, true, 0, vertexSize + modelSize / 8 * 3);
-        mSpecs[model.name + ":tex"] = BlobSpec(2, GL_FLOAT, false, 0, vertexSize + modelSize / 8 * 6);
-        vertexSize += modelSize;
-        // element index sizes & offsets
-        model.stripOffsets.clear();
-        model.stripSizes.clear();
-        int stripSize = 0;
-        for (const Strip& strip: qAsConst(model.strips)) {
-            model.stripOffsets.append(elemSize + stripSize);
-            model.stripSizes.append(strip.size());
-            stripSize += strip.size() * sizeof(GLuint);
+// 0xffff is the 16 bit restart index
+bool ModelStore::shortIndices(const Model& model) const {
+    return format(model.name) != Planar && model.vertices.size() <= 0xffff;
+}
+
+uint ModelStore::vertexBytes(const Model& model) const {
+    return align4(model.vertexCapacity * vertexSize(format(model.name)));
+}
+
+// Room to grow: a reloaded model that grows a little keeps its place,
+// and models can be added without rebuilding the buffers
+static uint withSlack(uint size) {
+    return size + size / 8;
+}
+
+uint ModelStore::elementBytes(const Model& model) const {
+    uint count = model.strips.size() + model.triangles.size() + model.wireFrame.size();
+    for (const Lod& lod: model.lods) count += lod.triangles.size();
+    return align4(count * (shortIndices(model) ? sizeof(GLushort) : sizeof(GLuint)));
+}
+
+// Packs the model to its byte ranges and sets its specs and offsets
+void ModelStore::writeModel(Model& model) {
+    Format fmt = format(model.name);
+    uint base = model.vertexOffset;
+    char* p = mData[GL_ARRAY_BUFFER].data + base;
+    // blob specs: num components, type, is normalized, stride, data offset
+    if (fmt == Planar) {
+        // the attribute blocks are sized by the capacity: their offsets
+        // stay put while the model fits
+        uint n = model.vertexCapacity;
+        setSpec(model.name + ":vertex", BlobSpec(3, GL_FLOAT, false, 0, base));
+        setSpec(model.name + ":normal", BlobSpec(3, GL_FLOAT, true, 0, base + n * 3 * sizeof(GLfloat)));
+        setSpec(model.name + ":tex", BlobSpec(2, GL_FLOAT, false, 0, base + n * 6 * sizeof(GLfloat)));
+        packVertices(model.vertices, p, n);
+    } else {
+        int stride = vertexSize(fmt);
+        int normal = fmt == Quantized ? 4 * sizeof(GLushort) : 3 * sizeof(GLfloat);
+        if (fmt == Quantized) {
+            setSpec(model.name + ":vertex", BlobSpec(3, GL_UNSIGNED_SHORT, true, stride, base));
+        } else {
+            setSpec(model.name + ":vertex", BlobSpec(3, GL_FLOAT, false, stride, base));
         }
-        elemSize += stripSize;
-        model.wireFrameOffset = elemSize;
-        elemSize += model.wireFrame.size() * sizeof(GLuint);
+        setSpec(model.name + ":normal", BlobSpec(4, GL_INT_2_10_10_10_REV, true, stride, base + normal));
+        setSpec(model.name + ":tex", BlobSpec(2, GL_HALF_FLOAT, false, stride, base + normal + sizeof(quint32)));
+        packInterleaved(model, fmt, p);
     }
 
-    mData[GL_ARRAY_BUFFER].data = new char[vertexSize];
-    mData[GL_ARRAY_BUFFER].length = vertexSize;
-    mData[GL_ELEMENT_ARRAY_BUFFER].data = new char[elemSize];
-    mData[GL_ELEMENT_ARRAY_BUFFER].length = elemSize;
+    model.indexType = shortIndices(model) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    uint isize = shortIndices(model) ? sizeof(GLushort) : sizeof(GLuint);
+    model.stripsOffset = model.elementOffset;
+    model.trianglesOffset = model.stripsOffset + model.strips.size() * isize;
+    model.wireFrameOffset = model.trianglesOffset + model.triangles.size() * isize;
+    char* q = mData[GL_ELEMENT_ARRAY_BUFFER].data + model.elementOffset;
+    q = packIndices(model.strips, model.indexType, q);
+    q = packIndices(model.triangles, model.indexType, q);
+    q = packIndices(model.wireFrame, model.indexType, q);
+    uint offset = model.wireFrameOffset + model.wireFrame.size() * isize;
+    for (Lod& lod: model.lods) {
+        lod.offset = offset;
+        offset += lod.triangles.size() * isize;
+        q = packIndices(lod.triangles, model.indexType, q);
+    }
+}
 
-    unsigned int nsize = 3 * sizeof(GLfloat);
-    unsigned int tsize = 2 * sizeof(GLfloat);
-    unsigned int isize = 1 * sizeof(GLuint);
-    char* p = mData[GL_ARRAY_BUFFER].data;
-    char* q = mData[GL_ELEMENT_ARRAY_BUFFER].data;
-    for (const Model& m: qAsConst(mModels)) {
-        for (auto& d: m.vertices) {
-            ::memcpy(p, d.vertex.readArray(), nsize); p += nsize;
-        }
-        for (auto& d: m.vertices) {
-            ::memcpy(p, d.normal.readArray(), nsize); p += nsize;
-        }
-        for (auto& d: m.vertices) {
-            ::memcpy(p, d.tex.readArray(), tsize); p += tsize;
-        }
+// All models packed from the start of the buffers with some slack, with
+// room for as much again if grow is set. The scripts have to upload the
+// buffers again.
+void ModelStore::makeModelBuffer(bool grow) {
 
-        for (const Strip& strip: m.strips) {
-            for (auto idx: strip) {
-                ::memcpy(q, &idx, isize); q += isize;
-            }
-        }
+    clearSpecs();
+    forgetUploads();
+    mMoved = true;
 
-        for (auto idx: m.wireFrame) {
-            ::memcpy(q, &idx, isize); q += isize;
+    uint vertexSize = 0;
+    uint elemSize = 0;
+    for (Model& model: mModels) {
+        model.vertexCapacity = withSlack(model.vertices.size());
+        model.vertexBytes = vertexBytes(model);
+        model.elementBytes = elementBytes(model);
+        vertexSize += model.vertexBytes;
+        elemSize += model.elementBytes;
+    }
+    vertexSize = align4(withSlack(vertexSize));
+    elemSize = align4(withSlack(elemSize));
+    if (grow) {
+        vertexSize = std::max(vertexSize, 2 * mVertexHeap.capacity());
+        elemSize = std::max(elemSize, 2 * mElementHeap.capacity());
+    }
+    mVertexHeap.reset(vertexSize);
+    mElementHeap.reset(elemSize);
+
+    delete [] mData[GL_ARRAY_BUFFER].data;
+    mData[GL_ARRAY_BUFFER] = Data(new char[vertexSize](), vertexSize);
+    delete [] mData[GL_ELEMENT_ARRAY_BUFFER].data;
+    mData[GL_ELEMENT_ARRAY_BUFFER] = Data(new char[elemSize](), elemSize);
+
+    for (Model& model: mModels) {
+        model.vertexOffset = mVertexHeap.allocate(model.vertexBytes);
+        model.elementOffset = mElementHeap.allocate(model.elementBytes);
+        writeModel(model);
+    }
+}
+
+// Allocates the byte ranges of the model, at the hints if there is room,
+// and updates the uploaded buffers. The buffers are rebuilt when full.
+void ModelStore::placeModel(int index, uint vertexHint, uint elementHint) {
+    Model& model = mModels[index];
+    uint n = model.vertices.size();
+    if (model.vertexCapacity < n) model.vertexCapacity = withSlack(n);
+    model.vertexBytes = vertexBytes(model);
+    model.elementBytes = elementBytes(model);
+    uint v = mVertexHeap.allocate(model.vertexBytes, vertexHint);
+    uint e = mElementHeap.allocate(model.elementBytes, elementHint);
+    if (v == BufferHeap::Full || e == BufferHeap::Full) {
+        makeModelBuffer(true);
+        return;
+    }
+    model.vertexOffset = v;
+    model.elementOffset = e;
+    writeModel(model);
+    upload(GL_ARRAY_BUFFER, v, model.vertexBytes);
+    upload(GL_ELEMENT_ARRAY_BUFFER, e, model.elementBytes);
+}
+
+// The model at index takes the place of old if it fits
+void ModelStore::replaceModel(int index, const Model& old) {
+    const char* attrs[] = {":vertex", ":normal", ":tex"};
+    BlobSpec specs[3];
+    for (int i = 0; i < 3; i++) specs[i] = spec(old.name + attrs[i]);
+    mVertexHeap.release(old.vertexOffset, old.vertexBytes);
+    mElementHeap.release(old.elementOffset, old.elementBytes);
+    // keeps the capacity if the model fits in it
+    mModels[index].vertexCapacity = old.vertexCapacity;
+    placeModel(index, old.vertexOffset, old.elementOffset);
+    const Model& model = mModels[index];
+    if (format(old.name) == Quantized && (model.lo != old.lo || model.hi != old.hi)) {
+        mRescaled = true;
+    }
+    for (int i = 0; i < 3; i++) {
+        BlobSpec s = spec(old.name + attrs[i]);
+        if (s.offset != specs[i].offset || s.stride != specs[i].stride || s.type != specs[i].type) {
+            mMoved = true;
         }
     }
 }
 
+// Writes a changed range to the buffer object that a script uploaded the
+// data of target to
+void ModelStore::upload(unsigned int target, uint offset, uint length) const {
+    if (!mContext || length == 0 || !mUploads.contains(target)) return;
+    Backend* gl = mContext->backend();
+    if (gl->live()) mContext->makeCurrent();
+    // leaves the array and vertex array bindings alone
+    GLint bound;
+    gl->glGetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &bound);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, mUploads[target]);
+    gl->glBufferSubData(GL_COPY_WRITE_BUFFER, offset, length, mData[target].data + offset);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, bound);
+}
+
+void ModelStore::setFormat(const QString& key, Format format) {
+    if (this->format(key) == format) return;
+    bool quantized = this->format(key) == Quantized || format == Quantized;
+    mFormats[key] = format;
+    if (!mIndexMap.contains(key)) return;
+    mMoved = false;
+    mRescaled = quantized;
+    Model old = mModels[mIndexMap[key]];
+    replaceModel(mIndexMap[key], old);
+}
+
+ModelStore::Format ModelStore::format(const QString& key) const {
+    return mFormats.value(key, Planar);
+}
+
+int ModelStore::vertexSize(Format format) {
+    switch (format) {
+    case Interleaved: return 3 * sizeof(GLfloat) + sizeof(quint32) + 2 * sizeof(qfloat16);
+    case Quantized: return 4 * sizeof(GLushort) + sizeof(quint32) + 2 * sizeof(qfloat16);
+    default: return 8 * sizeof(GLfloat);
+    }
+}
+
 
 
 static const char square [] =
@@ -339,24 +546,65 @@ static const char square [] =
     "f 1/1/1 2/2/1 3/3/1 4/4/1\n";
 
 
-void ModelStore::parseModelData(const QString& path) {
+void ModelStore::Loader::parseModelData(const QString& path) {
 
-    resetParser();
+    reset();
 
     QString inp(square);
+    mSourceSize = 0;
+    mSourceTime = 0;
+    mSourceHash.clear();
     if (!path.isEmpty()) {
+        // stat before reading: a later write changes the mtime
+        mSourceTime = QFileInfo(path).lastModified().toMSecsSinceEpoch();
         QFile file(path);
         file.open(QFile::ReadOnly);
-        inp = QString(file.readAll()).append('\n');
+        QByteArray bytes;
+        qint64 size = file.size();
+        const char* data = reinterpret_cast<const char*>(file.map(0, size));
+        if (!data) {
+            bytes = file.readAll();
+            data = bytes.constData();
+            size = bytes.size();
+        }
+        // the cache is keyed by the bytes parsed
+        mSourceSize = size;
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        hash.addData(data, int(size));
+        mSourceHash = hash.result();
+        WF::ObjReader reader;
+        bool done = mReader && reader.read(data, size);
+        if (done) {
+            // at most one vertex and about one edge per face corner
+            mVertexCache.reserve(reader.triplets.size());
+            mEdgeCache.reserve(reader.triplets.size());
+        }
+        if (!done) {
+            // outside the subset of the reader: the grammar decides
+            inp = QString(QByteArray(data, size)).append('\n');
+        }
         file.close();
+
+        if (done) {
+            mVertices = reader.vertices;
+            mNormals = reader.normals;
+            mTexCoords = reader.texes;
+            const WF::TripletIndex* ts = reader.triplets.constData();
+            for (const WF::ObjReader::Face& f: qAsConst(reader.faces)) {
+                appendFace(ts + f.begin, f.size, f.vertices, f.normals, f.texes);
+            }
+            inp.clear();
+        }
     }
 
-    wavefront_lex_init(&mScanner);
-    wavefront__scan_string(inp.toUtf8().data(), mScanner);
-    int err = wavefront_parse(this, mScanner);
-    wavefront_lex_destroy(mScanner);
+    if (!inp.isEmpty()) {
+        wavefront_lex_init(&mScanner);
+        wavefront__scan_string(inp.toUtf8().data(), mScanner);
+        int err = wavefront_parse(this, mScanner);
+        wavefront_lex_destroy(mScanner);
 
-    if (err) throw WF::ModelError(mError);
+        if (err) throw WF::ModelError(mError);
+    }
 
     // gen missing tex coords
     if (!mGenTexes.isEmpty()) {
@@ -374,8 +622,18 @@ void ModelStore::parseModelData(const QString& path) {
         Vector4Vector normalSum(mVertexData.size(), Vector4());
         IndexVector faceCount(mVertexData.size(), 0);
         int numFaces = mTriangleIndices.size() / 3; // they are triangles
+        // face normals: edge vectors, then batched cross products
+        Vector4Vector faceNormals(numFaces);
+        Vector4Vector edges(numFaces);
+        for (int face = 0; face < numFaces; ++face) {
+            const Vector4& v0 = mVertexData[mTriangleIndices[3*face+0]].vertex;
+            faceNormals[face] = mVertexData[mTriangleIndices[3*face+1]].vertex - v0;
+            edges[face] = mVertexData[mTriangleIndices[3*face+2]].vertex - v0;
+        }
+        Math3D::Batch::cross(faceNormals.constData(), edges.constData(), faceNormals.data(), numFaces, true);
+        Math3D::Batch::normalize(faceNormals.data(), numFaces, true);
         for (int face = 0; face < numFaces; ++face) {
-            Vector4 n = makeNormal(3*face);
+            const Vector4& n = faceNormals[face];
             for (int p = 0; p < 3; ++p) {
                 normalSum[mTriangleIndices[3*face+p]] += n;
                 faceCount[mTriangleIndices[3*face+p]] += 1;
@@ -389,41 +647,130 @@ void ModelStore::parseModelData(const QString& path) {
     }
 }
 
-Vector4 ModelStore::makeNormal(int start) const {
-    Vector4 v0 = mVertexData[mTriangleIndices[start+0]].vertex;
-    Vector4 v1 = mVertexData[mTriangleIndices[start+1]].vertex;
-    Vector4 v2 = mVertexData[mTriangleIndices[start+2]].vertex;
-    return Math3D::cross(v1 - v0, v2 - v0).normalized3();
-}
-
 
-void ModelStore::setItem(const QString& key, const QString& path) {
+bool ModelStore::Loader::load(const QString& path, Model& model) {
+    bool parsed = true;
     try {
         parseModelData(path);
     } catch (WF::ModelError& e) {
         qWarning() << e.msg() << e.row() << e.col();
         // parse error - add default object
         parseModelData("");
+        parsed = false;
     }
 
-    AC::TriangleOptimizer stripper(mTriangleIndices);
-    // qCDebug(OGL) << stripper.strips().size();
-
-    Model model;
-    model.name = key;
-    model.fileName = path;
     model.vertices = mVertexData;
-    model.strips = stripper.strips();
     model.wireFrame = mWireframeIndices;
+    model.sourceSize = mSourceSize;
+    model.sourceTime = mSourceTime;
+    model.sourceHash = mSourceHash;
 
+    StripVector patchStrips;
     if (!mPatchState.vertices.isEmpty()) {
         mPatchState.applyOffset(model.vertices.size());
         model.vertices.append(mPatchState.vertices);
-        model.strips.append(mPatchState.strips);
         model.wireFrame.append(mPatchState.wireframe);
+        patchStrips = mPatchState.strips;
     }
 
-    resetParser();
+    if (model.layout == Triangles) {
+        IndexVector triangles = mTriangleIndices;
+        for (const Strip& strip: qAsConst(patchStrips)) {
+            // to the winding of the faces, see optimizeTriangles
+            IndexVector reversed;
+            Mesh::appendStrip(reversed, strip);
+            for (int i = 0; i < reversed.size(); i += 3) {
+                triangles << reversed[i] << reversed[i + 2] << reversed[i + 1];
+            }
+        }
+        optimizeTriangles(model, triangles);
+        makeLods(model, model.triangles);
+    } else {
+        AC::TriangleOptimizer stripper(mTriangleIndices);
+        // qCDebug(OGL) << stripper.strips().size();
+        StripVector strips = stripper.strips();
+        strips.append(patchStrips);
+        IndexVector triangles;
+        for (const Strip& strip: qAsConst(strips)) {
+            if (!model.strips.isEmpty()) model.strips.append(RestartIndex);
+            model.strips.append(strip);
+            Mesh::appendStrip(triangles, strip);
+        }
+        makeLods(model, triangles);
+    }
+
+    reset();
+
+    model.setBounds();
+    return parsed;
+}
+
+// Vertex cache, overdraw and fetch order of the model triangles. The
+// triangles are stored with the winding of the strips.
+void ModelStore::Loader::optimizeTriangles(Model& model, IndexVector triangles) {
+    int count = model.vertices.size();
+    Mesh::Vector4Vector positions(count);
+    for (int i = 0; i < count; i++) {
+        positions[i] = model.vertices[i].vertex;
+    }
+    triangles = Mesh::optimizeVertexCache(triangles, count);
+    triangles = Mesh::optimizeOverdraw(triangles, positions);
+    IndexVector remap = Mesh::optimizeVertexFetch(triangles, count);
+
+    VertexDataVector vertices(count);
+    for (int i = 0; i < count; i++) {
+        vertices[remap[i]] = model.vertices[i];
+    }
+    model.vertices = vertices;
+    for (uint& idx: model.wireFrame) {
+        idx = remap[idx];
+    }
+    for (int i = 0; i < triangles.size(); i += 3) {
+        std::swap(triangles[i + 1], triangles[i + 2]);
+    }
+    model.triangles = triangles;
+}
+
+// Each level about halves the triangles of the previous one, until the
+// levels get small or stop shrinking, e.g. at locked borders. The errors
+// of the collapses add up. Triangles and levels have the strip winding.
+void ModelStore::Loader::makeLods(Model& model, const IndexVector& triangles) {
+    const int maxLods = 8;
+    const int minTriangles = 256;
+    int count = model.vertices.size();
+    Mesh::Vector4Vector positions(count);
+    for (int i = 0; i < count; i++) {
+        positions[i] = model.vertices[i].vertex;
+    }
+    model.lods.clear();
+    IndexVector current = triangles;
+    float distance = 0;
+    while (model.lods.size() < maxLods && current.size() / 3 >= 2 * minTriangles) {
+        float e;
+        IndexVector next = Mesh::simplify(current, positions, current.size() / 6, e);
+        if (4 * next.size() > 3 * current.size()) break;
+        distance += e;
+        Lod lod;
+        lod.triangles = Mesh::optimizeVertexCache(next, count);
+        lod.planeDistance = distance;
+        model.lods.append(lod);
+        current = next;
+    }
+}
+
+// called from worker threads: only reads the store
+ModelStore::Model ModelStore::loadModel(const QString& path, Layout layout) const {
+    Model model;
+    model.layout = layout;
+    if (readCache(path, model)) return model;
+    Loader loader;
+    if (loader.load(path, model)) writeCache(path, model);
+    return model;
+}
+
+void ModelStore::insertModel(const QString& key, const QString& path, Model model) {
+    model.name = key;
+    model.fileName = path;
 
     if (mIndexMap.contains(key)) {
         mModels[mIndexMap[key]] = model;
@@ -431,12 +778,304 @@ void ModelStore::setItem(const QString& key, const QString& path) {
         mIndexMap[key] = mModels.size();
         mModels.append(model);
     }
+}
+
+void ModelStore::setItem(const QString& key, const QString& path) {
+    Model model = loadModel(path, layout(key));
+    mMoved = false;
+    mRescaled = false;
+    if (!mIndexMap.contains(key)) {
+        insertModel(key, path, model);
+        placeModel(mIndexMap[key]);
+        return;
+    }
+    Model old = mModels[mIndexMap[key]];
+    insertModel(key, path, model);
+    replaceModel(mIndexMap[key], old);
+}
+
+void ModelStore::setLayout(const QString& key, Layout layout) {
+    if (this->layout(key) == layout) return;
+    mLayouts[key] = layout;
+    if (mIndexMap.contains(key)) {
+        setItem(key, mModels[mIndexMap[key]].fileName);
+    }
+}
 
+ModelStore::Layout ModelStore::layout(const QString& key) const {
+    return mLayouts.value(key, Strips);
+}
+
+void ModelStore::setItems(const QMap<QString, QString>& items) {
+    QStringList keys = items.keys();
+    int total = keys.size();
+    QVector<QFuture<Model>> loads;
+    QSemaphore finished;
+    for (auto& key: keys) {
+        QString path = items[key];
+        Layout layout = this->layout(key);
+        loads.append(QtConcurrent::run([this, path, layout, &finished] () {
+            Model model = loadModel(path, layout);
+            finished.release();
+            return model;
+        }));
+    }
+    // progress as the loads finish, in any order
+    emit loadProgress(0, total);
+    for (int done = 1; done <= total; done++) {
+        finished.acquire();
+        emit loadProgress(done, total);
+    }
+    for (int k = 0; k < total; k++) {
+        insertModel(keys[k], items[keys[k]], loads[k].result());
+    }
     makeModelBuffer();
+}
+
+void ModelStore::Model::setBounds() {
+    if (vertices.isEmpty()) {
+        lo = hi = Vector4(0, 0, 0);
+        return;
+    }
+    lo = hi = vertices.first().vertex;
+    for (const VertexData& d: qAsConst(vertices)) {
+        for (int i = 0; i < 3; i++) {
+            lo(i) = std::min(lo[i], d.vertex[i]);
+            hi(i) = std::max(hi[i], d.vertex[i]);
+        }
+    }
+    lo(3) = hi(3) = 1;
+}
 
+// positions, normals, tex coords: the vertex block of makeModelBuffer.
+// Each block has room for capacity vertices.
+void ModelStore::packVertices(const VertexDataVector& vertices, char* p, int capacity) {
+    unsigned int nsize = 3 * sizeof(GLfloat);
+    unsigned int tsize = 2 * sizeof(GLfloat);
+    char* q = p;
+    for (auto& d: vertices) {
+        ::memcpy(q, d.vertex.readArray(), nsize); q += nsize;
+    }
+    q = p + capacity * nsize;
+    for (auto& d: vertices) {
+        ::memcpy(q, d.normal.readArray(), nsize); q += nsize;
+    }
+    q = p + 2 * capacity * nsize;
+    for (auto& d: vertices) {
+        ::memcpy(q, d.tex.readArray(), tsize); q += tsize;
+    }
 }
 
-void ModelStore::resetParser() {
+// signed normalized components, w = 0
+static quint32 packNormal(const Vector4& n) {
+    quint32 bits = 0;
+    for (int i = 0; i < 3; i++) {
+        float c = std::max(-1.f, std::min(1.f, n[i]));
+        bits |= (quint32(std::lround(c * 511)) & 0x3ff) << (10 * i);
+    }
+    return bits;
+}
+
+// the vertex block of the interleaved formats
+void ModelStore::packInterleaved(const Model& model, Format format, char* p) {
+    Vector4 extent = model.hi - model.lo;
+    for (auto& d: model.vertices) {
+        if (format == Quantized) {
+            GLushort pos[4] = {0, 0, 0, 0};
+            for (int i = 0; i < 3; i++) {
+                float t = extent[i] > 0 ? (d.vertex[i] - model.lo[i]) / extent[i] : 0;
+                pos[i] = std::lround(std::max(0.f, std::min(1.f, t)) * 0xffff);
+            }
+            ::memcpy(p, pos, sizeof(pos)); p += sizeof(pos);
+        } else {
+            ::memcpy(p, d.vertex.readArray(), 3 * sizeof(GLfloat)); p += 3 * sizeof(GLfloat);
+        }
+        quint32 normal = packNormal(d.normal);
+        ::memcpy(p, &normal, sizeof(normal)); p += sizeof(normal);
+        qfloat16 tex[2] = {qfloat16(d.tex[0]), qfloat16(d.tex[1])};
+        ::memcpy(p, tex, sizeof(tex)); p += sizeof(tex);
+    }
+}
+
+namespace {
+
+const char CacheMagic[4] = {'O', 'G', 'D', 'M'};
+const quint32 CacheVersion = 5;
+
+// Followed by the source path padded to 4 bytes, the vertex block,
+// restart separated strip indices, triangle indices, wireframe indices,
+// the (index count, error) pairs of the levels of detail and their
+// indices. Native byte order.
+class CacheHeader {
+public:
+    char magic[4];
+    quint32 version;
+    qint64 size;
+    qint64 mtime;
+    char hash[16];
+    quint32 pathSize;
+    quint32 vertices;
+    quint32 strips;
+    quint32 layout;
+    quint32 triangles;
+    quint32 wireframe;
+    quint32 lods;
+    quint32 lodIndices;
+    float lo[3];
+    float hi[3];
+};
+
+class LodEntry {
+public:
+    quint32 count;
+    float planeDistance;
+};
+
+QByteArray contentHash(QFile& file) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    qint64 size = file.size();
+    uchar* data = size > 0 ? file.map(0, size) : nullptr;
+    if (data) {
+        hash.addData(reinterpret_cast<const char*>(data), size);
+        file.unmap(data);
+    } else {
+        hash.addData(&file);
+    }
+    return hash.result();
+}
+
+}
+
+void ModelStore::setCacheDir(const QString& dir) {
+    mCacheDir = dir;
+}
+
+QString ModelStore::cachePath(const QString& path, Layout layout) const {
+    QByteArray name = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    if (layout == Triangles) name += ".triangles";
+    return QDir(mCacheDir).filePath(QString::fromLatin1(name) + ".model");
+}
+
+bool ModelStore::readCache(const QString& path, Model& model) const {
+    if (mCacheDir.isEmpty() || path.isEmpty()) return false;
+
+    QFile file(cachePath(path, model.layout));
+    if (!file.open(QFile::ReadOnly)) return false;
+    qint64 size = file.size();
+    if (size < qint64(sizeof(CacheHeader))) return false;
+    const char* data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) return false;
+
+    CacheHeader h;
+    ::memcpy(&h, data, sizeof(h));
+    QFileInfo info(path);
+    if (::memcmp(h.magic, CacheMagic, 4) != 0 || h.version != CacheVersion) return false;
+    if (h.layout != quint32(model.layout)) return false;
+    if (h.size != info.size() || h.mtime != info.lastModified().toMSecsSinceEpoch()) return false;
+    qint64 pathBytes = (qint64(h.pathSize) + 3) & ~qint64(3);
+    qint64 expected = sizeof(h) + pathBytes + sizeof(GLfloat) * 8 * qint64(h.vertices)
+            + sizeof(GLuint) * (qint64(h.strips) + h.triangles + h.wireframe + h.lodIndices)
+            + sizeof(LodEntry) * qint64(h.lods);
+    if (expected != size) return false;
+    const char* p = data + sizeof(h);
+    if (QString::fromUtf8(p, h.pathSize) != path) return false;
+
+    QFile source(path);
+    if (!source.open(QFile::ReadOnly)) return false;
+    if (contentHash(source) != QByteArray(h.hash, 16)) return false;
+    p += pathBytes;
+
+    // the mapped arrays are aligned: the header and path are
+    const GLfloat* f = reinterpret_cast<const GLfloat*>(p);
+    uint n = h.vertices;
+    const LodEntry* l = reinterpret_cast<const LodEntry*>(f + 8 * n + h.strips + h.triangles + h.wireframe);
+    quint64 lodIndices = 0;
+    for (uint i = 0; i < h.lods; i++) lodIndices += l[i].count;
+    if (lodIndices != h.lodIndices) return false;
+
+    // only the uploaded components are stored
+    model.vertices.resize(n);
+    for (uint i = 0; i < n; i++) {
+        VertexData& d = model.vertices[i];
+        d.vertex = Vector4(f[3 * i], f[3 * i + 1], f[3 * i + 2]);
+        d.normal = Vector4(f[3 * n + 3 * i], f[3 * n + 3 * i + 1], f[3 * n + 3 * i + 2], 0);
+        d.tex = Vector4(f[6 * n + 2 * i], f[6 * n + 2 * i + 1], 0, 0);
+    }
+    const GLuint* q = reinterpret_cast<const GLuint*>(f + 8 * n);
+    model.strips.resize(h.strips);
+    ::memcpy(model.strips.data(), q, h.strips * sizeof(GLuint));
+    q += h.strips;
+    model.triangles.resize(h.triangles);
+    ::memcpy(model.triangles.data(), q, h.triangles * sizeof(GLuint));
+    q += h.triangles;
+    model.wireFrame.resize(h.wireframe);
+    ::memcpy(model.wireFrame.data(), q, h.wireframe * sizeof(GLuint));
+    q += h.wireframe;
+    q += h.lods * sizeof(LodEntry) / sizeof(GLuint);
+    model.lods.resize(h.lods);
+    for (uint i = 0; i < h.lods; i++) {
+        model.lods[i].planeDistance = l[i].planeDistance;
+        model.lods[i].triangles.resize(l[i].count);
+        ::memcpy(model.lods[i].triangles.data(), q, l[i].count * sizeof(GLuint));
+        q += l[i].count;
+    }
+    model.lo = Vector4(h.lo[0], h.lo[1], h.lo[2]);
+    model.hi = Vector4(h.hi[0], h.hi[1], h.hi[2]);
+    return true;
+}
+
+void ModelStore::writeCache(const QString& path, const Model& model) const {
+    if (mCacheDir.isEmpty() || path.isEmpty()) return;
+    if (model.sourceHash.size() != 16) return;
+
+    CacheHeader h;
+    ::memset(&h, 0, sizeof(h));
+    ::memcpy(h.magic, CacheMagic, 4);
+    h.version = CacheVersion;
+    h.size = model.sourceSize;
+    h.mtime = model.sourceTime;
+    ::memcpy(h.hash, model.sourceHash.constData(), 16);
+    QByteArray name = path.toUtf8();
+    h.pathSize = name.size();
+    h.vertices = model.vertices.size();
+    h.strips = model.strips.size();
+    h.layout = model.layout;
+    h.triangles = model.triangles.size();
+    h.wireframe = model.wireFrame.size();
+    h.lods = model.lods.size();
+    QVector<LodEntry> lods;
+    for (const Lod& lod: model.lods) {
+        h.lodIndices += lod.triangles.size();
+        lods.append({quint32(lod.triangles.size()), lod.planeDistance});
+    }
+    for (int i = 0; i < 3; i++) {
+        h.lo[i] = model.lo[i];
+        h.hi[i] = model.hi[i];
+    }
+
+    QByteArray vertices(8 * sizeof(GLfloat) * model.vertices.size(), 0);
+    packVertices(model.vertices, vertices.data(), model.vertices.size());
+
+    if (!QDir().mkpath(mCacheDir)) return;
+    QSaveFile file(cachePath(path, model.layout));
+    if (!file.open(QFile::WriteOnly)) return;
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    name.append(QByteArray((4 - name.size() % 4) % 4, 0));
+    file.write(name);
+    file.write(vertices);
+    file.write(reinterpret_cast<const char*>(model.strips.constData()), model.strips.size() * sizeof(GLuint));
+    file.write(reinterpret_cast<const char*>(model.triangles.constData()), model.triangles.size() * sizeof(GLuint));
+    file.write(reinterpret_cast<const char*>(model.wireFrame.constData()), model.wireFrame.size() * sizeof(GLuint));
+    file.write(reinterpret_cast<const char*>(lods.constData()), lods.size() * sizeof(LodEntry));
+    for (const Lod& lod: model.lods) {
+        file.write(reinterpret_cast<const char*>(lod.triangles.constData()), lod.triangles.size() * sizeof(GLuint));
+    }
+    if (!file.commit()) {
+        qWarning() << "Cannot write model cache" << file.fileName();
+    }
+}
+
+void ModelStore::Loader::reset() {
     mVertexData.clear();
     mTriangleIndices.clear();
     mWireframeIndices.clear();
@@ -456,17 +1095,23 @@ void ModelStore::resetParser() {
 void ModelStore::clean() {
     mModels.clear();
     mIndexMap.clear();
-    mSpecs.clear();
-
-    delete mData[GL_ARRAY_BUFFER].data;
+    mLayouts.clear();
+    mFormats.clear();
+    clearSpecs();
+    forgetUploads();
+    mVertexHeap.reset(0);
+    mElementHeap.reset(0);
+    mMoved = true;
+
+    delete [] mData[GL_ARRAY_BUFFER].data;
     mData[GL_ARRAY_BUFFER] = Data();
 
-    delete mData[GL_ELEMENT_ARRAY_BUFFER].data;
+    delete [] mData[GL_ELEMENT_ARRAY_BUFFER].data;
     mData[GL_ELEMENT_ARRAY_BUFFER] = Data();
 
 }
 
-void ModelStore::createError(const QString &msg, Error err) {
+void ModelStore::Loader::createError(const QString &msg, Error err) {
     QString detail;
     switch (err) {
     case InSurfDef:
@@ -485,7 +1130,7 @@ void ModelStore::createError(const QString &msg, Error err) {
     mError = WF::ModelError(detail.arg(msg), loc->row, loc->col, loc->pos);
 }
 
-void wavefront_error(Demo::WF::LocationType*, Demo::GL::ModelStore* models, yyscan_t, const char* msg) {
+void wavefront_error(Demo::WF::LocationType*, Demo::GL::ModelStore::Loader* models, yyscan_t, const char* msg) {
     models->createError(msg, Demo::GL::ModelStore::Error::Unused);
 }
 
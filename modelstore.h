@@ -10,6 +10,8 @@
 #include "math3d.h"
 #include "patcher.h"
 #include "projectfolder.h"
+#include "indextable.h"
+#include "bufferheap.h"
 
 #define WAVEFRONT_LTYPE Demo::WF::LocationType
 #define WAVEFRONT_STYPE Demo::WF::ValueType
@@ -125,29 +127,57 @@ public:
 
     void clean();
 
-    // grammar interface
-    void appendVertex(float x, float y, float z, float w = 1);
-    void appendNormal(float, float, float);
-    void appendTex(float, float);
-    void appendFace(const WF::TripletIndexVector&);
-    bool inPatchDef() const;
-    void setPatchType(const QString& name, bool rat = false);
-    void setPatchKnots(const QString& v, const WF::NumericVector& knots);
-    void setPatchRank(int udeg, int vdeg);
-    bool checkPatchState() const;
-    void beginPatch(float u0, float u1, float v0, float v1, const WF::IndexVector& controlpoints);
-    void endPatch();
+    // Loads the models in parallel, then builds the model buffer once.
+    // loadProgress reports each load as it finishes.
+    void setItems(const QMap<QString, QString>& items);
 
     enum Error {InSurfDef, StateNotComplete, SurfDefRequired, Unused};
-    void createError(const QString& item, Error err);
 
-    void parseModelData(const QString& path);
+    // Index layout of a model: triangle strips, or a triangle list
+    // optimized for the vertex cache, overdraw and vertex fetch. Changing
+    // the layout of a loaded model reloads it.
+    enum Layout {Strips, Triangles};
+    void setLayout(const QString& key, Layout layout);
+    Layout layout(const QString& key) const;
+
+    // Vertex format of a model in the model buffer: separate blocks of
+    // float positions, normals and tex coords, or interleaved float
+    // positions, 10_10_10_2 normals and half float tex coords. Quantized
+    // positions are 16 bit fractions of the bounding box, see
+    // dequantization. The interleaved formats use 16 bit indices when
+    // the model has less than 65536 vertices.
+    enum Format {Planar, Interleaved, Quantized};
+    void setFormat(const QString& key, Format format);
+    Format format(const QString& key) const;
+    // bytes per vertex in the model buffer
+    static int vertexSize(Format format);
+
+    class Loader;
+
+    // True if the last change moved the attribute data of a model that
+    // was there before. Otherwise the changed ranges were written to the
+    // uploaded buffers, and attribute pointers set up earlier are valid.
+    bool moved() const {return mMoved;}
+    // True if the last change altered the dequantization matrix of a
+    // model that was there before
+    bool rescaled() const {return mRescaled;}
+
+    // binary cache of the loaded models, none if dir is empty
+    void setCacheDir(const QString& dir);
 
     // blob interface implementation
-    void draw(unsigned int mode, const QString& attr) const override;
+    int drawKey(const QString& name) const override;
+    void draw(unsigned int mode, int key) const override;
+    Math3D::Matrix4 dequantization(int key) const override;
+    int lod(int key, const Math3D::Matrix4& clip, float width, float height, float pixels) const override;
+    void drawLod(unsigned int mode, int key, int lod) const override;
     // drawing context
     void setContext(GLWidget* context);
 
+signals:
+
+    // done out of total models loaded
+    void loadProgress(int done, int total);
 
 private:
 
@@ -177,8 +207,8 @@ private:
     using VertexDataVector = QVector<Demo::GL::ModelStore::VertexData>;
     using Vector4Vector = QVector<Math3D::Vector4>;
     using IndexVector = QVector<GLuint>;
-    using OffsetVector = QVector<uintptr_t>;
-    using IndexHash = QHash<QString, GLuint>;
+    using VertexCache = IndexTable<VertexKey>;
+    using EdgeCache = IndexTable<EdgeKey>;
     using Strip = QVector<GLuint>;
     using StripVector = QVector<Strip>;
 
@@ -234,36 +264,130 @@ private:
     };
 
 
+    // simplified triangle list of a model, strip winding
+    class Lod {
+    public:
+        IndexVector triangles;
+        float planeDistance = 0; // summed simplify plane distances, not a bound
+        uint offset = 0;
+    };
+
+    using LodVector = QVector<Demo::GL::ModelStore::Lod>;
+
     class Model {
     public:
         Model() = default;
         QString name;
         QString fileName;
         VertexDataVector vertices;
-        StripVector strips;
-        OffsetVector stripOffsets;
-        QVector<GLsizei> stripSizes;
+        IndexVector strips; // separated by RestartIndex
+        uint stripsOffset;
         IndexVector wireFrame;
         uint wireFrameOffset;
-
+        Layout layout = Strips;
+        IndexVector triangles; // triangle list layout
+        uint trianglesOffset;
+        Vector4 lo, hi; // bounding box
+        LodVector lods; // levels 1, 2, ...
+        GLenum indexType = GL_UNSIGNED_INT;
+        // size, mtime and MD5 of the parsed file
+        qint64 sourceSize = 0;
+        qint64 sourceTime = 0;
+        QByteArray sourceHash;
+        // byte ranges in the model buffer, the vertex range holds
+        // vertexCapacity vertices
+        uint vertexCapacity = 0;
+        uint vertexOffset = 0;
+        uint vertexBytes = 0;
+        uint elementOffset = 0;
+        uint elementBytes = 0;
+
+        void setBounds();
     };
 
     using ModelVector = QVector<Demo::GL::ModelStore::Model>;
     using IndexMap = QMap<QString, int>;
-
-    Vector4 makeNormal(int start) const;
-    void makeModelBuffer();
-    void resetParser();
-    QString makeKey(const WF::TripletIndex&);
-    QString makeKey(uint v1, uint v2);
+    using LayoutMap = QMap<QString, Layout>;
+    using FormatMap = QMap<QString, Format>;
+
+    // GL_PRIMITIVE_RESTART_FIXED_INDEX of GLuint indices
+    static const GLuint RestartIndex = ~0u;
+
+    void makeModelBuffer(bool grow = false);
+    void placeModel(int index, uint vertexHint = BufferHeap::Full, uint elementHint = BufferHeap::Full);
+    void replaceModel(int index, const Model& old);
+    void writeModel(Model& model);
+    void upload(unsigned int target, uint offset, uint length) const;
+    bool shortIndices(const Model& model) const;
+    uint vertexBytes(const Model& model) const;
+    uint elementBytes(const Model& model) const;
+    Model loadModel(const QString& path, Layout layout) const;
+    void insertModel(const QString& key, const QString& path, Model model);
+    static void packVertices(const VertexDataVector& vertices, char* p, int capacity);
+    static void packInterleaved(const Model& model, Format format, char* p);
+    QString cachePath(const QString& path, Layout layout) const;
+    bool readCache(const QString& path, Model& model) const;
+    void writeCache(const QString& path, const Model& model) const;
 
 
 private:
 
     GLWidget* mContext;
+    QString mCacheDir;
 
     ModelVector mModels;
     IndexMap mIndexMap;
+    LayoutMap mLayouts;
+    FormatMap mFormats;
+    BufferHeap mVertexHeap;
+    BufferHeap mElementHeap;
+    bool mMoved = false;
+    bool mRescaled = false;
+};
+
+// Parses a model file. All parser state is in the loader, so that separate
+// loaders can run in parallel.
+class ModelStore::Loader {
+
+public:
+
+    Loader();
+
+    // grammar interface
+    void appendVertex(float x, float y, float z, float w = 1);
+    void appendNormal(float, float, float);
+    void appendTex(float, float);
+    void appendFace(const WF::TripletIndexVector&);
+    void appendFace(const WF::TripletIndex* ts, int size, uint Lv, uint Ln, uint Lt);
+    bool inPatchDef() const;
+    void setPatchType(const QString& name, bool rat = false);
+    void setPatchKnots(const QString& v, const WF::NumericVector& knots);
+    void setPatchRank(int udeg, int vdeg);
+    bool checkPatchState() const;
+    void beginPatch(float u0, float u1, float v0, float v1, const WF::IndexVector& controlpoints);
+    void endPatch();
+    void createError(const QString& item, Error err);
+
+    void parseModelData(const QString& path);
+    // The hand written reader is tried first unless off; then the
+    // grammar parses all input. For comparing the two.
+    void setReader(bool on) {mReader = on;}
+    // parsed data
+    const VertexDataVector& vertexData() const {return mVertexData;}
+    const IndexVector& triangles() const {return mTriangleIndices;}
+    const IndexVector& wireframe() const {return mWireframeIndices;}
+    // Stripified model of the file with its levels of detail, or the
+    // default object on parse errors. Returns false on errors.
+    bool load(const QString& path, Model& model);
+
+private:
+
+    void reset();
+    void optimizeTriangles(Model& model, IndexVector triangles);
+    void makeLods(Model& model, const IndexVector& triangles);
+    VertexKey makeKey(const WF::TripletIndex&, uint Lv, uint Ln, uint Lt);
+
+private:
 
     VertexDataVector mVertexData;
     IndexVector mTriangleIndices; // points to vertexdata -- 3 consecutive points form a triangle
@@ -273,8 +397,8 @@ private:
     Vector4Vector mVertices;
     Vector4Vector mNormals;
     Vector4Vector mTexCoords;
-    IndexHash mVertexCache;
-    IndexHash mEdgeCache;
+    VertexCache mVertexCache;
+    EdgeCache mEdgeCache;
 
 
     IndexVector mGenNormals; // indices of missing normals in vertexdata
@@ -283,6 +407,13 @@ private:
     WF::ModelError mError;
     yyscan_t mScanner;
 
+    bool mReader;
+
+    // the file parsed last
+    qint64 mSourceSize;
+    qint64 mSourceTime;
+    QByteArray mSourceHash;
+
     PatchState mPatchState;
 };
 
@@ -302,7 +433,7 @@ private:
     (Current).prev_pos = YYRHSLOC (Rhs, 0).prev_pos;\
     } while (0)
 
-void wavefront_error(Demo::WF::LocationType*, Demo::GL::ModelStore*, yyscan_t, const char*);
+void wavefront_error(Demo::WF::LocationType*, Demo::GL::ModelStore::Loader*, yyscan_t, const char*);
 
 
 
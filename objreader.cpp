@@ -0,0 +1,330 @@
+#include "objreader.h"
+
+#include <QtConcurrent>
+#include <QByteArray>
+#include <cstring>
+#include <cstdlib>
+
+using namespace Demo::WF;
+using Math3D::Vector4;
+
+namespace {
+
+// smaller inputs are not worth the thread hand-off
+const qint64 ChunkSize = 1 << 20;
+
+// exactly representable powers of ten
+const double Pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool isSpace(char c) {return c == ' ' || c == '\t';}
+bool isDigit(char c) {return c >= '0' && c <= '9';}
+
+bool isSigned(const char* p, const char* end) {
+    if (p != end && (*p == '-' || *p == '+')) ++p;
+    if (p == end) return false;
+    for (; p != end; ++p) {
+        if (!isDigit(*p)) return false;
+    }
+    return true;
+}
+
+// {num}: strtol(text, 0, 0) in the scanner. Octal looking and overflowing
+// numbers are left to the scanner.
+bool parseInt(const char* p, const char* end, int& value) {
+    bool neg = *p == '-';
+    if (*p == '-' || *p == '+') ++p;
+    int n = end - p;
+    if (n > 9 || (n > 1 && *p == '0')) return false;
+    int v = 0;
+    for (; p != end; ++p) v = 10 * v + (*p - '0');
+    value = neg ? -v : v;
+    return true;
+}
+
+// {float_1}, {float_2}, {float_3}: strtod(text) in the scanner, then
+// converted to float. Clinger's fast path is exact when the significand
+// and the power of ten are exact doubles; strtod takes the rest.
+bool parseFloat(const char* s, const char* end, float& value) {
+    const char* p = s;
+    bool sign = *p == '-' || *p == '+';
+    bool neg = *p == '-';
+    if (sign) ++p;
+
+    quint64 m = 0;
+    int digits = 0;
+    int scale = 0;
+    const char* q = p;
+    for (; p != end && isDigit(*p); ++p) {
+        if (m == 0 && *p == '0') continue;
+        if (++digits <= 19) m = 10 * m + (*p - '0'); else scale++;
+    }
+    bool whole = p != q;
+    bool dot = p != end && *p == '.';
+    bool fraction = false;
+    if (dot) {
+        q = ++p;
+        for (; p != end && isDigit(*p); ++p) {
+            if (m == 0 && *p == '0') {scale--; continue;}
+            if (++digits <= 19) {m = 10 * m + (*p - '0'); scale--;}
+        }
+        fraction = p != q;
+    }
+    bool exponent = p != end && (*p == 'e' || *p == 'E');
+    int e = 0;
+    if (exponent) {
+        ++p;
+        bool eneg = p != end && *p == '-';
+        if (p != end && (*p == '-' || *p == '+')) ++p;
+        if (p == end) return false;
+        for (; p != end && isDigit(*p); ++p) {
+            if (e < 100000) e = 10 * e + (*p - '0');
+        }
+        if (eneg) e = -e;
+    }
+    if (p != end) return false;
+
+    // float_1: num.unum?exp?  float_2: .unum exp?  float_3: num exp
+    if (whole && !dot && !exponent) return false;
+    if (!whole && (!dot || !fraction || sign)) return false;
+
+    e += scale;
+    double d;
+    if (digits <= 19 && m <= (quint64(1) << 53) && e >= -22 && e <= 22) {
+        d = double(m);
+        d = e < 0 ? d / Pow10[-e] : d * Pow10[e];
+        if (neg) d = -d;
+    } else {
+        QByteArray text(s, end - s);
+        d = std::strtod(text.constData(), nullptr);
+    }
+    value = d;
+    return true;
+}
+
+bool parseNumeric(const char* p, const char* end, float& value) {
+    if (isSigned(p, end)) {
+        int v;
+        if (!parseInt(p, end, v)) return false;
+        value = v;
+        return true;
+    }
+    return parseFloat(p, end, value);
+}
+
+// {unum} of a vertex triplet: strtof in the scanner, assigned to int
+bool parseIndex(const char*& p, const char* end, int& value) {
+    const char* q = p;
+    quint64 n = 0;
+    for (; p != end && isDigit(*p); ++p) {
+        if (p - q >= 10) return false;
+        n = 10 * n + (*p - '0');
+    }
+    if (p == q || n > 2000000000) return false;
+    value = static_cast<int>(static_cast<float>(n));
+    return true;
+}
+
+enum Kind {Ints, Vert, VertTex, VertNorm, VertTexNorm};
+
+bool parseTriplet(const char* p, const char* end, TripletIndex& t, Kind& kind) {
+    if (isSigned(p, end)) {
+        kind = Ints;
+        t = TripletIndex();
+        return parseInt(p, end, t.v_index);
+    }
+    int v = 0;
+    int vt = 0;
+    int vn = 0;
+    if (!parseIndex(p, end, v) || p == end || *p++ != '/') return false;
+    if (p != end && *p == '/') {
+        ++p;
+        if (p == end) {
+            kind = Vert;
+        } else {
+            if (!parseIndex(p, end, vn)) return false;
+            kind = VertNorm;
+        }
+    } else {
+        if (!parseIndex(p, end, vt) || p == end || *p++ != '/') return false;
+        if (p == end) {
+            kind = VertTex;
+        } else {
+            if (!parseIndex(p, end, vn)) return false;
+            kind = VertTexNorm;
+        }
+    }
+    if (p != end) return false;
+    t = TripletIndex(v, vt, vn);
+    return true;
+}
+
+bool isUnsupported(const char* p, const char* end) {
+    static const char* keywords[] = {
+        "vp", "bmat", "step", "p", "l", "curv", "curv2", "trom", "hole", "scrv", "sp",
+        "con", "g", "s", "mg", "o", "bevel", "c_interp", "d_interp", "lod", "usemtl",
+        "mtllib", "shadow_obj", "trace_obj", "ctech", "stech", "call", "csh", nullptr
+    };
+    size_t len = end - p;
+    for (int i = 0; keywords[i]; i++) {
+        if (std::strlen(keywords[i]) == len && std::strncmp(keywords[i], p, len) == 0) return true;
+    }
+    return false;
+}
+
+bool is(const char* p, const char* end, const char* keyword) {
+    size_t len = end - p;
+    return std::strlen(keyword) == len && std::strncmp(keyword, p, len) == 0;
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p != end && isSpace(*p)) ++p;
+    return p;
+}
+
+const char* tokenEnd(const char* p, const char* end) {
+    while (p != end && !isSpace(*p)) ++p;
+    return p;
+}
+
+}
+
+bool ObjReader::readChunk(const char* begin, const char* end) {
+    const char* line = begin;
+    while (line < end) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!eol) eol = end;
+
+        const char* p = skipSpace(line, eol);
+        line = eol + 1;
+        // empty and comment lines
+        if (p == eol || *p == '#') continue;
+
+        const char* k = p;
+        p = tokenEnd(p, eol);
+        const char* kend = p;
+
+        // numeric arguments
+        float args[4];
+        int numArgs = 0;
+        auto numerics = [&] () {
+            for (p = skipSpace(p, eol); p != eol; p = skipSpace(p, eol)) {
+                const char* t = p;
+                p = tokenEnd(p, eol);
+                float x;
+                if (!parseNumeric(t, p, x)) return false;
+                if (numArgs < 4) args[numArgs] = x;
+                numArgs++;
+            }
+            return true;
+        };
+
+        if (is(k, kend, "f")) {
+            Face face;
+            face.begin = triplets.size();
+            face.vertices = vertices.size();
+            face.normals = normals.size();
+            face.texes = texes.size();
+            Kind first = Ints;
+            for (p = skipSpace(p, eol); p != eol; p = skipSpace(p, eol)) {
+                const char* t = p;
+                p = tokenEnd(p, eol);
+                TripletIndex ti;
+                Kind kind;
+                if (!parseTriplet(t, p, ti, kind)) return false;
+                if (triplets.size() == face.begin) first = kind;
+                // the grammar does not mix triplet kinds
+                if (kind != first) return false;
+                triplets.append(ti);
+            }
+            face.size = triplets.size() - face.begin;
+            if (face.size == 0) return false;
+            faces.append(face);
+        } else if (is(k, kend, "v")) {
+            if (!numerics() || numArgs < 3 || numArgs > 4) return false;
+            vertices.append(Vector4(args[0], args[1], args[2], numArgs == 4 ? args[3] : 1));
+        } else if (is(k, kend, "vn")) {
+            if (!numerics() || numArgs != 3) return false;
+            normals.append(Vector4(args[0], args[1], args[2], 0));
+        } else if (is(k, kend, "vt")) {
+            if (!numerics() || numArgs < 1 || numArgs > 3) return false;
+            // only 2D texture coordinates are supported
+            if (numArgs == 2) texes.append(Vector4(args[0], args[1], 0, 0));
+        } else if (isUnsupported(k, kend)) {
+            if (!numerics() || numArgs == 0) return false;
+        } else {
+            return false;
+        }
+        mStatements++;
+    }
+    return true;
+}
+
+bool ObjReader::read(const char* data, qint64 size) {
+    if (size <= 0) return false;
+    // flex reads up to the first null
+    if (std::memchr(data, '\0', size)) return false;
+
+    class Part {
+    public:
+        const char* begin;
+        const char* end;
+        ObjReader reader;
+        bool ok;
+    };
+
+    // split at line boundaries
+    int count = std::max(1, static_cast<int>(std::min<qint64>(QThread::idealThreadCount(), size / ChunkSize)));
+    QVector<Part> parts;
+    const char* end = data + size;
+    const char* p = data;
+    for (int i = 1; i <= count && p < end; i++) {
+        const char* q = i == count ? end : data + size * i / count;
+        if (q < p) q = p;
+        if (q < end) {
+            q = static_cast<const char*>(std::memchr(q, '\n', end - q));
+            q = q ? q + 1 : end;
+        }
+        Part part;
+        part.begin = p;
+        part.end = q;
+        part.ok = false;
+        parts.append(part);
+        p = q;
+    }
+
+    if (parts.size() == 1) {
+        parts[0].ok = parts[0].reader.readChunk(parts[0].begin, parts[0].end);
+    } else {
+        QtConcurrent::blockingMap(parts, [] (Part& part) {
+            part.ok = part.reader.readChunk(part.begin, part.end);
+        });
+    }
+
+    vertices.clear();
+    normals.clear();
+    texes.clear();
+    triplets.clear();
+    faces.clear();
+    mStatements = 0;
+    for (const Part& part: qAsConst(parts)) {
+        if (!part.ok) return false;
+        for (Face face: part.reader.faces) {
+            face.begin += triplets.size();
+            face.vertices += vertices.size();
+            face.normals += normals.size();
+            face.texes += texes.size();
+            faces.append(face);
+        }
+        vertices.append(part.reader.vertices);
+        normals.append(part.reader.normals);
+        texes.append(part.reader.texes);
+        triplets.append(part.reader.triplets);
+        mStatements += part.reader.mStatements;
+    }
+
+    // the grammar requires at least one statement
+    return mStatements > 0;
+}
@@ -0,0 +1,48 @@
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include "modelstore.h"
+
+namespace Demo {namespace WF {
+
+// Hand written reader for the common subset of Wavefront OBJ: v, vn, vt and
+// f statements, comments, and unsupported statements with numeric arguments.
+// The input is split at line boundaries and the chunks are parsed in
+// parallel. Anything outside the subset, or anything the flex scanner would
+// tokenize differently, makes read() return false; the caller then runs
+// the flex/bison parser so that results and error messages stay the same.
+class ObjReader {
+
+public:
+
+    class Face {
+    public:
+        int begin; // into triplets
+        int size;
+        // number of v, vn and vt statements before the face
+        int vertices;
+        int normals;
+        int texes;
+    };
+
+    using Vector4Vector = QVector<Math3D::Vector4>;
+    using FaceVector = QVector<Face>;
+
+    bool read(const char* data, qint64 size);
+
+    Vector4Vector vertices;
+    Vector4Vector normals;
+    Vector4Vector texes;
+    TripletIndexVector triplets;
+    FaceVector faces;
+
+private:
+
+    bool readChunk(const char* begin, const char* end);
+
+    int mStatements = 0;
+};
+
+}} // namespace Demo::WF
+
+#endif // OBJREADER_H
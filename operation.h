@@ -18,6 +18,7 @@ using Real_T = BaseType<Math3D::Real>;
 using Integer_T = BaseType<Math3D::Integer>;
 using Vector_T = BaseType<Math3D::Vector4>;
 using Matrix_T = BaseType<Math3D::Matrix4>;
+using Quaternion_T = BaseType<Math3D::Quaternion>;
 using Text_T = BaseType<QString>;
 
 
@@ -147,6 +148,7 @@ public:
         int lid = left->id();
         int rid = right->id();
         if (lid == Type::Text && rid == Type::Text && name() != "+") throw OpError(INCOMPATIBLE_MSG);
+        if (lid == Type::Quaternion || rid == Type::Quaternion) throw OpError(INCOMPATIBLE_MSG);
         if (lid == rid) return;
         if (lid == Type::Integer && rid == Type::Real) return;
         if (lid == Type::Real && rid == Type::Integer) return;
@@ -174,6 +176,9 @@ public:
         if (lid == Type::Text || rid == Type::Text) throw OpError(INCOMPATIBLE_MSG);
         if (lid == Type::Vector && rid == Type::Vector) throw OpError(INCOMPATIBLE_MSG);
         if (lid == Type::Vector && rid == Type::Matrix) throw OpError(INCOMPATIBLE_MSG);
+        // compose or rotate
+        if (lid == Type::Quaternion && rid != Type::Quaternion && rid != Type::Vector) throw OpError(INCOMPATIBLE_MSG);
+        if (rid == Type::Quaternion && lid != Type::Quaternion) throw OpError(INCOMPATIBLE_MSG);
     }
 
     const Type* type(const Type* left, const Type* right) const override {
@@ -200,6 +205,7 @@ public:
         if (lid == Type::Text || rid == Type::Text) throw OpError(INCOMPATIBLE_MSG);
         if (lid == Type::Vector || rid == Type::Vector) throw OpError(INCOMPATIBLE_MSG);
         if (lid == Type::Matrix || rid == Type::Matrix) throw OpError(INCOMPATIBLE_MSG);
+        if (lid == Type::Quaternion || rid == Type::Quaternion) throw OpError(INCOMPATIBLE_MSG);
     }
 
     const Type* type(const Type* left, const Type* right) const override {
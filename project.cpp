@@ -13,7 +13,9 @@
 #include "logging.h"
 #include <QIcon>
 #include <QRegExp>
+#include <QFile>
 #include <QFileSystemWatcher>
+#include <QTextStream>
 
 
 static QString uniqueName(const QString& key, QStringList names, const QString& k = QString()) {
@@ -51,6 +53,9 @@ static QString uniqueName(const QString& key, QStringList names, const QString&
 }
 
 
+// binary model cache, see ModelStore::setCacheDir
+static const char ModelCacheDir[] = ".modelcache";
+
 using Demo::GL::ImageStore;
 using Demo::GL::ModelStore;
 using Demo::CodeEditor;
@@ -77,6 +82,7 @@ Demo::Project::Project(const QDir& pdir, GLWidget* target, const Scope* globals,
 
     connect(this, SIGNAL(initChanged()), mTarget, SLOT(initChanged()));
     connect(this, SIGNAL(drawChanged()), mTarget, SLOT(drawChanged()));
+    connect(mTarget, SIGNAL(resized()), this, SLOT(resized()));
     connect(mWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(fileChanged(const QString&)));
 
     editors->setItem(INIT_NAME);
@@ -84,13 +90,18 @@ Demo::Project::Project(const QDir& pdir, GLWidget* target, const Scope* globals,
     mInit = editors->editor(INIT_NAME);
     mDraw = editors->editor(DRAW_NAME);
 
+    // only the init script is time-sliced
+    mInit->compiler()->setYieldable(true);
     connect(mTarget, SIGNAL(init()), mInit, SLOT(run()));
+    connect(mTarget, SIGNAL(resume()), mInit, SLOT(resume()));
+    connect(mInit, SIGNAL(suspended()), mTarget, SLOT(initSuspended()));
     connect(mTarget, SIGNAL(draw()), mDraw, SLOT(run()));
 
     auto models = dynamic_cast<ModelStore*>(mTarget->blob(globals->symbols(), "modelstore"));
     auto images = dynamic_cast<ImageStore*>(mTarget->texBlob(globals->symbols(), "imagestore"));
 
     models->clean();
+    models->setCacheDir(mProjectDir.absoluteFilePath(ModelCacheDir));
     images->clean();
 
     auto shaders = new TextFileStore("shaders", editors, this);
@@ -120,6 +131,7 @@ Demo::Project::Project(const QString& path, GLWidget* target, const Scope* globa
 
     connect(this, SIGNAL(initChanged()), mTarget, SLOT(initChanged()));
     connect(this, SIGNAL(drawChanged()), mTarget, SLOT(drawChanged()));
+    connect(mTarget, SIGNAL(resized()), this, SLOT(resized()));
     connect(mWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(fileChanged(const QString&)));
 
 
@@ -135,6 +147,20 @@ Demo::Project::Project(const QString& path, GLWidget* target, const Scope* globa
     }
     project.endGroup();
 
+    project.beginGroup("Layouts");
+    NameMap layoutmap;
+    for (auto& key: project.childKeys()) {
+        layoutmap[key] = project.value(key).toString();
+    }
+    project.endGroup();
+
+    project.beginGroup("Formats");
+    NameMap formatmap;
+    for (auto& key: project.childKeys()) {
+        formatmap[key] = project.value(key).toString();
+    }
+    project.endGroup();
+
     project.beginGroup("Images");
     NameMap imagemap;
     for (auto& key: project.childKeys()) {
@@ -171,13 +197,55 @@ Demo::Project::Project(const QString& path, GLWidget* target, const Scope* globa
     }
     project.endGroup();
 
+    // per script watchdog limits
+    project.beginGroup("Limits");
+    for (auto& key: project.childKeys()) {
+        auto ed = editors->editor(key);
+        bool ok;
+        int limit = project.value(key).toInt(&ok);
+        if (ed && ok && limit > 0) ed->compiler()->setInstructionLimit(limit);
+    }
+    project.endGroup();
+
+    // per script watchdog time limits in milliseconds
+    project.beginGroup("TimeLimits");
+    for (auto& key: project.childKeys()) {
+        auto ed = editors->editor(key);
+        bool ok;
+        int limit = project.value(key).toInt(&ok);
+        if (ed && ok && limit > 0) ed->compiler()->setTimeLimit(limit);
+    }
+    project.endGroup();
+
+    // time slices of the init script in milliseconds
+    project.beginGroup("TimeBudgets");
+    for (auto& key: project.childKeys()) {
+        auto ed = editors->editor(key);
+        bool ok;
+        int budget = project.value(key).toInt(&ok);
+        if (ed && ok && budget > 0) ed->compiler()->setTimeBudget(budget);
+    }
+    project.endGroup();
+
+    // scripts replaying recorded command buffers
+    project.beginGroup("Replay");
+    for (auto& key: project.childKeys()) {
+        auto ed = editors->editor(key);
+        if (ed) ed->compiler()->setReplay(project.value(key).toBool());
+    }
+    project.endGroup();
+
     if (project.status() != QSettings::NoError) throw BadProject(QString(R"(%1 is not a valid project file)").arg(path));
 
     mInit = editors->editor(INIT_NAME);
     if (!mInit) {
         throw BadProject(QString(R"("%1" missing in the Scripts section of "%2")").arg(INIT_NAME, path));
     }
+    // only the init script is time-sliced
+    mInit->compiler()->setYieldable(true);
     connect(mTarget, SIGNAL(init()), mInit, SLOT(run()));
+    connect(mTarget, SIGNAL(resume()), mInit, SLOT(resume()));
+    connect(mInit, SIGNAL(suspended()), mTarget, SLOT(initSuspended()));
 
     mDraw = editors->editor(DRAW_NAME);
     if (!mDraw) {
@@ -188,11 +256,19 @@ Demo::Project::Project(const QString& path, GLWidget* target, const Scope* globa
     // safe to update globals
     auto models = dynamic_cast<ModelStore*>(mTarget->blob(globals->symbols(), "modelstore"));
     models->clean();
-    NameIterator itm(modelmap);
-    while (itm.hasNext()) {
-        itm.next();
-        models->setItem(itm.key(), itm.value());
+    models->setCacheDir(mProjectDir.absoluteFilePath(ModelCacheDir));
+    NameIterator itl(layoutmap);
+    while (itl.hasNext()) {
+        itl.next();
+        if (itl.value() == "triangles") models->setLayout(itl.key(), ModelStore::Triangles);
     }
+    NameIterator itf(formatmap);
+    while (itf.hasNext()) {
+        itf.next();
+        if (itf.value() == "interleaved") models->setFormat(itf.key(), ModelStore::Interleaved);
+        if (itf.value() == "quantized") models->setFormat(itf.key(), ModelStore::Quantized);
+    }
+    models->setItems(modelmap);
 
     auto images = dynamic_cast<ImageStore*>(mTarget->texBlob(globals->symbols(), "imagestore"));
     images->clean();
@@ -263,6 +339,50 @@ void Demo::Project::recompileProject() {
     }
 }
 
+// The model store writes changed models to the uploaded buffers: the
+// scripts run again only when attribute data moved.
+void Demo::Project::modelsChanged() {
+    auto models = dynamic_cast<ModelStore*>(mFolders[ModelItems]);
+    // init scripts have read the old attribute pointers or dequantization
+    if (models->moved() || models->rescaled() || !mTarget->initialized()) {
+        recompileProject();
+        return;
+    }
+    emit drawChanged();
+}
+
+void Demo::Project::resized() {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    QStringList names = scope->dependents({"width", "height", "projection", "inverse_projection"});
+    if (names.contains(mInit->objectName())) {
+        emit initChanged();
+        return;
+    }
+    // re-execute only the size dependent init scripts
+    rerunInit(names);
+}
+
+// Runs the named init scripts again in init order, after deleting the GL
+// resources they and their subscripts created. Scripts dispatched by
+// another one of them run only through it.
+void Demo::Project::rerunInit(const QStringList& names) {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    QStringList runs;
+    QStringList owners;
+    for (auto& name: scope->subscripts(mInit->objectName())) {
+        if (!names.contains(name) || owners.contains(name)) continue;
+        runs << name;
+        for (auto& sub: scope->subscripts(name)) {
+            if (!owners.contains(sub)) owners << sub;
+        }
+    }
+    mTarget->makeCurrent();
+    mTarget->releaseResources(owners);
+    for (auto& name: runs) {
+        scope->editor(name)->run();
+    }
+}
+
 void Demo::Project::saveProject() {
     QSettings project(mProjectDir.absoluteFilePath(mProjectIni), QSettings::IniFormat);
     project.clear();
@@ -285,19 +405,76 @@ void Demo::Project::saveProject() {
         }
         project.endGroup();
     }
+
+    // models drawn as optimized triangle lists
+    auto models = dynamic_cast<ModelStore*>(mFolders[ModelItems]);
+    project.beginGroup("Layouts");
+    for (auto& name: models->items()) {
+        if (models->layout(name) == ModelStore::Triangles) project.setValue(name, "triangles");
+    }
+    project.endGroup();
+
+    // compact vertex formats
+    project.beginGroup("Formats");
+    for (auto& name: models->items()) {
+        if (models->format(name) == ModelStore::Interleaved) project.setValue(name, "interleaved");
+        if (models->format(name) == ModelStore::Quantized) project.setValue(name, "quantized");
+    }
+    project.endGroup();
+
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    project.beginGroup("Limits");
+    for (auto ed: scope->editors()) {
+        int limit = ed->compiler()->instructionLimit();
+        if (limit == GL::Runner::DefaultInstructionLimit) continue;
+        project.setValue(ed->objectName(), limit);
+    }
+    project.endGroup();
+
+    project.beginGroup("TimeLimits");
+    for (auto ed: scope->editors()) {
+        int limit = ed->compiler()->timeLimit();
+        if (limit == GL::Runner::DefaultTimeLimit) continue;
+        project.setValue(ed->objectName(), limit);
+    }
+    project.endGroup();
+
+    project.beginGroup("TimeBudgets");
+    for (auto ed: scope->editors()) {
+        int budget = ed->compiler()->timeBudget();
+        if (budget == GL::Runner::DefaultTimeBudget) continue;
+        project.setValue(ed->objectName(), budget);
+    }
+    project.endGroup();
+
+    project.beginGroup("Replay");
+    for (auto ed: scope->editors()) {
+        if (ed->compiler()->replay()) project.setValue(ed->objectName(), true);
+    }
+    project.endGroup();
 }
 
 void Demo::Project::setProjectFile(const QString& fname) {
     QFileInfo info(fname);
     mProjectIni = info.fileName();
     mProjectDir = info.absoluteDir();
+    auto models = dynamic_cast<ModelStore*>(mFolders.value(ModelItems));
+    if (models) models->setCacheDir(mProjectDir.absoluteFilePath(ModelCacheDir));
     // qCDebug(OGL) << "setProjectFile" << mProjectDir.absolutePath() << mProjectIni;
 }
 
 void Demo::Project::scriptCompiled() {
     auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
-    if (scope->subscriptRelation(mInit->objectName(), sender()->objectName())) {
-        emit initChanged();
+    QString name = sender()->objectName();
+    if (scope->subscriptRelation(mInit->objectName(), name)) {
+        if (name == mInit->objectName() || !mTarget->initialized()) {
+            emit initChanged();
+            return;
+        }
+        // hot reload: only the edited script and the init scripts
+        // importing from it are re-executed
+        rerunInit(QStringList(name) << scope->importers(name));
+        emit drawChanged();
     } else if (scope->subscriptRelation(mDraw->objectName(), sender()->objectName())) {
         emit drawChanged();
     }
@@ -323,6 +500,89 @@ void Demo::Project::toggleAutoCompile(bool on) {
     }
 }
 
+void Demo::Project::setProfiling(bool on, bool gpu) {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    for (auto ed: scope->editors()) {
+        ed->setProfiling(on, gpu);
+    }
+    for (auto fun: scope->functions()) {
+        fun->setProfiling(on);
+    }
+}
+
+void Demo::Project::setReplay(bool on) {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    for (auto ed: scope->editors()) {
+        ed->compiler()->setReplay(on);
+    }
+}
+
+void Demo::Project::setTriangleLayout(const QModelIndex& index, bool on) {
+    if (index.parent() != itemParent(ModelItems)) return;
+    auto models = dynamic_cast<ModelStore*>(mFolders[ModelItems]);
+    models->setLayout(models->itemName(index.row()), on ? ModelStore::Triangles : ModelStore::Strips);
+    modelsChanged();
+}
+
+bool Demo::Project::triangleLayout(const QModelIndex& index) const {
+    if (index.parent() != itemParent(ModelItems)) return false;
+    auto models = dynamic_cast<ModelStore*>(mFolders[ModelItems]);
+    return models->layout(models->itemName(index.row())) == ModelStore::Triangles;
+}
+
+bool Demo::Project::exportProfile(const QString& path) const {
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) return false;
+    QTextStream out(&file);
+
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    out << "script\tline\thits\tcpu_ms\tgpu_ms\n";
+    for (auto ed: scope->editors()) {
+        // sum up statements sharing a line
+        QMap<int, GL::Runner::Sample> lines;
+        const GL::Runner::Profile& profile = ed->compiler()->runner()->profile();
+        for (auto it = profile.constBegin(); it != profile.constEnd(); ++it) {
+            GL::Runner::Sample& s = lines[ed->lineNumber(it.key())];
+            s.hits += it.value().hits;
+            s.nsecs += it.value().nsecs;
+            s.gpuNsecs += it.value().gpuNsecs;
+        }
+        for (auto it = lines.constBegin(); it != lines.constEnd(); ++it) {
+            out << ed->objectName() << "\t" << it.key() << "\t" << it.value().hits << "\t"
+                << it.value().nsecs * 1e-6 << "\t" << it.value().gpuNsecs * 1e-6 << "\n";
+        }
+    }
+
+    out << "\nfunction\thits\tcpu_ms\n";
+    for (auto fun: scope->functions()) {
+        if (fun->hits() == 0) continue;
+        out << fun->name() << "\t" << fun->hits() << "\t" << fun->nsecs() * 1e-6 << "\n";
+    }
+
+    return true;
+}
+
+QMap<QString, qint64> Demo::Project::scriptNsecs() const {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    QMap<QString, qint64> nsecs;
+    for (auto ed: scope->editors()) {
+        qint64& total = nsecs[ed->objectName()];
+        for (auto& sample: ed->compiler()->runner()->profile()) {
+            total += sample.nsecs;
+        }
+    }
+    return nsecs;
+}
+
+QStringList Demo::Project::brokenScripts() const {
+    auto scope = dynamic_cast<Scope*>(mFolders[ScriptItems]);
+    QStringList names;
+    for (auto ed: scope->editors()) {
+        if (ed->hasCompileError() || ed->hasRunError()) names.append(ed->objectName());
+    }
+    return names;
+}
+
 QModelIndex Demo::Project::itemParent(ItemType kind) const{
     return index(kind, QModelIndex());
 }
@@ -411,7 +671,7 @@ QVariant Demo::Project::data(const QModelIndex& index, int role) const {
         return QVariant::fromValue(folder->itemName(index.row()));
     }
 
-    if (role == Qt::ToolTipRole || role == FileNameRole) {
+    if (role == FileNameRole) {
         return QVariant::fromValue(fname);
     }
 
@@ -420,6 +680,12 @@ QVariant Demo::Project::data(const QModelIndex& index, int role) const {
 
         auto ed = dynamic_cast<Scope*>(folder)->editor(index.row());
 
+        if (role == Qt::ToolTipRole) {
+            return QVariant::fromValue(QString("%1\nStatements per frame: %2\nReplayed: %3")
+                                       .arg(fname).arg(ed->compiler()->instructions())
+                                       .arg(ed->compiler()->runner()->replayed()));
+        }
+
         if (role == Qt::DecorationRole) {
             if (ed->hasCompileError()) return QIcon::fromTheme("error");
             if (ed->hasRunError()) return QIcon::fromTheme("error");
@@ -435,6 +701,10 @@ QVariant Demo::Project::data(const QModelIndex& index, int role) const {
         return QVariant();
     }
 
+    if (role == Qt::ToolTipRole) {
+        return QVariant::fromValue(fname);
+    }
+
     if (index.parent() == itemParent(ModelItems) || index.parent() == itemParent(ShaderItems)) {
         if (role == Qt::DecorationRole) {
             if (fname.isEmpty()) return QIcon::fromTheme("unknown");
@@ -491,7 +761,11 @@ bool Demo::Project::setData(const QModelIndex &index, const QVariant &value, int
         }
 
         folder->setItem(name, path);
-
+        if (t == ModelItems) {
+            modelsChanged();
+            emit dataChanged(index, index);
+            return true;
+        }
 
     } else if (index.parent() == itemParent(ScriptItems)) {
 
@@ -547,8 +821,11 @@ bool Demo::Project::removeRows(int row, int count, const QModelIndex &parent)
     folder->remove(row);
     endRemoveRows();
 
-
-    recompileProject();
+    if (t == ModelItems) {
+        modelsChanged();
+    } else {
+        recompileProject();
+    }
     emit dataChanged(index(row, 0, parent), index(row, 0, parent));
     return true;
 }
@@ -584,7 +861,11 @@ bool Demo::Project::appendRow(const QString& name, const QString& file, const QM
     }
     endInsertRows();
 
-    recompileProject();
+    if (t == ModelItems) {
+        modelsChanged();
+    } else {
+        recompileProject();
+    }
     emit dataChanged(new_idx, new_idx);
     return true;
 }
@@ -72,6 +72,15 @@ public:
     void setProjectFile(const QString& fname);
     bool autoCompileEnabled() const {return mAutoCompileOn;}
     void toggleAutoCompile(bool on);
+    void setProfiling(bool on, bool gpu);
+    void setReplay(bool on);
+    // draw the model at index from an optimized triangle list instead of strips
+    void setTriangleLayout(const QModelIndex& index, bool on);
+    bool triangleLayout(const QModelIndex& index) const;
+    bool exportProfile(const QString& path) const;
+    // profiled CPU time per script, callers include their subscripts
+    QMap<QString, qint64> scriptNsecs() const;
+    QStringList brokenScripts() const;
     QString initScriptName() const {return INIT_NAME;}
     QString drawScriptName() const {return DRAW_NAME;}
 
@@ -122,6 +131,7 @@ public slots:
     void scriptStatus_changed();
 
     void recompileProject();
+    void resized();
 
 
 private slots:
@@ -145,6 +155,8 @@ private:
     QString fullpath(const QString& path) const;
     bool isReadable(const QString& path) const;
     bool isWritable(const QString& path) const;
+    void modelsChanged();
+    void rerunInit(const QStringList& names);
 
 private:
 
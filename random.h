@@ -0,0 +1,287 @@
+#ifndef DEMO_RANDOM_H
+#define DEMO_RANDOM_H
+
+#include "function.h"
+
+#include <cmath>
+
+namespace Demo {
+
+// xoshiro256** generator, shared by the random functions of a scope.
+// The same seed always gives the same sequence. Worker threads draw from
+// engines forked from the scope's one.
+class RandomEngine {
+
+public:
+
+    static const quint64 DefaultSeed = 0x2545f4914f6cdd1dULL;
+
+    explicit RandomEngine(quint64 seed = DefaultSeed) {
+        setSeed(seed);
+    }
+
+    // splitmix64 expands the seed to the full state
+    void setSeed(quint64 seed) {
+        for (int i = 0; i < 4; i++) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            quint64 z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            mState[i] = z ^ (z >> 31);
+        }
+        mHasSpare = false;
+    }
+
+    quint64 next() {
+        const quint64 r = rotl(mState[1] * 5, 7) * 9;
+        const quint64 t = mState[1] << 17;
+        mState[2] ^= mState[0];
+        mState[3] ^= mState[1];
+        mState[1] ^= mState[2];
+        mState[0] ^= mState[3];
+        mState[2] ^= t;
+        mState[3] = rotl(mState[3], 45);
+        return r;
+    }
+
+    // Copy of this engine, which then jumps 2^128 draws ahead: the two
+    // sequences do not overlap.
+    RandomEngine fork() {
+        RandomEngine e(*this);
+        static const quint64 Jump[4] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+            0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        quint64 s[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            for (int b = 0; b < 64; b++) {
+                if (Jump[i] & (1ULL << b)) {
+                    for (int k = 0; k < 4; k++) s[k] ^= mState[k];
+                }
+                next();
+            }
+        }
+        for (int k = 0; k < 4; k++) mState[k] = s[k];
+        mHasSpare = false;
+        return e;
+    }
+
+    // [0, 1)
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // [0, 1) in single precision: a double rounded to float can be 1
+    float uniformFloat() {
+        return (next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    // standard normal, Box-Muller with the second variate cached
+    double normal() {
+        if (mHasSpare) {
+            mHasSpare = false;
+            return mSpare;
+        }
+        double u = 1 - uniform(); // (0, 1]
+        double r = std::sqrt(-2 * std::log(u));
+        double phi = Math3D::TWO_PI * uniform();
+        mSpare = r * std::sin(phi);
+        mHasSpare = true;
+        return r * std::cos(phi);
+    }
+
+    // point in the unit cube
+    Vector4 uniformPos() {
+        double x = uniform();
+        double y = uniform();
+        double z = uniform();
+        return Vector4(x, y, z, 1);
+    }
+
+    // point with standard normal coordinates
+    Vector4 normalPos() {
+        double x = normal();
+        double y = normal();
+        double z = normal();
+        return Vector4(x, y, z, 1);
+    }
+
+    // uniformly distributed direction
+    Vector4 unitSphere() {
+        double z = 2 * uniform() - 1;
+        double phi = Math3D::TWO_PI * uniform();
+        double r = std::sqrt(1 - z * z);
+        return Vector4(r * std::cos(phi), r * std::sin(phi), z, 0);
+    }
+
+private:
+
+    static quint64 rotl(quint64 x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    quint64 mState[4];
+    bool mHasSpare;
+    double mSpare;
+};
+
+class RandomFunction: public Function {
+
+public:
+
+    bool replayable() const override {return false;}
+
+    RandomEngine* engine() const {return mEngine;}
+    void setEngine(RandomEngine* engine) {mEngine = engine;}
+
+protected:
+
+    RandomFunction(const QString& name, Type* type, RandomEngine* engine)
+        : Function(name, type)
+        , mEngine(engine) {}
+
+    RandomFunction(const RandomFunction& f)
+        : Function(f)
+        , mEngine(f.mEngine) {}
+
+    RandomEngine* mEngine;
+};
+
+class Random: public RandomFunction {
+
+public:
+
+    Random(RandomEngine* e): RandomFunction("random", new Real_T, e) {}
+
+    const QVariant& execute(const QVector<QVariant>&, int) override {
+        mValue.setValue(mEngine->uniformFloat());
+        return mValue;
+    }
+
+    Random* clone() const override {return new Random(*this);}
+};
+
+class RandomPos: public RandomFunction {
+
+public:
+
+    RandomPos(RandomEngine* e): RandomFunction("randompos", new Vector_T, e) {}
+
+    const QVariant& execute(const QVector<QVariant>&, int) override {
+        mValue.setValue(mEngine->uniformPos());
+        return mValue;
+    }
+
+    RandomPos* clone() const override {return new RandomPos(*this);}
+};
+
+class RandomSeed: public RandomFunction {
+
+public:
+
+    RandomSeed(RandomEngine* e): RandomFunction("randomseed", new Integer_T, e) {
+        mArgTypes.append(new Integer_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        mEngine->setSeed(static_cast<quint64>(vals[start].value<Math3D::Integer>()));
+        mValue.setValue(0);
+        return mValue;
+    }
+
+    RandomSeed* clone() const override {return new RandomSeed(*this);}
+};
+
+// randomreals(count, "uniform" | "normal")
+class RandomReals: public RandomFunction {
+
+public:
+
+    RandomReals(RandomEngine* e)
+        : RandomFunction("randomreals", new ArrayType(new Real_T), e) {
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Text_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        int count = vals[start].value<Math3D::Integer>();
+        QString mode = vals[start + 1].toString();
+        if (count < 0) throw RunError("Negative count", 0);
+
+        QVariantList list;
+        list.reserve(count);
+        if (mode == "uniform") {
+            for (int i = 0; i < count; i++) {
+                list.append(QVariant::fromValue(mEngine->uniformFloat()));
+            }
+        } else if (mode == "normal") {
+            for (int i = 0; i < count; i++) {
+                list.append(QVariant::fromValue(static_cast<Math3D::Real>(mEngine->normal())));
+            }
+        } else {
+            throw RunError(QString("Unknown distribution: %1").arg(mode), 0);
+        }
+        mValue.setValue(list);
+        return mValue;
+    }
+
+    RandomReals* clone() const override {return new RandomReals(*this);}
+};
+
+// randomvecs(count, "uniform" | "normal" | "sphere")
+class RandomVecs: public RandomFunction {
+
+public:
+
+    RandomVecs(RandomEngine* e)
+        : RandomFunction("randomvecs", new ArrayType(new Vector_T), e) {
+        mArgTypes.append(new Integer_T);
+        mArgTypes.append(new Text_T);
+    }
+
+    const QVariant& execute(const QVector<QVariant>& vals, int start) override {
+        int count = vals[start].value<Math3D::Integer>();
+        QString mode = vals[start + 1].toString();
+        if (count < 0) throw RunError("Negative count", 0);
+
+        QVariantList list;
+        list.reserve(count);
+        if (mode == "uniform") {
+            for (int i = 0; i < count; i++) {
+                list.append(QVariant::fromValue(mEngine->uniformPos()));
+            }
+        } else if (mode == "normal") {
+            for (int i = 0; i < count; i++) {
+                list.append(QVariant::fromValue(mEngine->normalPos()));
+            }
+        } else if (mode == "sphere") {
+            for (int i = 0; i < count; i++) {
+                list.append(QVariant::fromValue(mEngine->unitSphere()));
+            }
+        } else {
+            throw RunError(QString("Unknown distribution: %1").arg(mode), 0);
+        }
+        mValue.setValue(list);
+        return mValue;
+    }
+
+    RandomVecs* clone() const override {return new RandomVecs(*this);}
+};
+
+class RandomFunctions {
+
+public:
+
+    QVector<Demo::Symbol*> contents;
+
+    RandomFunctions(RandomEngine* e) {
+        contents.append(new Random(e));
+        contents.append(new RandomPos(e));
+        contents.append(new RandomSeed(e));
+        contents.append(new RandomReals(e));
+        contents.append(new RandomVecs(e));
+    }
+};
+
+} // namespace Demo
+
+#endif // DEMO_RANDOM_H
@@ -14,6 +14,9 @@ public:
     Dispatcher(Scope* p);
     const QVariant& execute(const QVector<QVariant>& vals, int start) override;
     Dispatcher* clone() const override;
+    // subscripts are run by their editors
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
 private:
     Scope* mParent;
 };
@@ -39,6 +42,8 @@ Dispatcher* Dispatcher::clone() const {
 
 Scope::Scope(GLWidget* glContext, QObject *parent)
     : ProjectFolder("scope", parent)
+    , mContext(glContext)
+    , mRandom()
 {
     // GL functions, constants & variables
     glContext->addGLSymbols(mSymbols, mExports);
@@ -51,6 +56,9 @@ Scope::Scope(GLWidget* glContext, QObject *parent)
     Functions funcs;
     for (auto sym: qAsConst(funcs.contents)) mSymbols[sym->name()] = sym;
 
+    RandomFunctions randoms(&mRandom);
+    for (auto sym: qAsConst(randoms.contents)) mSymbols[sym->name()] = sym;
+
     // types
     Basetypes types;
     for (auto sym: qAsConst(types.contents)) mSymbols[sym->name()] = sym;
@@ -73,7 +81,9 @@ Scope::~Scope() {
 }
 
 Scope::Scope(const Scope& s):
-    ProjectFolder("scope")
+    ProjectFolder("scope"),
+    mContext(s.mContext),
+    mRandom(s.mRandom)
 {
     for (auto sym: s.symbols()) {
         mSymbols[sym->name()] = sym->clone();
@@ -90,6 +100,15 @@ Scope::Scope(const Scope& s):
     }
     mSymbols[dispatcher->name()] = dispatcher;
 
+    // replace random functions: the clones draw from our own engine
+    RandomFunctions randoms(&mRandom);
+    for (auto sym: qAsConst(randoms.contents)) {
+        if (mSymbols.contains(sym->name())) {
+            delete mSymbols[sym->name()];
+        }
+        mSymbols[sym->name()] = sym;
+    }
+
     // process functions
     for (auto sym: qAsConst(mSymbols)) {
         Function* fun = dynamic_cast<Function*>(sym);
@@ -125,16 +144,74 @@ bool Scope::subscriptRelation(const QString& top, const QString& sub) {
     return false;
 }
 
+// scripts importing from name, directly or transitively
+QStringList Scope::importers(const QString& name) const {
+    QStringList r;
+    QStringList pending{name};
+    while (!pending.isEmpty()) {
+        QString curr = pending.takeFirst();
+        for (auto ed: mEditors) {
+            QString other = ed->objectName();
+            if (other == name || r.contains(other)) continue;
+            if (!ed->compiler()->imports().contains(curr)) continue;
+            r << other;
+            pending << other;
+        }
+    }
+    return r;
+}
+
+// scripts reading the given global variables, directly or through imports
+QStringList Scope::dependents(const QStringList& globals) const {
+    QStringList r;
+    for (auto ed: mEditors) {
+        for (auto& name: globals) {
+            if (!ed->compiler()->globalImports().contains(name)) continue;
+            r << ed->objectName();
+            break;
+        }
+    }
+    for (auto& name: QStringList(r)) {
+        for (auto& other: importers(name)) {
+            if (!r.contains(other)) r << other;
+        }
+    }
+    return r;
+}
+
+// top and its subscripts, transitively, in the order of their first
+// dispatch
+QStringList Scope::subscripts(const QString& top) const {
+    QStringList r;
+    QStringList pending{top};
+    while (!pending.isEmpty()) {
+        QString curr = pending.takeLast();
+        if (r.contains(curr)) continue;
+        r << curr;
+        GL::Compiler* c = compiler(curr);
+        if (!c) continue;
+        const QStringList& subs = c->subscripts();
+        for (int i = subs.size() - 1; i >= 0; i--) pending << subs[i];
+    }
+    return r;
+}
+
 void Scope::dispatch(const QString& other) const {
     // qCDebug(OGL) << "dispatch" << other;
     if (mEditorIndices.contains(other)) {
         CodeEditor* other_ed = mEditors[mEditorIndices[other]];
-        other_ed->run();
+        // GL-free subscripts of the draw script run in a worker thread
+        other_ed->run(mContext->drawing() && glFree(other));
     } else {
         throw RunError(QString("Script %1 not found").arg(other), 0);
     }
 }
 
+bool Scope::glFree(const QString& name) const {
+    GL::Compiler* c = compiler(name);
+    return c && c->ready() && c->glFree();
+}
+
 const Scope::EditorVector& Scope::editors() const {
     return mEditors;
 }
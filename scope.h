@@ -5,6 +5,7 @@
 #include "function.h"
 #include "variable.h"
 #include "projectfolder.h"
+#include "random.h"
 
 namespace Demo {
 
@@ -44,7 +45,12 @@ public:
     const SymbolMap& symbols() const;
     const FunctionVector& functions() const;
     bool subscriptRelation(const QString& top, const QString& sub);
+    QStringList importers(const QString& name) const;
+    QStringList dependents(const QStringList& globals) const;
+    QStringList subscripts(const QString& top) const;
     void dispatch(const QString& other) const;
+    bool glFree(const QString& name) const;
+    GLWidget* context() const {return mContext;}
     GL::Compiler* compiler(const QString& name) const;
     const VariableMap& exports() const;
     void addFunction(Function* f);
@@ -65,6 +71,8 @@ private:
 
     Scope(const Scope&);
 
+    GLWidget* mContext;
+    RandomEngine mRandom;
     SymbolMap mSymbols;
     FunctionVector mFunctions;
     VariableMap mExports;
@@ -3,8 +3,11 @@
 #include "gl_lang_compiler.h"
 #include "scope.h"
 
+#include <QElapsedTimer>
+
 using Math3D::Matrix4;
 using Math3D::Vector4;
+using Math3D::Quaternion;
 using Math3D::Real;
 using Demo::GL::Compiler;
 
@@ -15,6 +18,7 @@ Statement::Statement(CodeStack code, ValueStack immed, unsigned stackSize, int p
     , mImmed(std::move(immed))
     , mStack(stackSize)
     , mPos(pos)
+    , mRecorder(nullptr)
 {}
 
 Statement::Statement(int pos)
@@ -22,16 +26,18 @@ Statement::Statement(int pos)
     , mImmed()
     , mStack()
     , mPos(pos)
+    , mRecorder(nullptr)
 {}
 
 static void neg_f(QVariant& right, int lrtype) {
 
     static QFunc funcs[] = {
-        Neg<int>, Neg<Real>, Neg<Vector4>, Neg<Matrix4>, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Neg<int>, Neg<Real>, Neg<Vector4>, Neg<Matrix4>, nullptr, Neg<Quaternion>,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     funcs[lrtype](right);
@@ -41,11 +47,12 @@ static void neg_f(QVariant& right, int lrtype) {
 static void take_f(QVariant& left, int index, int lrtype) {
 
     static QIFunc funcs[] = {
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        Take<Vector4>, nullptr, nullptr, nullptr, nullptr,
-        Vec<Matrix4>, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        Take<Vector4>, nullptr, nullptr, nullptr, nullptr, nullptr,
+        Vec<Matrix4>, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     funcs[lrtype](left, index);
@@ -54,11 +61,12 @@ static void take_f(QVariant& left, int index, int lrtype) {
 static void add_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static QQFunc funcs[] = {
-        Add<int, int>, Add<int, Real>, nullptr, nullptr, nullptr,
-        Add<Real, int>, Add<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, Add<Vector4, Vector4>, nullptr, nullptr,
-        nullptr, nullptr, nullptr, Add<Matrix4, Matrix4>, nullptr,
-        nullptr, nullptr, nullptr, nullptr, Add<QString, QString>
+        Add<int, int>, Add<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Add<Real, int>, Add<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, Add<Vector4, Vector4>, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, Add<Matrix4, Matrix4>, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, Add<QString, QString>, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     funcs[lrtype](left, right);
@@ -67,11 +75,12 @@ static void add_f(QVariant& left, const QVariant& right, int lrtype) {
 static void sub_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static QQFunc funcs[] = {
-        Sub<int, int>, Sub<int, Real>, nullptr, nullptr, nullptr,
-        Sub<Real, int>, Sub<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, Sub<Vector4, Vector4>, nullptr, nullptr,
-        nullptr, nullptr, nullptr, Sub<Matrix4, Matrix4>, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Sub<int, int>, Sub<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Sub<Real, int>, Sub<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, Sub<Vector4, Vector4>, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, Sub<Matrix4, Matrix4>, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     funcs[lrtype](left, right);
@@ -80,11 +89,12 @@ static void sub_f(QVariant& left, const QVariant& right, int lrtype) {
 static void mul_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static QQFunc funcs[] = {
-        Mul<int, int>, Mul<int, Real>, Mul<int, Vector4>, Mul<int, Matrix4>, nullptr,
-        Mul<Real, int>, Mul<Real, Real>, Mul<Real, Vector4>, Mul<Real, Matrix4>, nullptr,
-        Mul<Vector4, int>, Mul<Vector4, Real>, nullptr, nullptr, nullptr,
-        Mul<Matrix4, int>, Mul<Matrix4, Real>, Mul<Matrix4, Vector4>, Mul<Matrix4, Matrix4>, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Mul<int, int>, Mul<int, Real>, Mul<int, Vector4>, Mul<int, Matrix4>, nullptr, nullptr,
+        Mul<Real, int>, Mul<Real, Real>, Mul<Real, Vector4>, Mul<Real, Matrix4>, nullptr, nullptr,
+        Mul<Vector4, int>, Mul<Vector4, Real>, nullptr, nullptr, nullptr, nullptr,
+        Mul<Matrix4, int>, Mul<Matrix4, Real>, Mul<Matrix4, Vector4>, Mul<Matrix4, Matrix4>, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, Mul<Quaternion, Vector4>, nullptr, nullptr, Mul<Quaternion, Quaternion>
     };
 
     funcs[lrtype](left, right);
@@ -94,11 +104,12 @@ static void mul_f(QVariant& left, const QVariant& right, int lrtype) {
 static bool div_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static BQQFunc funcs[] = {
-        Div<int, int>, Div<int, Real>, nullptr, nullptr, nullptr,
-        Div<Real, int>, Div<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Div<int, int>, Div<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Div<Real, int>, Div<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     if (!funcs[lrtype](left, right)) return false;
@@ -108,11 +119,12 @@ static bool div_f(QVariant& left, const QVariant& right, int lrtype) {
 static bool eq_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static BQQFunc funcs[] = {
-        Eq<int, int>, Eq<int, Real>, nullptr, nullptr, nullptr,
-        Eq<Real, int>, Eq<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, Eq<Vector4, Vector4>, nullptr, nullptr,
-        nullptr, nullptr, nullptr, Eq<Matrix4, Matrix4>, nullptr,
-        nullptr, nullptr, nullptr, nullptr, Eq<QString, QString>
+        Eq<int, int>, Eq<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Eq<Real, int>, Eq<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, Eq<Vector4, Vector4>, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, Eq<Matrix4, Matrix4>, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, Eq<QString, QString>, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, Eq<Quaternion, Quaternion>
     };
 
     return funcs[lrtype](left, right);
@@ -121,11 +133,12 @@ static bool eq_f(QVariant& left, const QVariant& right, int lrtype) {
 static bool gt_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static BQQFunc funcs[] = {
-        Gt<int, int>, Gt<int, Real>, nullptr, nullptr, nullptr,
-        Gt<Real, int>, Gt<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Gt<int, int>, Gt<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Gt<Real, int>, Gt<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     return funcs[lrtype](left, right);
@@ -134,11 +147,12 @@ static bool gt_f(QVariant& left, const QVariant& right, int lrtype) {
 static bool lt_f(QVariant& left, const QVariant& right, int lrtype) {
 
     static BQQFunc funcs[] = {
-        Lt<int, int>, Lt<int, Real>, nullptr, nullptr, nullptr,
-        Lt<Real, int>, Lt<Real, Real>, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr,
-        nullptr, nullptr, nullptr, nullptr, nullptr
+        Lt<int, int>, Lt<int, Real>, nullptr, nullptr, nullptr, nullptr,
+        Lt<Real, int>, Lt<Real, Real>, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
     };
 
     return funcs[lrtype](left, right);
@@ -262,12 +276,23 @@ const QVariant& Statement::evalCode(const VariableIndexMap& vars, const Function
             auto fun = funcs[codes[++ic] - Scope::FunctionOffset];
             // qCDebug(OGL) << "function" << fun->name();
             sPos -= fun->argTypes().size() - 1;
-            mStack[sPos] = fun->execute(mStack, sPos);
+            if (mRecorder) mRecorder->call(fun, mStack, sPos);
+            if (fun->profiling()) {
+                QElapsedTimer clock;
+                clock.start();
+                mStack[sPos] = fun->execute(mStack, sPos);
+                fun->addSample(clock.nsecsElapsed());
+            } else {
+                mStack[sPos] = fun->execute(mStack, sPos);
+            }
             break;
         }
-        case Compiler::cVar:
-            mStack[++sPos] = vars[codes[++ic]]->value();
+        case Compiler::cVar: {
+            auto v = vars[codes[++ic]];
+            if (mRecorder) mRecorder->read(v);
+            mStack[++sPos] = v->value();
             break;
+        }
 
         case Compiler::cVarPath: {
             int index = codes[++ic];
@@ -279,6 +304,7 @@ const QVariant& Statement::evalCode(const VariableIndexMap& vars, const Function
             for (int k = 0; k < numItems; k++) {
                 indices << mStack[sPos + k].toInt();
             }
+            if (mRecorder) mRecorder->read(vars[index]);
             mStack[sPos] = vars[index]->value(indices);
             break;
         }
@@ -287,6 +313,7 @@ const QVariant& Statement::evalCode(const VariableIndexMap& vars, const Function
 
             auto v = vars[codes[++ic]];
             v->setValue(mStack[sPos]);
+            if (mRecorder) mRecorder->write(v);
 //            if (v->name() != "gl_result") {
 //                qCDebug(OGL) <<"ass" << v->name() << "=" << v->value();
 //            }
@@ -302,7 +329,10 @@ const QVariant& Statement::evalCode(const VariableIndexMap& vars, const Function
                 indices << mStack[sPos - numItems + k].toInt();
             }
             auto v = vars[index];
+            // the rest of the value is kept: a read as well
+            if (mRecorder) mRecorder->read(v);
             v->setValue(mStack[sPos], indices);
+            if (mRecorder) mRecorder->write(v);
             // qCDebug(OGL) << "asspath" << v->name() << "[" << indices << "] =" << v->value(indices);
             mStack[sPos - numItems] = mStack[sPos];
             sPos -= numItems;
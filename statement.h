@@ -10,6 +10,16 @@ namespace Demo {
 
 namespace Statement {
 
+// Sees the variable accesses and function calls of a statement
+// while the runner records a command buffer
+class Recorder {
+public:
+    virtual void read(const Variable* var) = 0;
+    virtual void write(Variable* var) = 0;
+    virtual void call(Function* fun, const QVector<QVariant>& vals, int start) = 0;
+    virtual ~Recorder() = default;
+};
+
 class Statement {
 public:
 
@@ -27,6 +37,8 @@ public:
 
     int pos() {return mPos;}
 
+    void setRecorder(Recorder* recorder) {mRecorder = recorder;}
+
 protected:
 
     const QVariant& evalCode(const VariableIndexMap& vars, const FunctionVector& funcs);
@@ -37,6 +49,7 @@ protected:
     ValueStack mImmed;
     ValueStack mStack;
     int mPos;
+    Recorder* mRecorder;
 
 };
 
@@ -93,6 +106,19 @@ public:
 };
 
 
+// Suspension point: the runner may resume the script from
+// the next statement on the next frame
+class Yield: public Statement {
+
+public:
+
+    Yield(int pos) : Statement(pos) {}
+    int exec_and_jump(VariableIndexMap&, const FunctionVector&) override {return 1;}
+    Yield* clone() const override {return new Yield(*this);}
+
+};
+
+
 template<typename R> void Neg(QVariant& right) {
     right.setValue(- right.value<R>());
 }
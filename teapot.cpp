@@ -590,9 +590,9 @@ GL::Teapot::Teapot()
     int len2 = sizeof(float) * normals.length();
     int len3 = sizeof(float) * texcoords.length();
     // num components, type, is normalized, packing offset, data offset
-    mSpecs["vertex"] = BlobSpec(3, GL_FLOAT, false, 0, 0);
-    mSpecs["normal"] = BlobSpec(3, GL_FLOAT, true, 0, len1);
-    mSpecs["tex"] = BlobSpec(2, GL_FLOAT, false, 0, len1 + len2);
+    setSpec("vertex", BlobSpec(3, GL_FLOAT, false, 0, 0));
+    setSpec("normal", BlobSpec(3, GL_FLOAT, true, 0, len1));
+    setSpec("tex", BlobSpec(2, GL_FLOAT, false, 0, len1 + len2));
 
     char* data = (char*) ::malloc(len1 + len2 + len3);
     QVector<float> datavec = vertices.toVector();
@@ -631,7 +631,11 @@ GL::Teapot::Teapot()
 }
 
 
-void GL::Teapot::draw(unsigned int mode, const QString&) const {
+int GL::Teapot::drawKey(const QString&) const {
+    return 0;
+}
+
+void GL::Teapot::draw(unsigned int mode, int) const {
     if (!mSupported.contains(mode)) return;
     int name;
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &name);
@@ -20,7 +20,8 @@ public:
 
     Teapot();
 
-    void draw(unsigned int mode, const QString& attr) const override;
+    int drawKey(const QString& attr) const override;
+    void draw(unsigned int mode, int key) const override;
 
     ~Teapot() override;
 
@@ -0,0 +1,13 @@
+QT += testlib
+QT -= gui
+
+CONFIG += c++14 testcase
+
+TARGET = tst_mesh
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_mesh.cpp \
+    ../../triangleoptimizer.cpp \
+    ../../meshoptimizer.cpp
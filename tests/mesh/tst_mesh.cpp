@@ -0,0 +1,147 @@
+#include <QtTest>
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+
+#include "triangleoptimizer.h"
+#include "meshoptimizer.h"
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(OGL, "OpenGLDemo")
+
+using namespace Demo;
+using Mesh::IndexVector;
+
+class TestMesh: public QObject {
+
+    Q_OBJECT
+
+private slots:
+
+    void stripsToList();
+    void simplify();
+    void linkCondition();
+
+private:
+
+    using TriangleCount = QMap<QVector<uint>, int>;
+
+    // triangles with their first index the smallest, winding kept
+    static TriangleCount count(const IndexVector& triangles);
+    static IndexVector reversed(const IndexVector& triangles);
+    static void grid(int size, IndexVector& triangles, Mesh::Vector4Vector& positions);
+};
+
+TestMesh::TriangleCount TestMesh::count(const IndexVector& triangles) {
+    TriangleCount r;
+    for (int i = 0; i + 2 < triangles.size(); i += 3) {
+        QVector<uint> t{triangles[i], triangles[i + 1], triangles[i + 2]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        r[t]++;
+    }
+    return r;
+}
+
+IndexVector TestMesh::reversed(const IndexVector& triangles) {
+    IndexVector r;
+    for (int i = 0; i + 2 < triangles.size(); i += 3) {
+        r << triangles[i] << triangles[i + 2] << triangles[i + 1];
+    }
+    return r;
+}
+
+// bumpy height field
+void TestMesh::grid(int size, IndexVector& triangles, Mesh::Vector4Vector& positions) {
+    for (int j = 0; j <= size; j++) {
+        for (int i = 0; i <= size; i++) {
+            positions.append(Math3D::Vector4(i, j, std::sin(i * .5) * std::cos(j * .3)));
+        }
+    }
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            uint a = j * (size + 1) + i;
+            uint b = a + size + 1;
+            triangles << a << a + 1 << b + 1 << a << b + 1 << b;
+        }
+    }
+}
+
+// the strips cover every triangle once, in reversed winding
+void TestMesh::stripsToList() {
+    IndexVector triangles;
+    Mesh::Vector4Vector positions;
+    grid(24, triangles, positions);
+
+    AC::TriangleOptimizer optimizer(triangles);
+    QVERIFY(optimizer.strips().size() > 0);
+    IndexVector list;
+    for (auto& strip: optimizer.strips()) Mesh::appendStrip(list, strip);
+
+    QCOMPARE(list.size(), triangles.size());
+    // the stripifier reverses the face winding, project cull settings rely on it
+    QCOMPARE(count(list), count(reversed(triangles)));
+}
+
+// Fewer triangles, no degenerate ones, and seen from above none of the
+// height field's triangles is flipped
+void TestMesh::simplify() {
+    IndexVector triangles;
+    Mesh::Vector4Vector positions;
+    grid(24, triangles, positions);
+
+    float distance = -1;
+    IndexVector result = Mesh::simplify(triangles, positions, triangles.size() / 12, distance);
+    QCOMPARE(result.size() % 3, 0);
+    QVERIFY(4 * result.size() <= 3 * triangles.size());
+    QVERIFY(distance > 0);
+
+    for (int i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; k++) QVERIFY(result[i + k] < uint(positions.size()));
+        uint a = result[i];
+        uint b = result[i + 1];
+        uint c = result[i + 2];
+        QVERIFY(a != b && b != c && c != a);
+        const Math3D::Vector4& p = positions[a];
+        const Math3D::Vector4& q = positions[b];
+        const Math3D::Vector4& r = positions[c];
+        float z = (q[0] - p[0]) * (r[1] - p[1]) - (q[1] - p[1]) * (r[0] - p[0]);
+        QVERIFY2(z >= 0, qPrintable(QString("triangle %1").arg(i / 3)));
+    }
+
+    // nothing to do
+    IndexVector same = Mesh::simplify(triangles, positions, triangles.size(), distance);
+    QVERIFY(same == triangles);
+    QCOMPARE(distance, 0.f);
+}
+
+// A fan around vertex 0 with a fin on the chord 1-4. The cheapest collapse,
+// 0 into 1, would give the chord three triangles.
+void TestMesh::linkCondition() {
+    Mesh::Vector4Vector positions;
+    positions.append(Math3D::Vector4(0, 0, 0.1f));
+    for (int k = 0; k < 6; k++) {
+        float r = k == 0 ? 0.5f : 1;
+        positions.append(Math3D::Vector4(r * std::cos(k * M_PI / 3), r * std::sin(k * M_PI / 3), 0));
+    }
+    positions.append(Math3D::Vector4(0, 0, 1));
+    IndexVector triangles;
+    for (uint k = 0; k < 6; k++) triangles << 0 << 1 + k << 1 + (k + 1) % 6;
+    triangles << 1 << 4 << 7;
+
+    float distance;
+    IndexVector result = Mesh::simplify(triangles, positions, 5, distance);
+    QCOMPARE(result.size(), 15);
+    QMap<QPair<uint, uint>, int> edges;
+    for (int i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            uint a = result[i + k];
+            uint b = result[i + (k + 1) % 3];
+            edges[qMakePair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+    for (int n: qAsConst(edges)) QVERIFY(n <= 2);
+}
+
+QTEST_GUILESS_MAIN(TestMesh)
+
+#include "tst_mesh.moc"
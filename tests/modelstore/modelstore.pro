@@ -0,0 +1,10 @@
+include(../../OpenGLDemo.pri)
+
+QT += testlib
+
+CONFIG += testcase
+
+TARGET = tst_modelstore
+TEMPLATE = app
+
+SOURCES += tst_modelstore.cpp
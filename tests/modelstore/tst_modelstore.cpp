@@ -0,0 +1,295 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <cmath>
+
+#include "modelstore.h"
+#include "bufferheap.h"
+#include "objreader.h"
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(OGL, "OpenGLDemo")
+
+using Demo::GL::ModelStore;
+using Demo::GL::BufferHeap;
+using Loader = Demo::GL::ModelStore::Loader;
+
+class TestModelStore: public QObject {
+
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+    void cacheRoundTrip();
+    void cacheVersion();
+    void quantization();
+    void heap();
+    void inPlace();
+    void reader_data();
+    void reader();
+
+private:
+
+    static void writeGrid(const QString& path, int size);
+    static void compareBuffers(const ModelStore& a, const ModelStore& b);
+    static bool parse(Loader& loader, const QString& path);
+    QString cacheFile() const;
+
+    QTemporaryDir mDir;
+    QString mModel;
+};
+
+// bumpy grid, enough triangles for levels of detail
+static const int GridSize = 24;
+
+void TestModelStore::writeGrid(const QString& path, int size) {
+    QFile file(path);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+    QTextStream out(&file);
+    for (int j = 0; j <= size; j++) {
+        for (int i = 0; i <= size; i++) {
+            out << "v " << i << " " << j << " " << std::sin(i * .5) * std::cos(j * .3) << "\n";
+        }
+    }
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            int a = j * (size + 1) + i + 1;
+            int b = a + size + 1;
+            out << "f " << a << " " << a + 1 << " " << b + 1 << "\n";
+            out << "f " << a << " " << b + 1 << " " << b << "\n";
+        }
+    }
+}
+
+void TestModelStore::initTestCase() {
+    QVERIFY(mDir.isValid());
+    mModel = mDir.filePath("grid.obj");
+    writeGrid(mModel, GridSize);
+}
+
+void TestModelStore::compareBuffers(const ModelStore& a, const ModelStore& b) {
+    for (unsigned target: {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER}) {
+        QCOMPARE(a.bytelen(target), b.bytelen(target));
+        QVERIFY(a.bytelen(target) > 0);
+        QVERIFY(::memcmp(a.bytes(target), b.bytes(target), a.bytelen(target)) == 0);
+    }
+}
+
+QString TestModelStore::cacheFile() const {
+    QDir cache(mDir.filePath("cache"));
+    QStringList files = cache.entryList({"*.model"}, QDir::Files);
+    return files.size() == 1 ? cache.filePath(files.first()) : QString();
+}
+
+// a model read from the cache is the model parsed from the file
+void TestModelStore::cacheRoundTrip() {
+    ModelStore parsed;
+    parsed.setCacheDir(mDir.filePath("cache"));
+    parsed.setItem("grid", mModel);
+    QVERIFY(!cacheFile().isEmpty());
+
+    ModelStore cached;
+    cached.setCacheDir(mDir.filePath("cache"));
+    cached.setItem("grid", mModel);
+    compareBuffers(parsed, cached);
+
+    int key = parsed.drawKey("grid");
+    Math3D::Matrix4 clip;
+    clip.setIdentity();
+    // the levels of detail come back with their errors
+    for (float pixels: {0.01f, 1.f, 100.f}) {
+        QCOMPARE(cached.lod(key, clip, 640, 480, pixels), parsed.lod(key, clip, 640, 480, pixels));
+    }
+}
+
+// a cache of another version is not read but rewritten
+void TestModelStore::cacheVersion() {
+    ModelStore parsed;
+    parsed.setCacheDir(mDir.filePath("cache"));
+    parsed.setItem("grid", mModel);
+
+    QFile file(cacheFile());
+    QVERIFY(file.open(QFile::ReadWrite));
+    quint32 version;
+    QVERIFY(file.seek(4));
+    QCOMPARE(file.read(reinterpret_cast<char*>(&version), 4).size(), 4);
+    quint32 other = version - 1;
+    QVERIFY(file.seek(4));
+    QCOMPARE(file.write(reinterpret_cast<const char*>(&other), 4), qint64(4));
+    file.close();
+
+    ModelStore reloaded;
+    reloaded.setCacheDir(mDir.filePath("cache"));
+    reloaded.setItem("grid", mModel);
+    compareBuffers(parsed, reloaded);
+
+    QVERIFY(file.open(QFile::ReadOnly));
+    QVERIFY(file.seek(4));
+    quint32 rewritten;
+    QCOMPARE(file.read(reinterpret_cast<char*>(&rewritten), 4).size(), 4);
+    QCOMPARE(rewritten, version);
+}
+
+// dequantized positions are within half a step of the float ones
+void TestModelStore::quantization() {
+    ModelStore planar;
+    planar.setItem("grid", mModel);
+    ModelStore quantized;
+    quantized.setFormat("grid", ModelStore::Quantized);
+    quantized.setItem("grid", mModel);
+
+    Demo::GL::BlobSpec p = planar.spec("grid:vertex");
+    Demo::GL::BlobSpec q = quantized.spec("grid:vertex");
+    QCOMPARE(q.type, quint32(GL_UNSIGNED_SHORT));
+    QVERIFY(q.normalized);
+    // planar: the normals follow the positions
+    int n = (GridSize + 1) * (GridSize + 1);
+    QVERIFY(planar.spec("grid:normal").offset >= p.offset + n * 3 * sizeof(GLfloat));
+
+    Math3D::Matrix4 m = quantized.dequantization(quantized.drawKey("grid"));
+    const char* pData = static_cast<const char*>(planar.bytes(GL_ARRAY_BUFFER)) + p.offset;
+    const char* qData = static_cast<const char*>(quantized.bytes(GL_ARRAY_BUFFER)) + q.offset;
+    const float step = float(GridSize) / 0xffff;
+    for (int i = 0; i < n; i++) {
+        const GLfloat* pos = reinterpret_cast<const GLfloat*>(pData) + 3 * i;
+        const GLushort* fix = reinterpret_cast<const GLushort*>(qData + q.stride * i);
+        Math3D::Vector4 v = m * Math3D::Vector4(fix[0] / 65535., fix[1] / 65535., fix[2] / 65535.);
+        for (int k = 0; k < 3; k++) {
+            QVERIFY2(std::abs(v[k] - pos[k]) <= step, qPrintable(QString("vertex %1").arg(i)));
+        }
+    }
+    // the planar format needs none
+    Math3D::Matrix4 id;
+    id.setIdentity();
+    QVERIFY(planar.dequantization(planar.drawKey("grid")) == id);
+}
+
+// first fit, hints, and merging of adjacent free ranges
+void TestModelStore::heap() {
+    BufferHeap heap;
+    heap.reset(100);
+    QCOMPARE(heap.allocate(10), 0u);
+    QCOMPARE(heap.allocate(20), 10u);
+    QCOMPARE(heap.allocate(30), 30u);
+    QCOMPARE(heap.allocate(50), BufferHeap::Full);
+    QCOMPARE(heap.capacity(), 100u);
+
+    heap.release(10, 20);
+    QCOMPARE(heap.allocate(5), 10u);
+    QCOMPARE(heap.allocate(15), 15u);
+    heap.release(10, 5);
+    // at the hint if there is room, else first fit
+    QCOMPARE(heap.allocate(5, 70), 70u);
+    QCOMPARE(heap.allocate(10, 5), 60u);
+
+    // released in an order that merges with the next, the previous and both
+    heap.release(60, 10);
+    heap.release(70, 5);
+    heap.release(0, 10);
+    heap.release(15, 15);
+    heap.release(30, 30);
+    QCOMPARE(heap.allocate(100), 0u);
+}
+
+// a reloaded model that fits keeps its place and attribute offsets
+void TestModelStore::inPlace() {
+    ModelStore store;
+    store.setItem("grid", mModel);
+    store.setItem("other", mModel);
+    Demo::GL::BlobSpec normal = store.spec("grid:normal");
+    Demo::GL::BlobSpec tex = store.spec("grid:tex");
+
+    QString smaller = mDir.filePath("smaller.obj");
+    writeGrid(smaller, GridSize - 2);
+    store.setItem("grid", smaller);
+    QVERIFY(!store.moved());
+    QCOMPARE(store.spec("grid:normal").offset, normal.offset);
+    QCOMPARE(store.spec("grid:tex").offset, tex.offset);
+
+    // and back, the slack is kept
+    store.setItem("grid", mModel);
+    QVERIFY(!store.moved());
+    QCOMPARE(store.spec("grid:normal").offset, normal.offset);
+}
+
+bool TestModelStore::parse(Loader& loader, const QString& path) {
+    try {
+        loader.parseModelData(path);
+    } catch (Demo::WF::ModelError&) {
+        return false;
+    }
+    return true;
+}
+
+// fast: 1 if the hand written reader takes the input, 0 if it falls
+// back to the grammar, -1 either
+void TestModelStore::reader_data() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<int>("fast");
+
+    QDir ogl(QFINDTESTDATA("../../ogl"));
+    for (auto& name: ogl.entryList({"*.obj"}, QDir::Files)) {
+        QTest::newRow(qPrintable(name)) << ogl.filePath(name) << -1;
+    }
+
+    const char* triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+    struct Input {const char* name; QByteArray text; int fast;};
+    const QVector<Input> inputs = {
+        {"crlf", "v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\nf 1 2 3\r\n", 0},
+        {"trailing vertex comment", "v 0 0 0 # origin\nv 1 0 0\nv 0 1 0\nf 1 2 3\n", 0},
+        {"trailing face comment", QByteArray(triangle) + "f 1 2 3 # face\n", 0},
+        {"comment lines", QByteArray("# grid\n") + triangle + "\n  # faces\nf 1 2 3\n", 1},
+        {"leading zero triplets", QByteArray(triangle) + "vt 0 0\nf 01/001/ 02/01/ 003/1/\n", 1},
+        {"leading zero ints", QByteArray(triangle) + "f 01 02 03\n", 0},
+        {"vt 1", QByteArray(triangle) + "vt .5\nvt 0 1\nf 1/1/ 2/1/ 3/1/\n", 1},
+        {"vt 3", QByteArray(triangle) + "vt 0 1 0\nvt 1 1\nf 1/1/ 2/1/ 3/1/\n", 1},
+        {"tabs and exponents", "v\t1e0 0 0.\nv 0\t1.0E+0 0\nv .0e1 0 1\nf\t1 2\t3\n", 1},
+        {"unsupported numeric", QByteArray("g 1\ns 1\n") + triangle + "usemtl 2\nf 1 2 3\n", 1},
+        {"unsupported names", QByteArray("o cube\n") + triangle + "f 1 2 3\n", 0},
+        {"mixed triplets", QByteArray(triangle) + "vn 0 0 1\nf 1//1 2// 3//1\n", 0},
+        {"no final newline", QByteArray(triangle) + "f 1 2 3", 1},
+        {"syntax error", QByteArray(triangle) + "f 1 2 x\n", 0},
+    };
+    for (const Input& input: inputs) {
+        QString path = mDir.filePath(QString(input.name).replace(' ', '_') + ".obj");
+        QFile file(path);
+        QVERIFY(file.open(QFile::WriteOnly));
+        file.write(input.text);
+        QTest::newRow(input.name) << path << input.fast;
+    }
+}
+
+// the hand written reader gives the model of the grammar
+void TestModelStore::reader() {
+    QFETCH(QString, path);
+    QFETCH(int, fast);
+
+    if (fast >= 0) {
+        QFile file(path);
+        QVERIFY(file.open(QFile::ReadOnly));
+        QByteArray bytes = file.readAll();
+        Demo::WF::ObjReader reader;
+        QCOMPARE(int(reader.read(bytes.constData(), bytes.size())), fast);
+    }
+
+    Loader objReader;
+    Loader grammar;
+    grammar.setReader(false);
+    bool parsed = parse(objReader, path);
+    QCOMPARE(parse(grammar, path), parsed);
+    if (!parsed) return;
+
+    QCOMPARE(objReader.triangles(), grammar.triangles());
+    QCOMPARE(objReader.wireframe(), grammar.wireframe());
+    auto& a = objReader.vertexData();
+    auto& b = grammar.vertexData();
+    QCOMPARE(a.size(), b.size());
+    for (int i = 0; i < a.size(); i++) {
+        QVERIFY2(a[i].vertex == b[i].vertex && a[i].normal == b[i].normal && a[i].tex == b[i].tex,
+                 qPrintable(QString("vertex %1").arg(i)));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestModelStore)
+
+#include "tst_modelstore.moc"
@@ -0,0 +1,5 @@
+# Unit tests: qmake && make check
+
+TEMPLATE = subdirs
+
+SUBDIRS = mesh modelstore
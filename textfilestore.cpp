@@ -9,6 +9,8 @@ public:
     TextSource(TextFileStore* p);
     const QVariant& execute(const QVector<QVariant>& vals, int start) override;
     TextSource* clone() const override;
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
 private:
     TextFileStore* mParent;
 };
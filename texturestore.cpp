@@ -39,6 +39,8 @@ public:
     TextureSource(TextureStore* p);
     const QVariant& execute(const QVector<QVariant>& vals, int start) override;
     TextureSource* clone() const override;
+    bool glFree() const override {return false;}
+    bool replayable() const override {return false;}
 private:
     TextureStore* mParent;
 };
@@ -72,6 +74,7 @@ uint TextureStore::texture(const QString& key) {
     tidyUp(); // delete dangling textures
     if (mTextures.contains(key)) {
         if (mTextures[key] == 0) {
+            mTarget->glCalled();
             mTextures[key] = load_ktx(mFileNames[mNames.indexOf(key)]);
         }
         return mTextures[key];
@@ -100,7 +103,7 @@ void TextureStore::tidyUp(GLuint tex) {
         mRemovableTextures.append(tex);
     }
     if (mTarget->initialized() && !mRemovableTextures.isEmpty()) {
-        mTarget->glDeleteTextures(mRemovableTextures.size(), mRemovableTextures.constData());
+        mTarget->backend()->glDeleteTextures(mRemovableTextures.size(), mRemovableTextures.constData());
         mRemovableTextures.clear();
     }
 }
@@ -207,8 +210,8 @@ static quint32 calculate_face_size(const header& h)
 
 
 #define ALT(item) case item: qCWarning(OGL) << #item; throw KtxError(#item); break
-static void checkError() {
-    switch (glGetError()) {
+static void checkError(GL::Backend* backend) {
+    switch (backend->glGetError()) {
     ALT(GL_INVALID_ENUM);
     ALT(GL_INVALID_VALUE);
     ALT(GL_INVALID_OPERATION);
@@ -299,10 +302,10 @@ uint TextureStore::load_ktx(const QString& path) const {
     }
 
     GLuint tex = 0;
-    mTarget->glGenTextures(1, &tex);
-    checkError();
-    mTarget->glBindTexture(target, tex);
-    checkError();
+    mTarget->backend()->glGenTextures(1, &tex);
+    checkError(mTarget->backend());
+    mTarget->backend()->glBindTexture(target, tex);
+    checkError(mTarget->backend());
 
     file.seek(file.pos() + h.keypairbytes);
     auto bytes = file.readAll();
@@ -316,27 +319,27 @@ uint TextureStore::load_ktx(const QString& path) const {
 
     switch (target) {
     case GL_TEXTURE_1D:
-        mTarget->glTexStorage1D(GL_TEXTURE_1D, h.miplevels, h.glinternalformat, h.pixelwidth);
-        checkError();
-        mTarget->glTexSubImage1D(GL_TEXTURE_1D, 0, 0, h.pixelwidth, h.glformat, h.glinternalformat, data);
-        checkError();
+        mTarget->backend()->glTexStorage1D(GL_TEXTURE_1D, h.miplevels, h.glinternalformat, h.pixelwidth);
+        checkError(mTarget->backend());
+        mTarget->backend()->glTexSubImage1D(GL_TEXTURE_1D, 0, 0, h.pixelwidth, h.glformat, h.glinternalformat, data);
+        checkError(mTarget->backend());
         break;
     case GL_TEXTURE_2D:
         if (h.gltype == GL_NONE) {
-            mTarget->glCompressedTexImage2D(GL_TEXTURE_2D, 0, h.glinternalformat, h.pixelwidth, h.pixelheight, 0, 420 * 380 / 2, data);
-            checkError();
+            mTarget->backend()->glCompressedTexImage2D(GL_TEXTURE_2D, 0, h.glinternalformat, h.pixelwidth, h.pixelheight, 0, 420 * 380 / 2, data);
+            checkError(mTarget->backend());
         } else {
-            mTarget->glTexStorage2D(GL_TEXTURE_2D, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight);
-            checkError();
+            mTarget->backend()->glTexStorage2D(GL_TEXTURE_2D, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight);
+            checkError(mTarget->backend());
             {
                 const char * ptr = data;
                 uint height = h.pixelheight;
                 uint width = h.pixelwidth;
-                mTarget->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-                checkError();
+                mTarget->backend()->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                checkError(mTarget->backend());
                 for (uint i = 0; i < h.miplevels; i++) {
-                    mTarget->glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, h.glformat, h.gltype, ptr);
-                    checkError();
+                    mTarget->backend()->glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, h.glformat, h.gltype, ptr);
+                    checkError(mTarget->backend());
                     ptr += height * calculate_stride(h, width, 1);
                     height >>= 1;
                     width >>= 1;
@@ -347,47 +350,47 @@ uint TextureStore::load_ktx(const QString& path) const {
         }
         break;
     case GL_TEXTURE_3D:
-        mTarget->glTexStorage3D(GL_TEXTURE_3D, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.pixeldepth);
-        checkError();
-        mTarget->glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.pixeldepth, h.glformat, h.gltype, data);
-        checkError();
+        mTarget->backend()->glTexStorage3D(GL_TEXTURE_3D, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.pixeldepth);
+        checkError(mTarget->backend());
+        mTarget->backend()->glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.pixeldepth, h.glformat, h.gltype, data);
+        checkError(mTarget->backend());
         break;
     case GL_TEXTURE_1D_ARRAY:
-        mTarget->glTexStorage2D(GL_TEXTURE_1D_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.arrayelements);
-        checkError();
-        mTarget->glTexSubImage2D(GL_TEXTURE_1D_ARRAY, 0, 0, 0, h.pixelwidth, h.arrayelements, h.glformat, h.gltype, data);
-        checkError();
+        mTarget->backend()->glTexStorage2D(GL_TEXTURE_1D_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.arrayelements);
+        checkError(mTarget->backend());
+        mTarget->backend()->glTexSubImage2D(GL_TEXTURE_1D_ARRAY, 0, 0, 0, h.pixelwidth, h.arrayelements, h.glformat, h.gltype, data);
+        checkError(mTarget->backend());
         break;
     case GL_TEXTURE_2D_ARRAY:
-        mTarget->glTexStorage3D(GL_TEXTURE_2D_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.arrayelements);
-        checkError();
-        mTarget->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.arrayelements, h.glformat, h.gltype, data);
-        checkError();
+        mTarget->backend()->glTexStorage3D(GL_TEXTURE_2D_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.arrayelements);
+        checkError(mTarget->backend());
+        mTarget->backend()->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.arrayelements, h.glformat, h.gltype, data);
+        checkError(mTarget->backend());
         break;
     case GL_TEXTURE_CUBE_MAP:
-        mTarget->glTexStorage2D(GL_TEXTURE_CUBE_MAP, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight);
-        checkError();
+        mTarget->backend()->glTexStorage2D(GL_TEXTURE_CUBE_MAP, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight);
+        checkError(mTarget->backend());
         {
             uint face_size = calculate_face_size(h);
             for (uint i = 0; i < h.faces; i++) {
-                mTarget->glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, h.pixelwidth, h.pixelheight, h.glformat, h.gltype, data + face_size * i);
-                checkError();
+                mTarget->backend()->glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, h.pixelwidth, h.pixelheight, h.glformat, h.gltype, data + face_size * i);
+                checkError(mTarget->backend());
             }
         }
         break;
     case GL_TEXTURE_CUBE_MAP_ARRAY:
-        mTarget->glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.arrayelements);
-        checkError();
-        mTarget->glTexSubImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.faces * h.arrayelements, h.glformat, h.gltype, data);
-        checkError();
+        mTarget->backend()->glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, h.miplevels, h.glinternalformat, h.pixelwidth, h.pixelheight, h.arrayelements);
+        checkError(mTarget->backend());
+        mTarget->backend()->glTexSubImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, 0, 0, 0, h.pixelwidth, h.pixelheight, h.faces * h.arrayelements, h.glformat, h.gltype, data);
+        checkError(mTarget->backend());
         break;
     default: // Should never happen
         throw KtxError("Unknown texture target");
     }
 
     if (h.miplevels == 1) {
-        mTarget->glGenerateMipmap(target);
-        checkError();
+        mTarget->backend()->glGenerateMipmap(target);
+        checkError(mTarget->backend());
     }
 
     return tex;
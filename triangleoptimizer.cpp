@@ -31,37 +31,74 @@ are met:
 
 using namespace AC;
 
+const uint TriangleOptimizer::None;
 
 TriangleOptimizer::TriangleOptimizer(const IndexVector& triangles)
-    : mHonorWinding(true)
-    , mVertexCount(0)
+    : mMinBin(0)
+    , mHonorWinding(true)
+    , mForwardWinding(true)
 {
+    int numTriangles = triangles.size() / 3;
+    int numCorners = 3 * numTriangles;
+    if (numTriangles == 0) return;
+    const uint* tri = triangles.constData();
+
     // find largest vertex index
     uint mx = 0;
-    for (auto v: triangles) {
-        if (v > mx) mx = v;
+    for (int i = 0; i < numCorners; i++) {
+        if (tri[i] > mx) mx = tri[i];
+    }
+
+    // valences: a vertex starts at most one edge per triangle
+    mCount = IndexVector(mx + 1, 0);
+    for (int i = 0; i < numCorners; i++) {
+        mCount[tri[i]]++;
+    }
+    mEdgeBegin = IndexVector(mx + 1);
+    mEdgeEnd = IndexVector(mx + 1);
+    uint offset = 0;
+    for (uint v = 0; v <= mx; v++) {
+        mEdgeBegin[v] = mEdgeEnd[v] = offset;
+        offset += mCount[v];
     }
 
-    // init vertices and edges
-    mVertices = VertexVector(mx + 1, nullptr);
-    // qCDebug(OGL) << "Last Vertex index" << mVertices.size() - 1;
-    for (int t = 0; t < triangles.size() / 3; t++) {
-        addTriangle(triangles[3*t], triangles[3*t+1], triangles[3*t+2]);
+    // init edges
+    mEdgeVertex = IndexVector(numCorners);
+    mEdgeCount = IndexVector(numCorners, 0);
+    IndexVector cornerEdges(numCorners);
+    for (int t = 0; t < numTriangles; t++) {
+        uint v1 = tri[3*t], v2 = tri[3*t+1], v3 = tri[3*t+2];
+        cornerEdges[3*t] = mapVertexEdge(v1, v3);
+        cornerEdges[3*t+1] = mapVertexEdge(v3, v2);
+        cornerEdges[3*t+2] = mapVertexEdge(v2, v1);
+    }
+
+    // init triangles of the edges
+    mTriangleBegin = IndexVector(numCorners);
+    mTriangleEnd = IndexVector(numCorners);
+    offset = 0;
+    for (int e = 0; e < numCorners; e++) {
+        mTriangleBegin[e] = mTriangleEnd[e] = offset;
+        offset += mEdgeCount[e];
+    }
+    mFinalVertex = IndexVector(numCorners);
+    for (int t = 0; t < numTriangles; t++) {
+        mFinalVertex[mTriangleEnd[cornerEdges[3*t]]++] = tri[3*t+1];
+        mFinalVertex[mTriangleEnd[cornerEdges[3*t+1]]++] = tri[3*t];
+        mFinalVertex[mTriangleEnd[cornerEdges[3*t+2]]++] = tri[3*t+2];
     }
 
     // init bins
-    for (Vertex* v: qAsConst(mVertices)) {
-        if (!v) continue;
-        if (!mVertexBins.contains(v->count)) {
-            v->next = nullptr;
-            v->prev = nullptr;
-            mVertexBins[v->count] = v;
-        } else {
-            v->next = mVertexBins[v->count];
-            v->prev = nullptr;
-            mVertexBins[v->count] = v;
-            v->next->prev = v;
-        }
+    uint maxCount = 0;
+    for (uint c: qAsConst(mCount)) {
+        if (c > maxCount) maxCount = c;
+    }
+    mBins = IndexVector(maxCount + 1, None);
+    mMinBin = mBins.size();
+    mPrev = IndexVector(mx + 1, None);
+    mNext = IndexVector(mx + 1, None);
+    for (uint v = 0; v <= mx; v++) {
+        if (mCount[v] > 0) insertBin(v);
     }
 
     uint v1, v2;
@@ -82,105 +119,66 @@ TriangleOptimizer::TriangleOptimizer(const IndexVector& triangles)
 }
 
 
-void TriangleOptimizer::addTriangle(uint v1, uint v2, uint v3)
-{
-    Vertex* vertexRec1 = incVertexValence(v1);
-    Vertex* vertexRec2 = incVertexValence(v3);
-    Vertex* vertexRec3 = incVertexValence(v2);
-
-    Edge* edge12 = mapVertexEdge(vertexRec1, vertexRec2);
-    Edge* edge23 = mapVertexEdge(vertexRec2, vertexRec3);
-    Edge* edge31 = mapVertexEdge(vertexRec3, vertexRec1);
-
-    mapEdgeTriangle(edge12, vertexRec3);
-    mapEdgeTriangle(edge23, vertexRec1);
-    mapEdgeTriangle(edge31, vertexRec2);
-}
-
-
-TriangleOptimizer::Vertex* TriangleOptimizer::incVertexValence(uint v)
-{
-
-    if (!mVertices[v]) {
-        mVertices[v] = new Vertex;
-        // qCDebug(OGL) << "created" << mVertices[v]->index << mVertices[v]->count;
-    }
-
-    Vertex *vertex = mVertices[v];
-    // qCDebug(OGL) << vertex->index << vertex->count;
-
-    vertex->count++;
-
-    if (vertex->count == 1) {
-        vertex->index = v;
-        mVertexCount++;
-    }
-
-    return vertex;
-}
-
-TriangleOptimizer::Edge* TriangleOptimizer::mapVertexEdge(Vertex *v1, Vertex *v2)
+uint TriangleOptimizer::mapVertexEdge(uint v1, uint v2)
 {
-    for (Edge* e: qAsConst(v1->edges)) {
-        if (e->vertices.second == v2) {
-            e->count++;
+    for (uint e = mEdgeBegin[v1]; e < mEdgeEnd[v1]; e++) {
+        if (mEdgeVertex[e] == v2) {
+            mEdgeCount[e]++;
             return e;
         }
     }
 
-    Edge* e = new Edge;
-
-    e->count = 1;
-    e->vertices = VertexPair(v1, v2);
-
-    v1->edges.append(e);
+    uint e = mEdgeEnd[v1]++;
+    mEdgeVertex[e] = v2;
+    mEdgeCount[e] = 1;
 
     return e;
 }
 
-void TriangleOptimizer::mapEdgeTriangle(Edge *e12, Vertex *v3) {
-    Triangle* t = new Triangle;
-    t->finalVertex = v3;
-    e12->triangles.append(t);
-}
-
 bool TriangleOptimizer::startNextStrip(uint& v1Return, uint& v2Return) {
-    Vertex *v1 = findNextStripVertex();
-    if (!v1) return false;
+    uint v1 = findNextStripVertex();
+    if (v1 == None) return false;
 
-    // qCDebug(OGL) << "start new strip with" << v1->index;
+    // qCDebug(OGL) << "start new strip with" << v1;
     mForwardWinding = true;
 
-    v1Return = v1->index;
-    v2Return = v1->edges.first()->vertices.second->index;
+    // first remaining edge
+    uint e = mEdgeBegin[v1];
+    while (e < mEdgeEnd[v1] && mEdgeCount[e] == 0) e++;
+    mEdgeBegin[v1] = e;
+    if (e == mEdgeEnd[v1]) return false;
+
+    v1Return = v1;
+    v2Return = mEdgeVertex[e];
 
     return true;
 }
 
-TriangleOptimizer::Vertex* TriangleOptimizer::findNextStripVertex()
+uint TriangleOptimizer::findNextStripVertex()
 {
-    if (mVertexBins.isEmpty()) return nullptr;
-    Vertex* v = mVertexBins.first();
-    // qCDebug(OGL) << v->index << v->count;
-    return v;
+    uint size = mBins.size();
+    while (mMinBin < size && mBins[mMinBin] == None) mMinBin++;
+    if (mMinBin == size) return None;
+    return mBins[mMinBin];
 }
 
 
 bool TriangleOptimizer::getNextVert(uint v1, uint v2, uint& v3) {
 
-    Edge *edge;
     bool foundReversed = false;
 
-    if (!findEdge(v1, v2, &edge)) {
+    uint edge = findEdge(v1, v2);
+    if (edge == None) {
         if (mHonorWinding) return false;
-        if (!findEdge(v2, v1, &edge)) {
-            return false;
-        }
+        edge = findEdge(v2, v1);
+        if (edge == None) return false;
         foundReversed = true;
     }
 
-    v3 = edge->triangles.last()->finalVertex->index;
-    // qCDebug(OGL) << "num triangles " << edge->triangles.size();
+    // last remaining triangle
+    uint& end = mTriangleEnd[edge];
+    while (mFinalVertex[end - 1] == None) end--;
+    v3 = mFinalVertex[end - 1];
 
     if (foundReversed) {
         uint tmp = v2;
@@ -203,125 +201,70 @@ bool TriangleOptimizer::getNextVert(uint v1, uint v2, uint& v3) {
 
 }
 
-bool TriangleOptimizer::findEdge(uint v1, uint v2, Edge **edge)
+uint TriangleOptimizer::findEdge(uint v1, uint v2) const
 {
+    if (mCount[v1] == 0 || mCount[v2] == 0) return None;
 
-    Vertex* V1 = mVertices[v1];
-    if (!V1) return false;
-
-    Vertex* V2 = mVertices[v2];
-    if (!V2) return false;
-
-    for (Edge* e: qAsConst(V1->edges)) {
-        if (e->vertices.second == V2) {
-            *edge = e;
-            return true;
-        }
+    for (uint e = mEdgeBegin[v1]; e < mEdgeEnd[v1]; e++) {
+        if (mEdgeVertex[e] == v2 && mEdgeCount[e] > 0) return e;
     }
 
-    return false;
+    return None;
 }
 
-void TriangleOptimizer::unmapEdgeTriangle(Edge* e12, uint v3) {
-
-    Vertex* V3 = mVertices[v3];
-    if (!V3) return;
+void TriangleOptimizer::unmapEdgeTriangle(uint e12, uint v3) {
 
-    Triangle* t0 = nullptr;
+    if (mCount[v3] == 0) return;
 
-    for (Triangle* t: qAsConst(e12->triangles)) {
-        if (t->finalVertex == V3) {
-            t0 = t;
+    for (uint t = mTriangleBegin[e12]; t < mTriangleEnd[e12]; t++) {
+        if (mFinalVertex[t] == v3) {
+            mFinalVertex[t] = None;
             break;
         }
     }
-
-    if (t0) {
-        e12->triangles.removeOne(t0);
-        delete t0;
-    }
 }
 
 
 void TriangleOptimizer::unmapEdgeTriangleByVerts(uint v1, uint v2, uint v3) {
-    Edge *e;
-
-    if (findEdge(v1, v2, &e)) {
+    uint e = findEdge(v1, v2);
+    if (e != None) {
         unmapEdgeTriangle(e, v3);
     }
 }
 
 void TriangleOptimizer::unmapVertexEdge(uint v1, uint v2) {
-
-    Vertex* V1 = mVertices[v1];
-    if (!V1) return;
-
-    Vertex* V2 = mVertices[v2];
-    if (!V2) return;
-
-
-    Edge* e0 = nullptr;
-
-    for (Edge* e: qAsConst(V1->edges)) {
-        if (e->vertices.second == V2) {
-            e0 = e;
-            break;
-        }
-    }
-
-    if (e0) {
-        e0->count--;
-        if (e0->count == 0) {
-            qDeleteAll(e0->triangles);
-            V1->edges.removeOne(e0);
-            delete e0;
-        }
+    uint e = findEdge(v1, v2);
+    if (e != None) {
+        mEdgeCount[e]--;
     }
 }
 
 void TriangleOptimizer::decVertexValence(uint v) {
-    Vertex* V = mVertices[v];
-    if (!V) return;
+    if (mCount[v] == 0) return;
 
-    if (!V->prev) {
+    if (mPrev[v] == None) {
         // first
-        mVertexBins[V->count] = V->next;
-        if (!V->next) {
-            // last vertex in the bin - remove the bin
-            mVertexBins.remove(V->count);
-        }
+        mBins[mCount[v]] = mNext[v];
     } else {
         // not first
-        // qCDebug(OGL) << "still left in bin" << V->count << ": " << V->prev->index;
-        V->prev->next = V->next;
+        mNext[mPrev[v]] = mNext[v];
     }
 
-    if (V->next) { // not last
-        // qCDebug(OGL) << "still left in bin" << V->count << ": " << V->next->index;
-        V->next->prev = V->prev;
+    if (mNext[v] != None) { // not last
+        mPrev[mNext[v]] = mPrev[v];
     }
 
+    mCount[v]--;
 
-    V->count--;
-
-    if (V->count == 0) {
-        mVertexCount--;
-        qDeleteAll(V->edges);
-        delete V;
-        mVertices[v] = nullptr;
-    } else {
-        if (!mVertexBins.contains(V->count)) {
-            V->next = nullptr;
-            V->prev = nullptr;
-            mVertexBins[V->count] = V;
-        } else {
-            V->next = mVertexBins[V->count];
-            V->prev = nullptr;
-            mVertexBins[V->count] = V;
-            V->next->prev = V;
-        }
-    }
+    if (mCount[v] > 0) insertBin(v);
 }
 
-
-
+// to the front of the bin of its valence
+void TriangleOptimizer::insertBin(uint v) {
+    uint c = mCount[v];
+    mPrev[v] = None;
+    mNext[v] = mBins[c];
+    if (mNext[v] != None) mPrev[mNext[v]] = v;
+    mBins[c] = v;
+    if (c < mMinBin) mMinBin = c;
+}
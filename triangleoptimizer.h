@@ -29,8 +29,6 @@ are met:
 #define TRIANGLE_OPTIMIZER_H
 
 #include <QVector>
-#include <QPair>
-#include <QMap>
 
 namespace AC {
 
@@ -47,87 +45,53 @@ public:
 
 private:
 
-    class Vertex;
-
-    class Triangle {
-    public:
-        Triangle()
-            : finalVertex(nullptr) {}
-        Vertex* finalVertex;
-    };
-
-    using TriangleVector = QVector<Triangle*>;
-    using VertexPair = QPair<Vertex*, Vertex*>;
-
-    class Edge {
-    public:
-        Edge()
-            : vertices()
-            , triangles()
-            , count(0) {}
-        VertexPair vertices;
-        TriangleVector triangles;
-        int count;
-    };
-
-    using EdgeVector = QVector<Edge*>;
-
-    class Vertex {
-    public:
-        Vertex()
-            : index(0)
-            , count(0)
-            , prev(nullptr)
-            , next(nullptr)
-            , edges() {}
-        uint index;
-        int count;
-        Vertex* prev;
-        Vertex* next;
-        EdgeVector edges;
-    };
-
-    using VertexMap = QMap<uint, Vertex*>;
-    using VertexVector = QVector<Vertex*>;
+    static const uint None = ~0u;
 
-private:
-
-    void addTriangle(uint v1, uint v2, uint v3);
     bool startNextStrip(uint& v1Return, uint& v2Return);
     bool getNextVert(uint v1, uint v2, uint& v3);
 
-    Vertex* incVertexValence(uint v);
-    Edge* mapVertexEdge(Vertex* v1, Vertex* v2);
-    void mapEdgeTriangle(Edge* e12, Vertex* v3);
-    Vertex* findNextStripVertex();
-    bool findEdge(uint v1, uint v2, Edge** e);
-    void unmapEdgeTriangle(Edge* e12, uint v3);
+    uint mapVertexEdge(uint v1, uint v2);
+    uint findNextStripVertex();
+    uint findEdge(uint v1, uint v2) const;
+    void unmapEdgeTriangle(uint e12, uint v3);
     void unmapEdgeTriangleByVerts(uint v1, uint v2, uint v3);
     void unmapVertexEdge(uint v1, uint v2);
     void decVertexValence(uint v);
-
-
-
+    void insertBin(uint v);
 
 private:
 
-    // input
-    VertexVector mVertices;
+    // Flat arrays instead of linked records, allocated once in the
+    // constructor. Vertices are indexed by the input indices. The
+    // directed edges of a vertex and the triangles of an edge are
+    // contiguous ranges in creation order; an edge or a triangle is
+    // removed by zeroing its count or its slot.
 
-    bool mHonorWinding;
-    uint mVertexCount;
+    // per vertex: valence, bin links, edge range
+    IndexVector mCount;
+    IndexVector mPrev;
+    IndexVector mNext;
+    IndexVector mEdgeBegin;
+    IndexVector mEdgeEnd;
 
-    // output
-    StripVector mStrips;
+    // per edge: end vertex, number of triangles, triangle range
+    IndexVector mEdgeVertex;
+    IndexVector mEdgeCount;
+    IndexVector mTriangleBegin;
+    IndexVector mTriangleEnd;
 
-    /* vertex and edge database */
-    VertexMap mVertexBins;
+    // per triangle slot: the vertex opposite to the edge, None if removed
+    IndexVector mFinalVertex;
 
+    // bin heads by valence, lowest nonempty bin at or above mMinBin
+    IndexVector mBins;
+    uint mMinBin;
 
+    bool mHonorWinding;
     bool mForwardWinding;
 
-
-
+    // output
+    StripVector mStrips;
 };
 
 
@@ -135,4 +99,3 @@ private:
 } // namespace AC
 
 #endif
-
@@ -8,6 +8,7 @@ const int Type::Real = qMetaTypeId<Math3D::Real>();
 const int Type::Text = qMetaTypeId<QString>();
 const int Type::Matrix = qMetaTypeId<Math3D::Matrix4>();
 const int Type::Vector = qMetaTypeId<Math3D::Vector4>();
+const int Type::Quaternion = qMetaTypeId<Math3D::Quaternion>();
 
 bool Type::assignable(const Type* rhs) const {
     if (rhs->id() == 0) return true; // null type
@@ -35,6 +35,7 @@ public:
     static const int Real;
     static const int Vector;
     static const int Matrix;
+    static const int Quaternion;
     static const int Text;
 
     virtual bool assignable(const Type* rhs) const;
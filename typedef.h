@@ -32,6 +32,7 @@ using Real_T = BaseType<Math3D::Real>;
 using Integer_T = BaseType<Math3D::Integer>;
 using Vector_T = BaseType<Math3D::Vector4>;
 using Matrix_T = BaseType<Math3D::Matrix4>;
+using Quaternion_T = BaseType<Math3D::Quaternion>;
 using Text_T = BaseType<QString>;
 
 
@@ -59,6 +60,7 @@ public:
         contents.append(new Typedef("Natural", new Integer_T));
         contents.append(new Typedef("Vector", new Vector_T));
         contents.append(new Typedef("Matrix", new Matrix_T));
+        contents.append(new Typedef("Quaternion", new Quaternion_T));
         contents.append(new Typedef("Text", new Text_T));
     }
 };
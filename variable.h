@@ -44,6 +44,10 @@ public:
     void setIndex(unsigned idx) {mIndex = idx;}
     virtual bool shared() const = 0;
 
+    // raw value access for moving state between program instances
+    virtual const Value* storage() const = 0;
+    virtual void restore(const Value* v) = 0;
+
     Variable* clone() const override = 0;
 
     ~Variable() override = default;
@@ -63,6 +67,9 @@ public:
     LocalVar(QString name, Type* type)
         : Variable(name, type)
         , mValue(Value::Create(type)) {}
+    LocalVar(QString name, Type* type, Value* value)
+        : Variable(name, type)
+        , mValue(value) {}
     LocalVar(const LocalVar& v)
         : Variable(v.name(), v.type()->clone())
         , mValue(v.mValue->clone()) {}
@@ -74,6 +81,14 @@ public:
 
     bool shared() const override {return false;}
 
+    const Value* storage() const override {return mValue;}
+    void restore(const Value* v) override {
+        delete mValue;
+        mValue = v->clone();
+    }
+
+    ~LocalVar() override {delete mValue;}
+
 protected:
 
     Value* mValue;
@@ -103,6 +118,16 @@ public:
 
     bool shared() const override {return true;}
 
+    // Double buffering for scripts running in a worker thread: the worker
+    // reads and writes a private snapshot, which is committed between frames.
+    LocalVar* snapshot() const {return new LocalVar(name(), type()->clone(), d->value->clone());}
+
+    const Value* storage() const override {return d->value;}
+    void restore(const Value* v) override {
+        delete d->value;
+        d->value = v->clone();
+    }
+
 protected:
     QExplicitlySharedDataPointer<SharedData> d;
 };
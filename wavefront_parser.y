@@ -20,7 +20,7 @@ using Demo::GL::ModelStore;
 %define api.pure full
 %define api.value.type {Demo::WF::ValueType}
 
-%parse-param {Demo::GL::ModelStore* models}
+%parse-param {Demo::GL::ModelStore::Loader* models}
 %parse-param {yyscan_t scanner}
 %lex-param {yyscan_t scanner}
 